@@ -1,5 +1,6 @@
 
 #include "cube.h"
+#include "gl_stats.h"
 
 
 
@@ -89,7 +90,7 @@ InitShader(const char* vShaderFile, const char* fShaderFile)
     }
 
     /* use program object */
-    glUseProgram(program);
+    glsUseProgram(program);
 
     return program;
 }
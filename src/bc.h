@@ -0,0 +1,57 @@
+#pragma once
+#include <stddef.h>
+
+// Block-compressed (BCn) texture formats. Every format stores 4x4 texel
+// blocks; BC1 uses 8 bytes per block, BC3 and BC7 use 16.
+enum BCFormat {
+    BC_FORMAT_NONE = 0,
+    BC_FORMAT_BC1,      // RGB + 1-bit alpha, 4 bpp
+    BC_FORMAT_BC3,      // RGB + interpolated alpha, 8 bpp
+    BC_FORMAT_BC7       // high-quality RGBA, 8 bpp
+};
+
+inline int bcBlockBytes(BCFormat f)
+{
+    return f == BC_FORMAT_BC1 ? 8 : 16;
+}
+
+// Bytes needed for one w x h level (partial blocks are padded out to 4x4)
+inline size_t bcLevelSize(BCFormat f, int width, int height)
+{
+    size_t bw = (size_t)(width > 0 ? (width + 3) / 4 : 1);
+    size_t bh = (size_t)(height > 0 ? (height + 3) / 4 : 1);
+    return bw * bh * bcBlockBytes(f);
+}
+
+// ---------- Decoding (bcdecode.cpp) ----------
+
+// Decode one block into 16 RGBA8 texels, row-major.
+void bcDecodeBlock(BCFormat f, const unsigned char* block, unsigned char rgba[64]);
+
+// Decode a whole level into tightly packed RGBA8 (width*height*4 bytes).
+void bcDecodeImage(BCFormat f, const unsigned char* blocks, int width, int height,
+                   unsigned char* rgba);
+
+// BC7 two-subset partition masks (bit i = texel i is in subset 1) and the
+// anchor texel of subset 1, shared by the decoder and the encoder.
+extern const unsigned short g_bc7Partition2[64];
+extern const unsigned char g_bc7Anchor2[64];
+
+// ---------- Encoding (bcencode.cpp) ----------
+
+enum BCQuality {
+    BC_QUALITY_FAST,    // bounding-box endpoints, no refinement
+    BC_QUALITY_NORMAL,  // principal-axis endpoints + one least-squares pass
+    BC_QUALITY_BEST     // both starts, more refinement, all p-bit combinations, BC7 mode 1 search
+};
+
+// Encode 16 RGBA8 texels (row-major) into one block. Only the texels in
+// valid (bit i = texel i) count toward the error the encoder minimizes.
+void bcEncodeBlock(BCFormat f, const unsigned char rgba[64], unsigned char* block, BCQuality q,
+                   unsigned int valid = 0xFFFF);
+
+// Encode a tightly packed RGBA8 level; partial edge blocks repeat the last
+// row/column, which is left out of their valid mask. Block rows are
+// distributed over threads (<= 0: all cores).
+void bcEncodeImage(BCFormat f, const unsigned char* rgba, int width, int height,
+                   unsigned char* blocks, BCQuality q, int threads = 0);
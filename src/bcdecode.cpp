@@ -0,0 +1,280 @@
+#include "bc.h"
+#include <string.h>
+
+// CPU decoders for BC1/BC3/BC7, used when the driver cannot sample a
+// compressed format directly. Follows the D3D11 block layouts.
+
+// ---------- BC1 / BC3 ----------
+static inline void unpack565(unsigned int c, unsigned char out[4])
+{
+    unsigned int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+    out[0] = (unsigned char)((r << 3) | (r >> 2));
+    out[1] = (unsigned char)((g << 2) | (g >> 4));
+    out[2] = (unsigned char)((b << 3) | (b >> 2));
+    out[3] = 255;
+}
+
+// forceFourColor: BC2/BC3 color blocks always use the 4-color palette
+static void decodeColorBlock(const unsigned char* b, unsigned char rgba[64], bool forceFourColor)
+{
+    unsigned int c0 = b[0] | (b[1] << 8), c1 = b[2] | (b[3] << 8);
+    unsigned char pal[4][4];
+    unpack565(c0, pal[0]);
+    unpack565(c1, pal[1]);
+    if (c0 > c1 || forceFourColor) {
+        for (int i = 0; i < 3; i++) {
+            pal[2][i] = (unsigned char)((2 * pal[0][i] + pal[1][i]) / 3);
+            pal[3][i] = (unsigned char)((pal[0][i] + 2 * pal[1][i]) / 3);
+        }
+        pal[2][3] = pal[3][3] = 255;
+    }
+    else {
+        for (int i = 0; i < 3; i++) pal[2][i] = (unsigned char)((pal[0][i] + pal[1][i]) / 2);
+        pal[2][3] = 255;
+        pal[3][0] = pal[3][1] = pal[3][2] = pal[3][3] = 0;
+    }
+    unsigned int idx = b[4] | (b[5] << 8) | (b[6] << 16) | ((unsigned int)b[7] << 24);
+    for (int i = 0; i < 16; i++, idx >>= 2)
+        memcpy(rgba + i * 4, pal[idx & 3], 4);
+}
+
+static void decodeAlphaBlock(const unsigned char* b, unsigned char rgba[64])
+{
+    unsigned char pal[8];
+    pal[0] = b[0];
+    pal[1] = b[1];
+    if (pal[0] > pal[1]) {
+        for (int i = 1; i < 7; i++) pal[i + 1] = (unsigned char)((pal[0] * (7 - i) + pal[1] * i) / 7);
+    }
+    else {
+        for (int i = 1; i < 5; i++) pal[i + 1] = (unsigned char)((pal[0] * (5 - i) + pal[1] * i) / 5);
+        pal[6] = 0;
+        pal[7] = 255;
+    }
+    unsigned long long idx = 0;
+    for (int i = 0; i < 6; i++) idx |= (unsigned long long)b[2 + i] << (8 * i);
+    for (int i = 0; i < 16; i++, idx >>= 3)
+        rgba[i * 4 + 3] = pal[idx & 7];
+}
+
+// ---------- BC7 ----------
+struct BC7Mode {
+    int subsets, partitionBits, rotationBits, indexSelBits;
+    int colorBits, alphaBits, endpointPBits, sharedPBits;
+    int indexBits, index2Bits;
+};
+
+static const BC7Mode kBC7Modes[8] = {
+    { 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+    { 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+    { 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+    { 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+    { 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+    { 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+    { 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+    { 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+};
+
+// Two-subset partitions: bit i set = texel i belongs to subset 1
+const unsigned short g_bc7Partition2[64] = {
+    0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+    0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+    0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+    0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+    0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+    0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+    0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+    0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+};
+
+// Three-subset partitions: 2 bits per texel, texel 0 in the low bits
+static const unsigned int kPartition3[64] = {
+    0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+    0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+    0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+    0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+    0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+    0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+    0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+    0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254,
+};
+
+// Anchor texels (stored with one index bit less) of subsets 1 and 2
+const unsigned char g_bc7Anchor2[64] = {
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+    15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+     6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+};
+
+static const unsigned char kAnchor3a[64] = {
+     3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+     3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+     8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+     3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+};
+
+static const unsigned char kAnchor3b[64] = {
+    15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+    15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+    15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+    15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+};
+
+static const unsigned char kWeights2[4] = { 0, 21, 43, 64 };
+static const unsigned char kWeights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static const unsigned char kWeights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct BitReader {
+    const unsigned char* data;
+    int pos;
+    unsigned int read(int count)
+    {
+        unsigned int v = 0;
+        for (int i = 0; i < count; i++, pos++)
+            v |= (unsigned int)((data[pos >> 3] >> (pos & 7)) & 1) << i;
+        return v;
+    }
+};
+
+static inline const unsigned char* weightsFor(int bits)
+{
+    return bits == 2 ? kWeights2 : (bits == 3 ? kWeights3 : kWeights4);
+}
+
+static inline unsigned char interpolate(int e0, int e1, int w)
+{
+    return (unsigned char)(((64 - w) * e0 + w * e1 + 32) >> 6);
+}
+
+static inline int bc7Subset(int subsets, int partition, int texel)
+{
+    if (subsets == 2) return (g_bc7Partition2[partition] >> texel) & 1;
+    if (subsets == 3) return (kPartition3[partition] >> (texel * 2)) & 3;
+    return 0;
+}
+
+static inline bool bc7IsAnchor(int subsets, int partition, int texel)
+{
+    if (texel == 0) return true;
+    if (subsets == 2) return texel == g_bc7Anchor2[partition];
+    if (subsets == 3) return texel == kAnchor3a[partition] || texel == kAnchor3b[partition];
+    return false;
+}
+
+static void decodeBC7(const unsigned char* block, unsigned char rgba[64])
+{
+    int mode = 0;
+    while (mode < 8 && !(block[0] & (1 << mode))) mode++;
+    if (mode == 8) {                        // reserved: decodes to transparent black
+        memset(rgba, 0, 64);
+        return;
+    }
+    const BC7Mode& m = kBC7Modes[mode];
+    BitReader br = { block, mode + 1 };
+
+    int partition = (int)br.read(m.partitionBits);
+    int rotation = (int)br.read(m.rotationBits);
+    int indexSel = (int)br.read(m.indexSelBits);
+
+    // endpoints[subset*2 + e][channel]
+    int ep[6][4];
+    const int numEp = m.subsets * 2;
+    for (int c = 0; c < 3; c++)
+        for (int e = 0; e < numEp; e++) ep[e][c] = (int)br.read(m.colorBits);
+    for (int e = 0; e < numEp; e++) ep[e][3] = m.alphaBits ? (int)br.read(m.alphaBits) : 255;
+
+    int colorPrec = m.colorBits, alphaPrec = m.alphaBits;
+    if (m.endpointPBits || m.sharedPBits) {
+        int pbits[6];
+        if (m.endpointPBits)
+            for (int e = 0; e < numEp; e++) pbits[e] = (int)br.read(1);
+        else
+            for (int s = 0; s < m.subsets; s++) pbits[s * 2] = pbits[s * 2 + 1] = (int)br.read(1);
+        for (int e = 0; e < numEp; e++) {
+            for (int c = 0; c < 3; c++) ep[e][c] = (ep[e][c] << 1) | pbits[e];
+            if (m.alphaBits) ep[e][3] = (ep[e][3] << 1) | pbits[e];
+        }
+        colorPrec++;
+        if (m.alphaBits) alphaPrec++;
+    }
+    // Expand to 8 bits by replicating the high bits
+    for (int e = 0; e < numEp; e++) {
+        for (int c = 0; c < 3; c++)
+            ep[e][c] = (ep[e][c] << (8 - colorPrec)) | (ep[e][c] >> (2 * colorPrec - 8));
+        if (m.alphaBits)
+            ep[e][3] = (ep[e][3] << (8 - alphaPrec)) | (ep[e][3] >> (2 * alphaPrec - 8));
+    }
+
+    int idx[16], idx2[16];
+    for (int i = 0; i < 16; i++)
+        idx[i] = (int)br.read(bc7IsAnchor(m.subsets, partition, i) ? m.indexBits - 1 : m.indexBits);
+    if (m.index2Bits)
+        for (int i = 0; i < 16; i++)
+            idx2[i] = (int)br.read(i == 0 ? m.index2Bits - 1 : m.index2Bits);
+
+    for (int i = 0; i < 16; i++) {
+        int s = bc7Subset(m.subsets, partition, i);
+        const int* e0 = ep[s * 2];
+        const int* e1 = ep[s * 2 + 1];
+        unsigned char* px = rgba + i * 4;
+
+        if (m.index2Bits) {
+            // Modes 4/5: separate color and alpha indices, optionally swapped
+            int ci = indexSel ? idx2[i] : idx[i];
+            int ai = indexSel ? idx[i] : idx2[i];
+            const unsigned char* cw = weightsFor(indexSel ? m.index2Bits : m.indexBits);
+            const unsigned char* aw = weightsFor(indexSel ? m.indexBits : m.index2Bits);
+            for (int c = 0; c < 3; c++) px[c] = interpolate(e0[c], e1[c], cw[ci]);
+            px[3] = interpolate(e0[3], e1[3], aw[ai]);
+        }
+        else {
+            const unsigned char* w = weightsFor(m.indexBits);
+            for (int c = 0; c < 4; c++) px[c] = interpolate(e0[c], e1[c], w[idx[i]]);
+        }
+
+        if (rotation) {
+            unsigned char t = px[3];
+            px[3] = px[rotation - 1];
+            px[rotation - 1] = t;
+        }
+    }
+}
+
+// ---------- Public ----------
+void bcDecodeBlock(BCFormat f, const unsigned char* block, unsigned char rgba[64])
+{
+    switch (f) {
+    case BC_FORMAT_BC1:
+        decodeColorBlock(block, rgba, false);
+        break;
+    case BC_FORMAT_BC3:
+        decodeColorBlock(block + 8, rgba, true);
+        decodeAlphaBlock(block, rgba);
+        break;
+    case BC_FORMAT_BC7:
+        decodeBC7(block, rgba);
+        break;
+    default:
+        memset(rgba, 0, 64);
+        break;
+    }
+}
+
+void bcDecodeImage(BCFormat f, const unsigned char* blocks, int width, int height,
+                   unsigned char* rgba)
+{
+    const int bw = (width + 3) / 4, bh = (height + 3) / 4;
+    const int blockBytes = bcBlockBytes(f);
+    unsigned char texels[64];
+    for (int by = 0; by < bh; by++) {
+        for (int bx = 0; bx < bw; bx++, blocks += blockBytes) {
+            bcDecodeBlock(f, blocks, texels);
+            // Clip partial blocks at the right/bottom edge
+            for (int y = 0; y < 4 && by * 4 + y < height; y++) {
+                int cols = width - bx * 4 < 4 ? width - bx * 4 : 4;
+                memcpy(rgba + ((size_t)(by * 4 + y) * width + bx * 4) * 4, texels + y * 16, cols * 4);
+            }
+        }
+    }
+}
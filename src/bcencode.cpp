@@ -0,0 +1,598 @@
+#include "bc.h"
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define BC_SSE2 1
+#  include <emmintrin.h>
+#else
+#  define BC_SSE2 0
+#endif
+
+// BC1/BC3/BC7 encoders. Endpoints come from the block's bounding box (fast)
+// or principal axis, followed by least-squares refinement; index selection
+// (the inner loop) compares four texels at a time against the palette.
+
+// Texels in channel-major order, 0..255
+struct Block {
+    float c[4][16];
+};
+
+static void loadBlock(const unsigned char rgba[64], Block& b)
+{
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 4; c++) b.c[c][i] = rgba[i * 4 + c];
+}
+
+// Nearest palette entry for every texel in mask; returns the summed squared error.
+static float selectIndices(const Block& b, unsigned int mask, const float pal[][4],
+                           int count, int channels, int idx[16])
+{
+    float total = 0.0f;
+#if BC_SSE2
+    for (int g = 0; g < 16; g += 4) {
+        __m128 best = _mm_set1_ps(FLT_MAX);
+        __m128i bestIdx = _mm_setzero_si128();
+        for (int k = 0; k < count; k++) {
+            __m128 d = _mm_setzero_ps();
+            for (int c = 0; c < channels; c++) {
+                __m128 t = _mm_sub_ps(_mm_loadu_ps(&b.c[c][g]), _mm_set1_ps(pal[k][c]));
+                d = _mm_add_ps(d, _mm_mul_ps(t, t));
+            }
+            __m128i closer = _mm_castps_si128(_mm_cmplt_ps(d, best));
+            bestIdx = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(k)),
+                                   _mm_andnot_si128(closer, bestIdx));
+            best = _mm_min_ps(best, d);
+        }
+        float err[4];
+        _mm_storeu_si128((__m128i*)&idx[g], bestIdx);
+        _mm_storeu_ps(err, best);
+        for (int i = 0; i < 4; i++)
+            if (mask & (1u << (g + i))) total += err[i];
+    }
+#else
+    for (int i = 0; i < 16; i++) {
+        float best = FLT_MAX;
+        int bi = 0;
+        for (int k = 0; k < count; k++) {
+            float d = 0.0f;
+            for (int c = 0; c < channels; c++) {
+                float t = b.c[c][i] - pal[k][c];
+                d += t * t;
+            }
+            if (d < best) { best = d; bi = k; }
+        }
+        idx[i] = bi;
+        if (mask & (1u << i)) total += best;
+    }
+#endif
+    return total;
+}
+
+// Initial endpoints for the texels in mask: bounding box or principal axis
+static void fitLine(const Block& b, unsigned int mask, int channels, bool pca,
+                    float e0[4], float e1[4])
+{
+    float mean[4] = { 0, 0, 0, 0 }, lo[4], hi[4];
+    int n = 0;
+    for (int c = 0; c < channels; c++) { lo[c] = 255.0f; hi[c] = 0.0f; }
+    for (int i = 0; i < 16; i++) {
+        if (!(mask & (1u << i))) continue;
+        n++;
+        for (int c = 0; c < channels; c++) {
+            float v = b.c[c][i];
+            mean[c] += v;
+            lo[c] = v < lo[c] ? v : lo[c];
+            hi[c] = v > hi[c] ? v : hi[c];
+        }
+    }
+    if (n == 0) {
+        for (int c = 0; c < 4; c++) e0[c] = e1[c] = 0.0f;
+        return;
+    }
+    if (!pca) {
+        // Inset the box slightly: the extremes are rarely hit exactly
+        for (int c = 0; c < channels; c++) {
+            float inset = (hi[c] - lo[c]) / 16.0f;
+            e0[c] = lo[c] + inset;
+            e1[c] = hi[c] - inset;
+        }
+        return;
+    }
+
+    for (int c = 0; c < channels; c++) mean[c] /= n;
+    float cov[4][4] = { { 0 } };
+    for (int i = 0; i < 16; i++) {
+        if (!(mask & (1u << i))) continue;
+        float d[4];
+        for (int c = 0; c < channels; c++) d[c] = b.c[c][i] - mean[c];
+        for (int r = 0; r < channels; r++)
+            for (int c = 0; c < channels; c++) cov[r][c] += d[r] * d[c];
+    }
+    // Power iteration from the bounding-box diagonal
+    float axis[4];
+    for (int c = 0; c < channels; c++) axis[c] = hi[c] - lo[c];
+    for (int it = 0; it < 8; it++) {
+        float next[4] = { 0, 0, 0, 0 }, len = 0.0f;
+        for (int r = 0; r < channels; r++) {
+            for (int c = 0; c < channels; c++) next[r] += cov[r][c] * axis[c];
+            len += next[r] * next[r];
+        }
+        if (len < 1e-12f) break;
+        len = 1.0f / sqrtf(len);
+        for (int c = 0; c < channels; c++) axis[c] = next[c] * len;
+    }
+    float tmin = FLT_MAX, tmax = -FLT_MAX;
+    for (int i = 0; i < 16; i++) {
+        if (!(mask & (1u << i))) continue;
+        float t = 0.0f;
+        for (int c = 0; c < channels; c++) t += (b.c[c][i] - mean[c]) * axis[c];
+        tmin = t < tmin ? t : tmin;
+        tmax = t > tmax ? t : tmax;
+    }
+    for (int c = 0; c < channels; c++) {
+        e0[c] = mean[c] + axis[c] * tmin;
+        e1[c] = mean[c] + axis[c] * tmax;
+    }
+}
+
+// Least-squares endpoints for fixed per-texel weights t (0 = e0, 1 = e1)
+static bool refineLine(const Block& b, unsigned int mask, int channels, const float t[16],
+                       float e0[4], float e1[4])
+{
+    float A = 0, B = 0, C = 0, X0[4] = { 0, 0, 0, 0 }, X1[4] = { 0, 0, 0, 0 };
+    for (int i = 0; i < 16; i++) {
+        if (!(mask & (1u << i))) continue;
+        float w1 = t[i], w0 = 1.0f - w1;
+        A += w0 * w0;
+        B += w0 * w1;
+        C += w1 * w1;
+        for (int c = 0; c < channels; c++) {
+            X0[c] += w0 * b.c[c][i];
+            X1[c] += w1 * b.c[c][i];
+        }
+    }
+    float det = A * C - B * B;
+    if (fabsf(det) < 1e-6f) return false;
+    det = 1.0f / det;
+    for (int c = 0; c < channels; c++) {
+        float v0 = (C * X0[c] - B * X1[c]) * det;
+        float v1 = (A * X1[c] - B * X0[c]) * det;
+        e0[c] = v0 < 0.0f ? 0.0f : (v0 > 255.0f ? 255.0f : v0);
+        e1[c] = v1 < 0.0f ? 0.0f : (v1 > 255.0f ? 255.0f : v1);
+    }
+    return true;
+}
+
+static inline int clampi(int v, int lo, int hi) { return v < lo ? lo : (v > hi ? hi : v); }
+
+// ---------- BC1 color block ----------
+static inline int to565(const float c[3])
+{
+    int r = clampi((int)(c[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+    int g = clampi((int)(c[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+    int b = clampi((int)(c[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+    return (r << 11) | (g << 5) | b;
+}
+
+static inline void from565(int v, float out[4])
+{
+    int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+    out[0] = (float)((r << 3) | (r >> 2));
+    out[1] = (float)((g << 2) | (g >> 4));
+    out[2] = (float)((b << 3) | (b >> 2));
+    out[3] = 255.0f;
+}
+
+// Palette exactly as the decoder builds it
+static void bc1Palette(int c0, int c1, bool fourColor, float pal[4][4])
+{
+    from565(c0, pal[0]);
+    from565(c1, pal[1]);
+    for (int c = 0; c < 3; c++) {
+        int a = (int)pal[0][c], b = (int)pal[1][c];
+        if (fourColor) {
+            pal[2][c] = (float)((2 * a + b) / 3);
+            pal[3][c] = (float)((a + 2 * b) / 3);
+        }
+        else {
+            pal[2][c] = (float)((a + b) / 2);
+            pal[3][c] = 0.0f;
+        }
+    }
+    pal[2][3] = pal[3][3] = 255.0f;
+}
+
+// forceFour: BC3 color blocks decode in 4-color mode whatever the endpoint order
+static void encodeColorBlock(const Block& b, unsigned int valid, unsigned char* out, BCQuality q,
+                             bool forceFour)
+{
+    unsigned int opaque = 0;
+    for (int i = 0; i < 16; i++)
+        if (forceFour || b.c[3][i] >= 128.0f) opaque |= 1u << i;
+    const bool threeColor = (opaque & valid) != valid;  // punch-through alpha needs index 3
+    opaque &= valid;
+
+    const int iterations = q == BC_QUALITY_FAST ? 0 : (q == BC_QUALITY_NORMAL ? 1 : 3);
+    // Best also refines from the bounding box, whose first pass is the fast
+    // encoding: the principal axis can start worse on small or flat blocks
+    const int starts = q == BC_QUALITY_BEST ? 2 : 1;
+    static const float kT4[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+    static const float kT3[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+
+    int bestC0 = 0, bestC1 = 0, bestIdx[16] = { 0 };
+    float bestErr = FLT_MAX;
+    for (int start = 0; start < starts; start++) {
+        float e0[4], e1[4];
+        fitLine(b, opaque, 3, q != BC_QUALITY_FAST && start == 0, e0, e1);
+        for (int it = 0; it <= iterations; it++) {
+            int c0 = to565(e0), c1 = to565(e1);
+            // Decoder mode is chosen by endpoint order: c0 > c1 -> 4 colors
+            if (!forceFour && ((threeColor && c0 > c1) || (!threeColor && c0 < c1))) {
+                int t = c0; c0 = c1; c1 = t;
+            }
+            bool four = forceFour || c0 > c1;
+            float pal[4][4];
+            bc1Palette(c0, c1, four, pal);
+            int idx[16];
+            float err = selectIndices(b, opaque, pal, four ? 4 : 3, 3, idx);
+            for (int i = 0; i < 16; i++)
+                if (!(opaque & (1u << i))) idx[i] = 3;
+            if (err < bestErr) {
+                bestErr = err;
+                bestC0 = c0;
+                bestC1 = c1;
+                memcpy(bestIdx, idx, sizeof(idx));
+            }
+            if (it == iterations) break;
+
+            float t[16];
+            for (int i = 0; i < 16; i++) t[i] = (four ? kT4 : kT3)[idx[i]];
+            // Weights are relative to (c0, c1); the next pass re-derives the order
+            from565(c0, e0);
+            from565(c1, e1);
+            if (!refineLine(b, opaque, 3, t, e0, e1)) break;
+        }
+    }
+
+    // c0 == c1 decodes in 3-color mode; only index 0 is then safe for opaque texels
+    if (!forceFour && bestC0 == bestC1)
+        for (int i = 0; i < 16; i++)
+            if (bestIdx[i] != 3 || !threeColor) bestIdx[i] = 0;
+
+    out[0] = (unsigned char)(bestC0 & 0xFF);
+    out[1] = (unsigned char)(bestC0 >> 8);
+    out[2] = (unsigned char)(bestC1 & 0xFF);
+    out[3] = (unsigned char)(bestC1 >> 8);
+    unsigned int bits = 0;
+    for (int i = 15; i >= 0; i--) bits = (bits << 2) | (unsigned int)bestIdx[i];
+    for (int i = 0; i < 4; i++) out[4 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+// ---------- BC3 alpha block ----------
+static float alphaBlockError(const Block& b, unsigned int valid, int a0, int a1, int idx[16])
+{
+    int pal[8];
+    pal[0] = a0;
+    pal[1] = a1;
+    if (a0 > a1) {
+        for (int i = 1; i < 7; i++) pal[i + 1] = (a0 * (7 - i) + a1 * i) / 7;
+    }
+    else {
+        for (int i = 1; i < 5; i++) pal[i + 1] = (a0 * (5 - i) + a1 * i) / 5;
+        pal[6] = 0;
+        pal[7] = 255;
+    }
+    float total = 0.0f;
+    for (int i = 0; i < 16; i++) {
+        int best = 0x7FFFFFFF, bi = 0;
+        for (int k = 0; k < 8; k++) {
+            int d = (int)b.c[3][i] - pal[k];
+            if (d * d < best) { best = d * d; bi = k; }
+        }
+        idx[i] = bi;
+        if (valid & (1u << i)) total += (float)best;
+    }
+    return total;
+}
+
+static void encodeAlphaBlock(const Block& b, unsigned int valid, unsigned char* out, BCQuality q)
+{
+    int lo = 255, hi = 0, lo6 = 255, hi6 = 0;
+    for (int i = 0; i < 16; i++) {
+        if (!(valid & (1u << i))) continue;
+        int a = (int)b.c[3][i];
+        lo = a < lo ? a : lo;
+        hi = a > hi ? a : hi;
+        // 6-value mode encodes 0 and 255 explicitly; fit the rest
+        if (a != 0 && a != 255) {
+            lo6 = a < lo6 ? a : lo6;
+            hi6 = a > hi6 ? a : hi6;
+        }
+    }
+    int a0 = hi, a1 = lo, idx[16];
+    float err = alphaBlockError(b, valid, a0, a1, idx);
+    if (q == BC_QUALITY_BEST && lo6 <= hi6) {
+        int idx6[16];
+        float err6 = alphaBlockError(b, valid, lo6, hi6, idx6);
+        if (err6 < err) {
+            a0 = lo6;
+            a1 = hi6;
+            memcpy(idx, idx6, sizeof(idx));
+        }
+    }
+    out[0] = (unsigned char)a0;
+    out[1] = (unsigned char)a1;
+    unsigned long long bits = 0;
+    for (int i = 15; i >= 0; i--) bits = (bits << 3) | (unsigned long long)idx[i];
+    for (int i = 0; i < 6; i++) out[2 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+// ---------- BC7 ----------
+static const int kBC7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static const int kBC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+enum { PBIT_PER_ENDPOINT, PBIT_SHARED };
+
+// bits = stored endpoint bits per channel; the p-bit is appended below them
+static inline int bc7Expand(int q, int bits, int p)
+{
+    int v = (q << 1) | p, prec = bits + 1;
+    return (v << (8 - prec)) | (v >> (2 * prec - 8));
+}
+
+static inline int bc7Quantize(float v, int bits, int p)
+{
+    int maxq = (1 << bits) - 1;
+    int q = clampi((int)((v / 255.0f) * ((1 << (bits + 1)) - 1) - p) / 2, 0, maxq);
+    // The expansion is not linear; settle on the closest neighbour
+    int best = q, bestErr = 0x7FFFFFFF;
+    for (int d = -1; d <= 1; d++) {
+        int c = clampi(q + d, 0, maxq);
+        int e = bc7Expand(c, bits, p) - (int)(v + 0.5f);
+        if (e * e < bestErr) { bestErr = e * e; best = c; }
+    }
+    return best;
+}
+
+struct BC7Subset {
+    int q[2][4];                // stored endpoint values
+    int p[2];                   // p-bit of each endpoint
+    float err;
+};
+
+// Fit one subset's endpoints and indices; idx is written only for texels in mask.
+static void bc7FitSubset(const Block& b, unsigned int mask, int channels, int bits,
+                         int pbitMode, int indexBits, BCQuality q, int idx[16], BC7Subset& out)
+{
+    const int* weights = indexBits == 3 ? kBC7Weights3 : kBC7Weights4;
+    const int count = 1 << indexBits;
+    const int iterations = q == BC_QUALITY_FAST ? 0 : (q == BC_QUALITY_NORMAL ? 1 : 2);
+    // As for BC1: best also refines from the bounding box. Every p-bit
+    // combination is tried there, so its first pass covers the fast encoding.
+    const int starts = q == BC_QUALITY_BEST ? 2 : 1;
+
+    out.err = FLT_MAX;
+    for (int start = 0; start < starts; start++) {
+        float e0[4], e1[4];
+        fitLine(b, mask, channels, q != BC_QUALITY_FAST && start == 0, e0, e1);
+        if (channels == 3) e0[3] = e1[3] = 255.0f;
+
+        float startErr = FLT_MAX;
+        int cur[16] = { 0 };            // this start's best, for the refinement
+        for (int it = 0; it <= iterations; it++) {
+            // p-bit combinations: (p0,p1) for per-endpoint, p0 == p1 for shared
+            int combos = pbitMode == PBIT_SHARED ? 2 : (q == BC_QUALITY_FAST ? 1 : 4);
+            for (int combo = 0; combo < combos; combo++) {
+                int p0, p1;
+                if (pbitMode == PBIT_SHARED) p0 = p1 = combo;
+                else if (combos == 1) { p0 = e0[0] > 127.0f; p1 = e1[0] > 127.0f; }
+                else { p0 = combo & 1; p1 = combo >> 1; }
+
+                BC7Subset s;
+                s.p[0] = p0;
+                s.p[1] = p1;
+                int ep0[4], ep1[4];
+                for (int c = 0; c < 4; c++) {
+                    s.q[0][c] = bc7Quantize(e0[c], bits, p0);
+                    s.q[1][c] = bc7Quantize(e1[c], bits, p1);
+                    ep0[c] = bc7Expand(s.q[0][c], bits, p0);
+                    ep1[c] = bc7Expand(s.q[1][c], bits, p1);
+                }
+                float pal[16][4];
+                for (int k = 0; k < count; k++)
+                    for (int c = 0; c < 4; c++)
+                        pal[k][c] = (float)(((64 - weights[k]) * ep0[c] + weights[k] * ep1[c] + 32) >> 6);
+                int trial[16];
+                s.err = selectIndices(b, mask, pal, count, channels, trial);
+                if (s.err < startErr) {
+                    startErr = s.err;
+                    memcpy(cur, trial, sizeof(cur));
+                }
+                if (s.err < out.err) {
+                    out = s;
+                    for (int i = 0; i < 16; i++)
+                        if (mask & (1u << i)) idx[i] = trial[i];
+                }
+            }
+            if (it == iterations) break;
+
+            float t[16];
+            for (int i = 0; i < 16; i++) t[i] = (mask & (1u << i)) ? weights[cur[i]] / 64.0f : 0.0f;
+            if (!refineLine(b, mask, channels, t, e0, e1)) break;
+        }
+    }
+}
+
+struct BitWriter {
+    unsigned char* data;
+    int pos;
+    void write(unsigned int v, int count)
+    {
+        for (int i = 0; i < count; i++, pos++)
+            if (v & (1u << i)) data[pos >> 3] |= (unsigned char)(1 << (pos & 7));
+    }
+};
+
+// Mode 6: one subset, RGBA 7 bits + per-endpoint p-bit, 4-bit indices
+static float encodeBC7Mode6(const Block& b, unsigned int valid, unsigned char* out, BCQuality q)
+{
+    int idx[16] = { 0 };
+    BC7Subset s;
+    bc7FitSubset(b, valid, 4, 7, PBIT_PER_ENDPOINT, 4, q, idx, s);
+
+    // Texel 0 is the anchor: its index MSB is implicit 0
+    if (idx[0] & 8) {
+        for (int c = 0; c < 4; c++) { int t = s.q[0][c]; s.q[0][c] = s.q[1][c]; s.q[1][c] = t; }
+        int t = s.p[0]; s.p[0] = s.p[1]; s.p[1] = t;
+        for (int i = 0; i < 16; i++) idx[i] = 15 - idx[i];
+    }
+
+    memset(out, 0, 16);
+    BitWriter bw = { out, 0 };
+    bw.write(1 << 6, 7);
+    for (int c = 0; c < 4; c++) {
+        bw.write((unsigned int)s.q[0][c], 7);
+        bw.write((unsigned int)s.q[1][c], 7);
+    }
+    bw.write((unsigned int)s.p[0], 1);
+    bw.write((unsigned int)s.p[1], 1);
+    for (int i = 0; i < 16; i++) bw.write((unsigned int)idx[i], i == 0 ? 3 : 4);
+    return s.err;
+}
+
+// Mode 1: two subsets, RGB 6 bits + shared p-bit per subset, 3-bit indices
+static float encodeBC7Mode1(const Block& b, unsigned int valid, int partition, unsigned char* out,
+                            BCQuality q)
+{
+    unsigned int mask1 = g_bc7Partition2[partition], mask0 = ~mask1 & 0xFFFF;
+    int idx[16] = { 0 };            // padding texels in no subset keep 0
+    BC7Subset s[2];
+    bc7FitSubset(b, mask0 & valid, 3, 6, PBIT_SHARED, 3, q, idx, s[0]);
+    bc7FitSubset(b, mask1 & valid, 3, 6, PBIT_SHARED, 3, q, idx, s[1]);
+
+    const int anchor[2] = { 0, g_bc7Anchor2[partition] };
+    for (int k = 0; k < 2; k++) {
+        if (!(idx[anchor[k]] & 4)) continue;
+        for (int c = 0; c < 3; c++) { int t = s[k].q[0][c]; s[k].q[0][c] = s[k].q[1][c]; s[k].q[1][c] = t; }
+        unsigned int m = k ? mask1 : mask0;
+        for (int i = 0; i < 16; i++)
+            if (m & (1u << i)) idx[i] = 7 - idx[i];
+    }
+
+    memset(out, 0, 16);
+    BitWriter bw = { out, 0 };
+    bw.write(1 << 1, 2);
+    bw.write((unsigned int)partition, 6);
+    for (int c = 0; c < 3; c++)
+        for (int k = 0; k < 2; k++) {
+            bw.write((unsigned int)s[k].q[0][c], 6);
+            bw.write((unsigned int)s[k].q[1][c], 6);
+        }
+    bw.write((unsigned int)s[0].p[0], 1);
+    bw.write((unsigned int)s[1].p[0], 1);
+    for (int i = 0; i < 16; i++)
+        bw.write((unsigned int)idx[i], (i == anchor[0] || i == anchor[1]) ? 2 : 3);
+    return s[0].err + s[1].err;
+}
+
+static void encodeBC7(const Block& b, unsigned int valid, unsigned char* out, BCQuality q)
+{
+    float err = encodeBC7Mode6(b, valid, out, q);
+    if (q != BC_QUALITY_BEST || err == 0.0f) return;
+
+    bool opaque = true;
+    for (int i = 0; i < 16; i++) opaque = opaque && (b.c[3][i] == 255.0f || !(valid & (1u << i)));
+    if (!opaque) return;
+
+    // Rank partitions with a cheap fit, then fully encode the best few
+    const int kCandidates = 4;
+    int cand[kCandidates];
+    float candErr[kCandidates];
+    for (int i = 0; i < kCandidates; i++) { cand[i] = -1; candErr[i] = FLT_MAX; }
+    for (int p = 0; p < 64; p++) {
+        unsigned int m1 = g_bc7Partition2[p];
+        int idx[16];
+        BC7Subset s0, s1;
+        bc7FitSubset(b, ~m1 & valid, 3, 6, PBIT_SHARED, 3, BC_QUALITY_FAST, idx, s0);
+        bc7FitSubset(b, m1 & valid, 3, 6, PBIT_SHARED, 3, BC_QUALITY_FAST, idx, s1);
+        float e = s0.err + s1.err;
+        for (int i = 0; i < kCandidates; i++) {
+            if (e < candErr[i]) {
+                for (int j = kCandidates - 1; j > i; j--) { cand[j] = cand[j - 1]; candErr[j] = candErr[j - 1]; }
+                cand[i] = p;
+                candErr[i] = e;
+                break;
+            }
+        }
+    }
+    unsigned char trial[16];
+    for (int i = 0; i < kCandidates; i++) {
+        if (cand[i] < 0) continue;
+        float e = encodeBC7Mode1(b, valid, cand[i], trial, q);
+        if (e < err) {
+            err = e;
+            memcpy(out, trial, 16);
+        }
+    }
+}
+
+// ---------- Public ----------
+void bcEncodeBlock(BCFormat f, const unsigned char rgba[64], unsigned char* block, BCQuality q,
+                   unsigned int valid)
+{
+    Block b;
+    loadBlock(rgba, b);
+    switch (f) {
+    case BC_FORMAT_BC1:
+        encodeColorBlock(b, valid, block, q, false);
+        break;
+    case BC_FORMAT_BC3:
+        encodeAlphaBlock(b, valid, block, q);
+        encodeColorBlock(b, valid, block + 8, q, true);
+        break;
+    case BC_FORMAT_BC7:
+        encodeBC7(b, valid, block, q);
+        break;
+    default:
+        break;
+    }
+}
+
+void bcEncodeImage(BCFormat f, const unsigned char* rgba, int width, int height,
+                   unsigned char* blocks, BCQuality q, int threads)
+{
+    const int bw = (width + 3) / 4, bh = (height + 3) / 4;
+    const int blockBytes = bcBlockBytes(f);
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    if (threads <= 0) threads = 1;
+    if (threads > bh) threads = bh;
+
+    // Block rows are handed out dynamically: BC7 "best" cost varies a lot per block
+    std::atomic<int> nextRow(0);
+    auto worker = [&]() {
+        unsigned char texels[64];
+        for (int by = nextRow++; by < bh; by = nextRow++) {
+            for (int bx = 0; bx < bw; bx++) {
+                unsigned int valid = 0;
+                for (int y = 0; y < 4; y++) {
+                    int sy = by * 4 + y < height ? by * 4 + y : height - 1;
+                    for (int x = 0; x < 4; x++) {
+                        int sx = bx * 4 + x < width ? bx * 4 + x : width - 1;
+                        memcpy(texels + (y * 4 + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+                        if (by * 4 + y < height && bx * 4 + x < width) valid |= 1u << (y * 4 + x);
+                    }
+                }
+                bcEncodeBlock(f, texels, blocks + ((size_t)by * bw + bx) * blockBytes, q, valid);
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (size_t i = 0; i < pool.size(); i++) pool[i].join();
+}
@@ -0,0 +1,253 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "bmp.h"
+#include "mapped_file.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BMP_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__) || defined(__AVX__)
+#define BMP_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+enum {
+    BI_RGB = 0, BI_BITFIELDS = 3, BI_ALPHABITFIELDS = 6,
+    BMP_FILE_HEADER = 14,
+    BMP_MAX_DIMENSION = 32768,
+};
+
+// Little-endian field reads; the header offsets are not aligned
+static inline uint16_t readU16(const unsigned char* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t readU32(const unsigned char* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool fail(const char** error, const char* why)
+{
+    if (error) *error = why;
+    return false;
+}
+
+static bool contiguous(uint32_t mask)
+{
+    if (!mask) return true;
+    while (!(mask & 1)) mask >>= 1;
+    return (mask & (mask + 1)) == 0;
+}
+
+bool parseBMP(const unsigned char* bytes, size_t size, BmpInfo& info, const char** error)
+{
+    if (size < BMP_FILE_HEADER + 4) return fail(error, "file too small");
+    if (bytes[0] != 'B' || bytes[1] != 'M') return fail(error, "bad magic");
+
+    const unsigned char* h = bytes + BMP_FILE_HEADER;
+    uint32_t headerSize = readU32(h);
+    if (headerSize == 12) return fail(error, "OS/2 bitmaps not supported");
+    if ((headerSize != 40 && headerSize < 52) || headerSize > size - BMP_FILE_HEADER)
+        return fail(error, "bad info header size");
+
+    int32_t width = (int32_t)readU32(h + 4);
+    int32_t height = (int32_t)readU32(h + 8);
+    uint16_t planes = readU16(h + 12);
+    uint16_t bpp = readU16(h + 14);
+    uint32_t compression = readU32(h + 16);
+
+    if (planes != 1) return fail(error, "bad plane count");
+    if (width <= 0 || height == 0 || width > BMP_MAX_DIMENSION ||
+        height > BMP_MAX_DIMENSION || height < -BMP_MAX_DIMENSION)
+        return fail(error, "bad dimensions");
+    if (bpp != 16 && bpp != 24 && bpp != 32) return fail(error, "unsupported bit depth");
+
+    // Channel masks: implicit for BI_RGB, after a 40-byte header or inside V2+ headers otherwise
+    uint32_t m[4] = { 0, 0, 0, 0 };
+    if (compression == BI_RGB) {
+        if (bpp == 16) { m[0] = 0x7C00; m[1] = 0x03E0; m[2] = 0x001F; }
+        else { m[0] = 0xFF0000; m[1] = 0xFF00; m[2] = 0xFF; }
+    }
+    else if ((compression == BI_BITFIELDS || compression == BI_ALPHABITFIELDS) && bpp != 24) {
+        bool alpha = compression == BI_ALPHABITFIELDS || headerSize >= 56;
+        size_t maskBytes = alpha ? 16 : 12;
+        const unsigned char* p = h + 40;
+        if (headerSize == 40 ? BMP_FILE_HEADER + 40 + maskBytes > size : 40 + maskBytes > headerSize)
+            return fail(error, "truncated masks");
+        for (size_t i = 0; i < maskBytes / 4; i++) m[i] = readU32(p + i * 4);
+    }
+    else return fail(error, "unsupported compression");
+
+    const uint32_t pixelBits = bpp == 32 ? 0xFFFFFFFFu : (1u << bpp) - 1;
+    if (!m[0] || !m[1] || !m[2]) return fail(error, "empty channel mask");
+    for (int i = 0; i < 4; i++) {
+        if ((m[i] & ~pixelBits) || !contiguous(m[i])) return fail(error, "bad channel mask");
+        for (int j = i + 1; j < 4; j++)
+            if (m[i] & m[j]) return fail(error, "overlapping channel masks");
+    }
+
+    uint64_t stride = (((uint64_t)width * bpp + 31) / 32) * 4;
+    uint64_t rows = (uint64_t)(height < 0 ? -(int64_t)height : height);
+    uint64_t offset = readU32(bytes + 10);
+    // The last row's padding is often left out; only require the pixels themselves
+    uint64_t needed = (rows - 1) * stride + ((uint64_t)width * bpp + 7) / 8;
+    if (offset < BMP_FILE_HEADER + headerSize || offset > size || needed > size - offset)
+        return fail(error, "truncated pixel data");
+
+    info.width = width;
+    info.height = (int)rows;
+    info.topDown = height < 0;
+    info.bitsPerPixel = bpp;
+    info.dataOffset = (size_t)offset;
+    info.stride = (size_t)stride;
+    for (int i = 0; i < 4; i++) info.mask[i] = m[i];
+    return true;
+}
+
+// ---------- Row converters ----------
+
+#if BMP_SSE2
+// Four B,G,R,x pixels -> R,G,B,x; alpha is or'ed in (0 keeps x)
+static inline __m128i swapRB(__m128i v, __m128i alpha)
+{
+    const __m128i ga = _mm_set1_epi32((int)0xFF00FF00);
+    const __m128i lo = _mm_set1_epi32(0xFF);
+    __m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), lo);
+    __m128i b = _mm_slli_epi32(_mm_and_si128(v, lo), 16);
+    return _mm_or_si128(_mm_or_si128(_mm_and_si128(v, ga), r), _mm_or_si128(b, alpha));
+}
+#endif
+
+// 24bpp BGR -> RGBA, alpha 255
+static void rowBGR(const unsigned char* s, unsigned char* d, int width)
+{
+    int x = 0;
+#if BMP_SSSE3
+    // 4 pixels per shuffle; each 16-byte load reads 4 bytes past the pixels it
+    // converts, so stop while 16 bytes of this row remain.
+    const __m128i shuf = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+    for (; x + 6 <= width; x += 4, s += 12, d += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)s);
+        _mm_storeu_si128((__m128i*)d, _mm_or_si128(_mm_shuffle_epi8(v, shuf), alpha));
+    }
+#elif BMP_SSE2
+    // Without a byte shuffle: shift each pixel into its own 32-bit lane, then
+    // swap R and B. Same loads, and the same bound, as the shuffle.
+    const __m128i lane0 = _mm_setr_epi32(0xFFFFFF, 0, 0, 0);
+    const __m128i lane1 = _mm_setr_epi32(0, 0xFFFFFF, 0, 0);
+    const __m128i lane2 = _mm_setr_epi32(0, 0, 0xFFFFFF, 0);
+    const __m128i lane3 = _mm_setr_epi32(0, 0, 0, 0xFFFFFF);
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+    for (; x + 6 <= width; x += 4, s += 12, d += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)s);
+        __m128i p = _mm_or_si128(
+            _mm_or_si128(_mm_and_si128(v, lane0), _mm_and_si128(_mm_slli_si128(v, 1), lane1)),
+            _mm_or_si128(_mm_and_si128(_mm_slli_si128(v, 2), lane2), _mm_and_si128(_mm_slli_si128(v, 3), lane3)));
+        _mm_storeu_si128((__m128i*)d, swapRB(p, alpha));
+    }
+#endif
+    for (; x < width; x++, s += 3, d += 4) {
+        d[0] = s[2]; d[1] = s[1]; d[2] = s[0]; d[3] = 255;
+    }
+}
+
+// 32bpp with byte-aligned masks B,G,R,(A) in memory order -> RGBA
+static void rowBGRA(const unsigned char* s, unsigned char* d, int width, bool hasAlpha)
+{
+    int x = 0;
+#if BMP_SSE2
+    const __m128i a = _mm_set1_epi32(hasAlpha ? 0 : (int)0xFF000000);
+    for (; x + 4 <= width; x += 4, s += 16, d += 16)
+        _mm_storeu_si128((__m128i*)d, swapRB(_mm_loadu_si128((const __m128i*)s), a));
+#endif
+    for (; x < width; x++, s += 4, d += 4) {
+        d[0] = s[2]; d[1] = s[1]; d[2] = s[0]; d[3] = hasAlpha ? s[3] : 255;
+    }
+}
+
+// Any mask layout (16bpp, 10-bit channels, odd orders): shift and rescale to
+// 8 bits, through a table for channels of up to 8 bits
+struct Channel {
+    uint32_t mask;
+    int shift;
+    uint32_t max;
+    unsigned char lut[256];
+};
+
+static void makeChannel(uint32_t mask, Channel& c)
+{
+    c.mask = mask;
+    c.shift = 0;
+    c.max = 0;
+    if (!mask) return;
+    while (!((mask >> c.shift) & 1)) c.shift++;
+    c.max = mask >> c.shift;
+    for (uint32_t v = 0; v <= c.max && v < 256; v++)
+        c.lut[v] = (unsigned char)((v * 255 + c.max / 2) / c.max);
+}
+
+static inline unsigned char expand(uint32_t p, const Channel& c)
+{
+    uint32_t v = (p & c.mask) >> c.shift;
+    if (c.max < 256) return c.lut[v];
+    return (unsigned char)(((uint64_t)v * 255 + c.max / 2) / c.max);
+}
+
+static void rowMasked(const unsigned char* s, unsigned char* d, int width, int bytesPerPixel,
+                      const Channel* ch)
+{
+    for (int x = 0; x < width; x++, s += bytesPerPixel, d += 4) {
+        uint32_t p = bytesPerPixel == 2 ? readU16(s) : readU32(s);
+        d[0] = expand(p, ch[0]);
+        d[1] = expand(p, ch[1]);
+        d[2] = expand(p, ch[2]);
+        d[3] = ch[3].mask ? expand(p, ch[3]) : 255;
+    }
+}
+
+void decodeBMPPixels(const unsigned char* bytes, const BmpInfo& info, unsigned char* rgba)
+{
+    const unsigned char* data = bytes + info.dataOffset;
+    const size_t outStride = (size_t)info.width * 4;
+    const uint32_t* m = info.mask;
+    const bool bgra = info.bitsPerPixel == 32 && m[0] == 0xFF0000 && m[1] == 0xFF00 && m[2] == 0xFF &&
+                      (m[3] == 0 || m[3] == 0xFF000000u);
+    Channel ch[4];
+    if (info.bitsPerPixel != 24 && !bgra)
+        for (int i = 0; i < 4; i++) makeChannel(m[i], ch[i]);
+
+    for (int y = 0; y < info.height; y++) {
+        const unsigned char* s = data + (size_t)y * info.stride;
+        unsigned char* d = rgba + (size_t)(info.topDown ? info.height - 1 - y : y) * outStride;
+        if (info.bitsPerPixel == 24) rowBGR(s, d, info.width);
+        else if (bgra) rowBGRA(s, d, info.width, m[3] != 0);
+        else rowMasked(s, d, info.width, info.bitsPerPixel / 8, ch);
+    }
+}
+
+bool decodeBMP(const unsigned char* bytes, size_t size, BmpImage& out)
+{
+    BmpInfo info;
+    const char* why = "";
+    if (!parseBMP(bytes, size, info, &why)) {
+        printf("Not a correct BMP file (%s)\n", why);
+        return false;
+    }
+    out.width = (unsigned int)info.width;
+    out.height = (unsigned int)info.height;
+    out.rgba.resize((size_t)info.width * info.height * 4);
+    decodeBMPPixels(bytes, info, &out.rgba[0]);
+    return true;
+}
+
+bool readBMP(const char* imagepath, BmpImage& out)
+{
+    MappedFile file;
+    if (!file.open(imagepath)) { printf("Image could not be opened\n"); return false; }
+    return decodeBMP(file.data(), file.size(), out);
+}
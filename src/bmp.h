@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include <stddef.h>
+
+// Windows bitmap decoding to tightly packed RGBA8. Output rows are always
+// bottom-up (OpenGL's texture row order), whatever the file's row order.
+//
+// Supported: 16/24/32 bpp, BI_RGB, BI_BITFIELDS and BI_ALPHABITFIELDS,
+// BITMAPINFOHEADER through BITMAPV5HEADER, top-down and bottom-up rows.
+// Palettized and RLE files are rejected.
+
+// Layout of a validated file; produced by parseBMP, consumed by decodeBMPPixels.
+struct BmpInfo {
+    int width = 0;
+    int height = 0;             // always positive
+    bool topDown = false;
+    int bitsPerPixel = 0;
+    size_t dataOffset = 0;
+    size_t stride = 0;          // bytes per file row, including padding
+    unsigned int mask[4];       // R, G, B, A channel masks (A may be 0)
+};
+
+struct BmpImage {
+    unsigned int width = 0;
+    unsigned int height = 0;
+    std::vector<unsigned char> rgba;
+};
+
+// Validate headers, masks and the pixel array extent against the buffer.
+// Returns false (with a reason in *error) for anything malformed.
+bool parseBMP(const unsigned char* bytes, size_t size, BmpInfo& info, const char** error);
+
+// Decode into a caller-provided buffer of width*height*4 bytes.
+// bytes must be the buffer parseBMP accepted.
+void decodeBMPPixels(const unsigned char* bytes, const BmpInfo& info, unsigned char* rgba);
+
+// parseBMP + decodeBMPPixels into out. Prints the reason and returns false on failure.
+bool decodeBMP(const unsigned char* bytes, size_t size, BmpImage& out);
+
+// Same, from a file (memory-mapped, not read into a temporary).
+bool readBMP(const char* imagepath, BmpImage& out);
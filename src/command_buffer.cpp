@@ -0,0 +1,183 @@
+#include "cube.h"
+#include "command_buffer.h"
+#include "profiler.h"
+#include "gl_stats.h"
+#include <string.h>
+
+// Payload words after the opcode
+static const size_t kPayload[CMD_OP_COUNT] = { 1, 2, 2, 3, 17, 4, 5 };
+
+static inline size_t valueWords(int op)
+{
+    return kPayload[op] - 1;    // uniforms: the location comes first
+}
+
+static inline uint32_t floatBits(float f)
+{
+    uint32_t u;
+    memcpy(&u, &f, 4);
+    return u;
+}
+
+static inline float bitsFloat(uint32_t u)
+{
+    float f;
+    memcpy(&f, &u, 4);
+    return f;
+}
+
+uint32_t* CommandBuffer::append(CommandOp op, size_t payload)
+{
+    const size_t at = words.size();
+    words.resize(at + 1 + payload);
+    words[at] = (uint32_t)op;
+    return &words[at + 1];
+}
+
+void CommandBuffer::bindVertexArray(uint32_t vao)
+{
+    append(CMD_BIND_VERTEX_ARRAY, 1)[0] = vao;
+}
+
+void CommandBuffer::uniform1i(int location, int value)
+{
+    if (location < 0) return;
+    uint32_t* p = append(CMD_UNIFORM_1I, 2);
+    p[0] = (uint32_t)location;
+    p[1] = (uint32_t)value;
+}
+
+void CommandBuffer::uniform1f(int location, float value)
+{
+    if (location < 0) return;
+    uint32_t* p = append(CMD_UNIFORM_1F, 2);
+    p[0] = (uint32_t)location;
+    p[1] = floatBits(value);
+}
+
+void CommandBuffer::uniform2f(int location, float x, float y)
+{
+    if (location < 0) return;
+    uint32_t* p = append(CMD_UNIFORM_2F, 3);
+    p[0] = (uint32_t)location;
+    p[1] = floatBits(x);
+    p[2] = floatBits(y);
+}
+
+void CommandBuffer::uniformMatrix4(int location, const glm::mat4& m)
+{
+    if (location < 0) return;
+    uint32_t* p = append(CMD_UNIFORM_MATRIX4, 17);
+    p[0] = (uint32_t)location;
+    memcpy(p + 1, &m[0][0], 64);
+}
+
+void CommandBuffer::drawElements(uint32_t mode, int count, uint32_t type, size_t offset)
+{
+    uint32_t* p = append(CMD_DRAW_ELEMENTS, 4);
+    p[0] = mode;
+    p[1] = (uint32_t)count;
+    p[2] = type;
+    p[3] = (uint32_t)offset;
+}
+
+void CommandBuffer::drawElementsInstanced(uint32_t mode, int count, uint32_t type, size_t offset, int instances)
+{
+    uint32_t* p = append(CMD_DRAW_ELEMENTS_INSTANCED, 5);
+    p[0] = mode;
+    p[1] = (uint32_t)count;
+    p[2] = type;
+    p[3] = (uint32_t)offset;
+    p[4] = (uint32_t)instances;
+}
+
+// ---------- Replay ----------
+
+void CommandReplayer::setUniform(int op, const uint32_t* payload)
+{
+    const size_t location = payload[0];
+    if (location >= uniforms.size()) uniforms.resize(location + 1);
+    UniformSlot& u = uniforms[location];
+    u.op = op;
+    memcpy(u.value, payload + 1, valueWords(op) * 4);
+    if (!u.pending) {
+        u.pending = true;
+        pending.push_back((int)location);
+    }
+}
+
+// Issue the held state that differs from what GL has
+void CommandReplayer::flush()
+{
+    if (vaoPending) {
+        vaoPending = false;
+        if (vaoKnown && vao == issuedVao) counters.stateSkipped++;
+        else {
+            glsBindVertexArray(vao);
+            issuedVao = vao;
+            vaoKnown = true;
+            counters.stateCalls++;
+        }
+    }
+    for (size_t i = 0; i < pending.size(); i++) {
+        const GLint location = pending[i];
+        UniformSlot& u = uniforms[location];
+        u.pending = false;
+        const size_t n = valueWords(u.op);
+        if (u.issuedOp == u.op && !memcmp(u.issued, u.value, n * 4)) {
+            counters.stateSkipped++;
+            continue;
+        }
+        switch (u.op) {
+        case CMD_UNIFORM_1I: glsUniform1i(location, (GLint)u.value[0]); break;
+        case CMD_UNIFORM_1F: glsUniform1f(location, bitsFloat(u.value[0])); break;
+        case CMD_UNIFORM_2F: glsUniform2f(location, bitsFloat(u.value[0]), bitsFloat(u.value[1])); break;
+        default: glsUniformMatrix4fv(location, 1, GL_FALSE, (const GLfloat*)u.value); break;
+        }
+        u.issuedOp = u.op;
+        memcpy(u.issued, u.value, n * 4);
+        counters.stateCalls++;
+    }
+    pending.clear();
+}
+
+void CommandReplayer::replay(const CommandBuffer* const* buffers, int count)
+{
+    PROFILE_ZONE("CommandReplayer::replay");
+    // Nothing is known about GL on entry: the first value of each is issued
+    vaoPending = vaoKnown = false;
+    for (size_t i = 0; i < uniforms.size(); i++) uniforms[i].issuedOp = CMD_OP_COUNT;
+
+    for (int b = 0; b < count; b++) {
+        const uint32_t* w = buffers[b]->data();
+        const uint32_t* end = w + buffers[b]->size();
+        while (w < end) {
+            const int op = (int)*w++;
+            const uint32_t* p = w;
+            w += kPayload[op];
+            counters.commands++;
+            switch (op) {
+            case CMD_BIND_VERTEX_ARRAY:
+                if (vaoPending) counters.stateSkipped++;    // replaced before any draw
+                vao = p[0];
+                vaoPending = true;
+                break;
+            case CMD_DRAW_ELEMENTS:
+                flush();
+                glsDrawElements(p[0], (GLsizei)p[1], p[2], BUFFER_OFFSET((size_t)p[3]));
+                counters.draws++;
+                break;
+            case CMD_DRAW_ELEMENTS_INSTANCED:
+                flush();
+                glsDrawElementsInstanced(p[0], (GLsizei)p[1], p[2], BUFFER_OFFSET((size_t)p[3]), (GLsizei)p[4]);
+                counters.draws++;
+                break;
+            default:
+                if (uniforms.size() > p[0] && uniforms[p[0]].pending) counters.stateSkipped++;
+                setUniform(op, p);
+                break;
+            }
+        }
+    }
+    flush();
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "glm/glm.hpp"
+
+// Recorded draw commands.
+//
+// A CommandBuffer is a flat stream of 32-bit words: an opcode, then a fixed
+// payload per opcode with every value inline. Recording makes no GL call and
+// touches nothing shared, so any thread can fill a buffer, and several
+// threads can fill different buffers at once. clear() keeps the capacity:
+// recording a frame of the same shape again allocates nothing.
+//
+// Names, uniform locations and index offsets are stored as given. A buffer
+// must be replayed with the program its locations belong to in use, and the
+// program must not change during the replay.
+//
+// CommandReplayer::replay issues buffers in order on the GL thread. Uniform
+// and vertex array changes are held back until the next draw and compared
+// with what was last issued. A value that is set and then reset between two
+// draws costs no GL call, and neither does setting a value it already has.
+// Whatever is still held after the last draw is issued at the end, so GL is
+// left exactly as if every command had been issued.
+
+enum CommandOp {
+    CMD_BIND_VERTEX_ARRAY,          // vao
+    CMD_UNIFORM_1I,                 // location, value
+    CMD_UNIFORM_1F,                 // location, value
+    CMD_UNIFORM_2F,                 // location, x, y
+    CMD_UNIFORM_MATRIX4,            // location, 16 floats, column-major
+    CMD_DRAW_ELEMENTS,              // mode, count, type, byte offset
+    CMD_DRAW_ELEMENTS_INSTANCED,    // mode, count, type, byte offset, instances
+    CMD_OP_COUNT
+};
+
+class CommandBuffer {
+public:
+    void clear() { words.clear(); }
+    void reserve(size_t wordCount) { words.reserve(wordCount); }
+    bool empty() const { return words.empty(); }
+    size_t size() const { return words.size(); }
+    const uint32_t* data() const { return words.data(); }
+
+    // Negative locations (uniforms the program does not use) record nothing
+    void bindVertexArray(uint32_t vao);
+    void uniform1i(int location, int value);
+    void uniform1f(int location, float value);
+    void uniform2f(int location, float x, float y);
+    void uniformMatrix4(int location, const glm::mat4& m);
+    // offset: bytes into the element buffer, below 4 GB
+    void drawElements(uint32_t mode, int count, uint32_t type, size_t offset);
+    void drawElementsInstanced(uint32_t mode, int count, uint32_t type, size_t offset, int instances);
+
+private:
+    uint32_t* append(CommandOp op, size_t payload);
+
+    std::vector<uint32_t> words;
+};
+
+struct ReplayStats {
+    int commands = 0;       // read from the buffers
+    int draws = 0;
+    int stateCalls = 0;     // uniform and vertex array calls issued
+    int stateSkipped = 0;   // recorded state commands that needed no call
+};
+
+class CommandReplayer {
+public:
+    CommandReplayer() : vao(0), issuedVao(0), vaoPending(false), vaoKnown(false) {}
+
+    // GL thread. Assumes nothing about GL state on entry.
+    void replay(const CommandBuffer* const* buffers, int count);
+    void replay(const CommandBuffer& buffer)
+    {
+        const CommandBuffer* one = &buffer;
+        replay(&one, 1);
+    }
+
+    const ReplayStats& stats() const { return counters; }
+    void resetStats() { counters = ReplayStats(); }
+
+private:
+    struct UniformSlot {
+        int op = CMD_OP_COUNT;          // recorded value; CMD_OP_COUNT: none
+        uint32_t value[16];
+        int issuedOp = CMD_OP_COUNT;    // what GL holds; CMD_OP_COUNT: unknown
+        uint32_t issued[16];
+        bool pending = false;
+    };
+
+    void setUniform(int op, const uint32_t* payload);
+    void flush();
+
+    std::vector<UniformSlot> uniforms;  // by location
+    std::vector<int> pending;           // locations with a held value
+    uint32_t vao, issuedVao;
+    bool vaoPending, vaoKnown;
+    ReplayStats counters;
+};
@@ -1,19 +1,37 @@
 // Display a swimming cubeman
 
 #include "cube.h"
-#include "sphere.h"
 #include "texture.hpp"
+#include "shadow.h"
+#include "texture_stream.h"
+#include "texture_array.h"
+#include "virtual_texture.h"
+#include "vertex_anim.h"
+#include "impostor.h"
+#include "mesh_cache.h"
+#include "mesh_gen.h"
+#include "swim_rig.h"
+#include "frame_pacer.h"
+#include "sim_thread.h"
+#include "triple_buffer.h"
+#include "task_scheduler.h"
+#include "command_buffer.h"
+#include "entity_store.h"
+#include "frame_arena.h"
+#include "profiler.h"
+#include "gl_stats.h"
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtx/transform.hpp"
 #include <cmath>
+#include <cstring>
+#include <cstddef>
 
 glm::mat4 projectMat;
 glm::mat4 viewMat;
 
 GLuint programID;
 GLuint vaoCube, vaoSphere;
-GLuint bufferCube, bufferSphere;
 
 GLuint projectMatrixID;
 GLuint viewMatrixID;
@@ -23,22 +41,21 @@ GLuint viewPosID;
 GLuint lightAmbientID, lightDiffuseID, lightSpecularID;
 GLuint materialAmbientID, materialDiffuseID, materialSpecularID;
 GLuint materialShininessID;
+GLuint lightViewProjID;
 
-Sphere g_sphere(40, 40);
-int g_sphereVertCount = 0;
+// Model-matrix uniform of the main program
+GLint g_modelLoc = -1;
+
+// Unit cube and unit sphere, from cube.mesh / sphere.mesh (baked on first run)
+static GpuMesh g_cubeMesh, g_sphereMesh;
 
 typedef glm::vec4  color4;
 typedef glm::vec4  point4;
 
 const int NumVertices = 36; //(6 faces)(2 triangles/face)(3 vertices/triangle)
 
-point4 points[NumVertices];
-color4 colors[NumVertices];
-point4 normals[NumVertices];
-glm::vec2 tcoords[NumVertices];
-
 // Vertices of a unit cube centered at origin
-point4 vertices[8] = {
+GLM_CONSTEXPR point4 vertices[8] = {
 	point4(-0.5, -0.5,  0.5, 1.0),
 	point4(-0.5,  0.5,  0.5, 1.0),
 	point4(0.5,  0.5,  0.5, 1.0),
@@ -50,7 +67,7 @@ point4 vertices[8] = {
 };
 
 // RGBA colors
-color4 vertex_colors[8] = {
+GLM_CONSTEXPR color4 vertex_colors[8] = {
 	color4(0.0, 0.0, 0.0, 1.0),  // black
 	color4(1.0, 0.0, 0.0, 1.0),  // red
 	color4(1.0, 1.0, 0.0, 1.0),  // yellow
@@ -61,303 +78,931 @@ color4 vertex_colors[8] = {
 	color4(0.0, 1.0, 1.0, 1.0)   // cyan
 };
 
-int Index = 0;
-static inline void quad(int a, int b, int c, int d)
+// The 36-vertex cube, expanded from the tables above. Built at compile time
+// whenever GLM_HAS_CONSTEXPR (SIMD builds need C++20), at static init otherwise.
+struct CubeTables {
+	point4 points[NumVertices];
+	color4 colors[NumVertices];
+	point4 normals[NumVertices];
+	glm::vec2 tcoords[NumVertices];
+};
+
+static GLM_CONSTEXPR void quad(CubeTables& t, int& index, int a, int b, int c, int d)
+{
+	// Cube edges are unit length and perpendicular, so u x v is already normalized
+	glm::vec4 u = vertices[b] - vertices[a];
+	glm::vec4 v = vertices[c] - vertices[b];
+	point4 normal(u.y * v.z - u.z * v.y, u.z * v.x - u.x * v.z, u.x * v.y - u.y * v.x, 0.0f);
+
+	const int corner[6] = { a, b, c, a, c, d };       // triangles a,b,c and a,c,d
+	const glm::vec2 uv[6] = {
+		glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f),
+		glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec2(0.0f, 1.0f)
+	};
+	for (int i = 0; i < 6; i++, index++) {
+		t.colors[index] = vertex_colors[corner[i]];
+		t.points[index] = vertices[corner[i]];
+		t.normals[index] = normal;
+		t.tcoords[index] = uv[i];
+	}
+}
+
+static GLM_CONSTEXPR CubeTables colorcube()
 {
-	glm::vec3 u = glm::vec3(vertices[b] - vertices[a]);
-	glm::vec3 v = glm::vec3(vertices[c] - vertices[b]);
-	glm::vec3 n = glm::normalize(glm::cross(u, v));
-	point4 normal(n.x, n.y, n.z, 0.0f);
+	CubeTables t{};
+	int index = 0;
+	quad(t, index, 1, 0, 3, 2);
+	quad(t, index, 2, 3, 7, 6);
+	quad(t, index, 3, 0, 4, 7);
+	quad(t, index, 6, 5, 1, 2);
+	quad(t, index, 4, 5, 6, 7);
+	quad(t, index, 5, 4, 0, 1);
+	return t;
+}
+
+static GLM_CONSTEXPR CubeTables g_cubeTables = colorcube();
+
+#if GLM_HAS_CONSTEXPR
+static_assert(g_cubeTables.normals[0].z == 1.0f && g_cubeTables.normals[NumVertices - 1].x == -1.0f,
+	"cube faces must keep their outward winding");
+#endif
 
-	// triangle 1: a,b,c
-	colors[Index] = vertex_colors[a]; points[Index] = vertices[a]; normals[Index] = normal; tcoords[Index] = glm::vec2(0.0f, 0.0f); Index++;
-	colors[Index] = vertex_colors[b]; points[Index] = vertices[b]; normals[Index] = normal; tcoords[Index] = glm::vec2(1.0f, 0.0f); Index++;
-	colors[Index] = vertex_colors[c]; points[Index] = vertices[c]; normals[Index] = normal; tcoords[Index] = glm::vec2(1.0f, 1.0f); Index++;
+// ---------- Mesh cache ----------
+// Change a key whenever its generator changes so stale .mesh files are rebaked
+static const uint32_t CUBE_MESH_KEY = 0x43554201;
+static const uint32_t SPHERE_MESH_KEY = 0x53504802;
+static const uint32_t BODY_MESH_KEY = 0x424F4402;
 
-	// triangle 2: a,c,d
-	colors[Index] = vertex_colors[a]; points[Index] = vertices[a]; normals[Index] = normal; tcoords[Index] = glm::vec2(0.0f, 0.0f); Index++;
-	colors[Index] = vertex_colors[c]; points[Index] = vertices[c]; normals[Index] = normal; tcoords[Index] = glm::vec2(1.0f, 1.0f); Index++;
-	colors[Index] = vertex_colors[d]; points[Index] = vertices[d]; normals[Index] = normal; tcoords[Index] = glm::vec2(0.0f, 1.0f); Index++;
+static void bakeCube(MeshData& out)
+{
+	appendMeshLod(out, g_cubeTables.points, g_cubeTables.normals, g_cubeTables.colors,
+		g_cubeTables.tcoords, NumVertices, 1e30f);
 }
 
-static inline void colorcube()
+// Head sphere LODs: 40x40 (the original tessellation), 20x20, 10x10
+static void bakeSphere(MeshData& out)
 {
-	Index = 0;
-	quad(1, 0, 3, 2);
-	quad(2, 3, 7, 6);
-	quad(3, 0, 4, 7);
-	quad(6, 5, 1, 2);
-	quad(4, 5, 6, 7);
-	quad(5, 4, 0, 1);
+	const int segments[3] = { 40, 20, 10 };
+	const float maxDistance[3] = { 6.0f, 15.0f, 1e30f };
+	GenMesh sphere;
+	for (int i = 0; i < 3; i++) {
+		genUVSphere(sphere, segments[i], segments[i]);
+		std::vector<glm::vec4> skin(sphere.vertexCount(), glm::vec4(1.0f, 0.8f, 0.6f, 1.0f));
+		appendMeshLod(out, sphere.positions.data(), sphere.normals.data(), skin.data(),
+			sphere.texCoords.data(), sphere.vertexCount(), sphere.indices.data(),
+			sphere.indices.size(), maxDistance[i]);
+	}
 }
 
 // ---------- Animation/keyframe state ----------
-static int g_camMode = 1;                 // 1: side, 2: OTS, 3: front
+static std::atomic<int> g_camMode(1);     // 1: side, 2: OTS, 3: front (read by the sim thread)
 static float g_cycleSec = 2.0f;           // one swim cycle duration (seconds)
-static int g_prevMS = 0;
-static double g_timeSec = 0.0;            // accumulated time (seconds)
-
-// 6 keyframes (+1 wrap row). Degrees.
-// This guarantees monotonic increase (no "shortest-arc" reversal).
-static const int K = 6; // segments
-static const float k_shoulderR[K + 1] = { 360, 315, 270, 225, 180, 90, 0 };
-static const float k_shoulderL[K + 1] = { 225, 135, 45, 0, -45, -90, -135 };
-
-// Elbow flex (freestyle style). Rough, but plausible.
-// R-frame aligned with k_shoulderR; L-frame aligned with k_shoulderL (phase-shifted).
-static const float k_elbowR[K + 1] = { 45, 180, 270, 345, 420, 360, 405 };
-static const float k_elbowL[K + 1] = { 30, 0, 15, 45, 180, 270, 390 };
-// Flutter kick around hips; knees follow with slightly different phase/amplitude.
-static const float k_hipR[K + 1] = { 5, 15, 30, 5, 15, 30, 5 };
-static const float k_hipL[K + 1] = { 30, 20, 5, 30, 20, 5, 30 };
-static const float k_kneeR[K + 1] = { -20, 0, 0, -20, -0, 0, -20 };
-static const float k_kneeL[K + 1] = { 0, 0, -20, 0, 0, -20, 0 };
-// Torso bobbing (small). Up axis = +Y.
-static const float k_torsoBobY[K + 1] = { 0.04, 0.02, 0.00, -0.02, -0.01, 0.02, 0.04 };
-
-// Linear interp helper for keyframes in [0,1) -> [idx, idx+1]
-static inline float kfLerp(const float a[], int kCountPlus1, float t01)
-{
-	float seg = t01 * K;
-	int i = (int)glm::clamp(floor(seg), 0.0f, float(K - 1));
-	float u = seg - float(i);
-	return a[i] * (1.0f - u) + a[i + 1] * u;
-}
+static double g_timeSec = 0.0;            // render time: between the last two sim steps
+
+// ---------- Frame pacing ----------
+// --pace target|uncapped|demand, --fps N (target rate, also the cap in demand
+// mode), --pace-stats 1 (print fps and idle CPU once a second)
+static PacerSettings g_pacerSettings;
+static FramePacer g_pacer;
+
+// ---------- Scene/shadow state ----------
+static const glm::vec3 g_lightPos(2.0f, 3.0f, 2.0f);
+static const glm::mat4 g_floorMat =
+	glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.0f, 0.0f)) *
+	glm::scale(glm::mat4(1.0f), glm::vec3(10.0f, 0.1f, 10.0f));
+
+enum { CASTER_FLOOR, CASTER_MAN };
+static ShadowSettings g_shadowSettings;
+static ShadowMap g_shadow;
+static bool g_shadowsOn = false;
+static int g_manCaster = -1;
+static int g_statsPrevMS = 0;
+
+// ---------- Texture streaming ----------
+static TextureStreamer g_textures;
+static int g_earthTex = -1;
+
+// ---------- Crowd ----------
+// Extra swimmers in neighbouring lanes, each with its own lane offset, stroke
+// phase and skin layer. Drawn as one instanced draw of the skinned body.
+// Every swimmer is an entity (entity_store.h): root, animation cursor and
+// look live in separate columns, so each pipeline stage streams only what it
+// reads. The visible members are packed into CrowdInstances per snapshot,
+// uploaded as-is: the instance attributes of the crowd VAO.
+struct CrowdInstance {
+	glm::vec3 offset;
+	float skinLayer;
+	float phase;            // seconds ahead of the main swimmer
+	float cycle;            // stroke cycle length (seconds)
+};
+
+struct SwimmerRoot { glm::vec3 position; };
+struct SwimmerAnim { float phase, cycle; };     // as in CrowdInstance
+struct SwimmerLook { float skinLayer; };
+typedef Archetype<SwimmerRoot, SwimmerAnim, SwimmerLook> SwimmerStore;
+
+static const int SKIN_SIZE = 128;
+static const int SKIN_COUNT = 8;
+static const int CROWD_EDIT = 64;       // swimmers per '+' / '-'
+static int g_crowdSize = 0;             // --crowd: swimmers at start
+static SwimmerStore g_swimmers;         // simulation thread once it runs
+static int g_crowdSpawned = 0;          // picks the next swimmer's lane and row
+static int g_crowdRemoved = 0;
+static std::atomic<int> g_crowdEdit(0); // from the keys: > 0 add, < 0 remove
+static TextureArray g_skins;
+static GLuint vaoBodyCrowd, bufferCrowd;
+static GLint g_textureModeLoc = -1;
+
+// ---------- Skinned body ----------
+// All ten parts merged into one mesh, every vertex tagged with its part as
+// bone index. The bone palette (a texture buffer on unit 5) holds PART_COUNT
+// rigid matrices per swimmer: the main swimmer first, then the crowd.
+static GpuMesh g_bodyMesh;
+static GLuint vaoBody, bufferPalette, texPalette;
+static GLint g_boneCountLoc = -1, g_paletteBaseLoc = -1;
+static std::vector<glm::mat4> g_palette;
+
+// How the crowd is animated; the values are the shader's gpuAnimation.
+//   --anim cpu: FK on the CPU into the palette
+//   --anim gpu: bones evaluated in the vertex shader from the clip and rig
+//               tables (a uniform block uploaded once) and each instance's phase
+//   --vat file: vertices played back from a baked vertex animation texture
+//               (tools/vatbake) on units 6 and 7
+enum CrowdAnim { CROWD_ANIM_CPU, CROWD_ANIM_CLIP, CROWD_ANIM_VAT };
+static int g_crowdAnim = CROWD_ANIM_CPU;
+static GLuint uboClip;
+static GLint g_gpuAnimLoc = -1, g_animTimeLoc = -1;
+static const char* g_vatPath = NULL;
+static VertexAnimTexture g_vat;
+
+// ---------- Impostors ----------
+// --impostors D: crowd members further than D from the eye are drawn as
+// octahedral impostors (impostor.h, atlas on units 8 and 9) baked from the
+// body at init. Over the last --impostor-fade F before D both are drawn,
+// dithered into each other. Each frame the crowd is split into the near list
+// (streamed into bufferCrowd) and the far list (bufferImpostor).
+static ImpostorSettings g_impSettings;
+static ImpostorAtlas g_impostors;
+static bool g_impOn = false;
+static GLuint vaoImpostor, bufferImpostor;
+static GLint g_lodFadeLoc = -1;
+
+// ---------- Virtual texture ----------
+// --vt <file.vtex> puts a tiled (tools/vtbake) texture on the head sphere.
+static const char* g_vtPath = NULL;
+static VTSettings g_vtSettings;
+static VirtualTexture g_vt;
+static bool g_vtOn = false;
+static int g_vtStatsPrevMS = 0;
 
 // ---------- Drawing helpers ----------
-static inline void drawUnit(const glm::mat4& model)
+// Draws are recorded into command buffers (command_buffer.h), not issued.
+// The main pass is recorded by tasks while the GL thread runs the shadow and
+// virtual texture passes, then replayed; those passes' callbacks record into
+// g_passCmds and replay it straight away. modelLoc is the pass's model-matrix
+// uniform. --cmd-stats 1 prints what replay saved once a second.
+static CommandReplayer g_replayer;
+static CommandBuffer g_passCmds;            // GL thread
+static CommandBuffer g_sceneCmds, g_crowdCmds;
+static bool g_cmdStatsOn = false;
+static int g_cmdStatsPrevMS = 0;
+// --gl-stats 1 prints the last frame's GL counters (gl_stats.h) once a second;
+// they are only counted in builds with GL_STATS defined. What the state cache
+// (gl_state.h) filtered is printed in every build; --gl-cache 0 issues every
+// call anyway, to compare.
+static bool g_glStatsOn = false;
+static int g_glStatsPrevMS = 0;
+static uint64_t g_glFilteredPrev = 0;
+static bool g_glCacheOn = true;
+
+static inline size_t indexOffset(const GpuMesh& mesh, int lod)
 {
-	glBindVertexArray(vaoCube);
+	return (size_t)meshLodIndexOffset(mesh, lod);
+}
 
-	glm::mat4 modelMat = model;
-	glUniformMatrix4fv(modelMatrixID, 1, GL_FALSE, &modelMat[0][0]);
+static inline void recordUnit(CommandBuffer& cb, GLint modelLoc, const glm::mat4& model)
+{
+	cb.bindVertexArray(vaoCube);
+	cb.uniformMatrix4(modelLoc, model);
+	cb.drawElements(GL_TRIANGLES, g_cubeMesh.lod[0].indexCount, g_cubeMesh.indexType, indexOffset(g_cubeMesh, 0));
+}
+
+static inline void recordSphereUnit(CommandBuffer& cb, GLint modelLoc, const glm::mat4& model)
+{
+	cb.bindVertexArray(vaoSphere);
+	cb.uniformMatrix4(modelLoc, model);
 
-	glDrawArrays(GL_TRIANGLES, 0, NumVertices);
+	int lod = selectMeshLod(g_sphereMesh, glm::length(glm::vec3(viewMat * model[3])));
+	cb.drawElements(GL_TRIANGLES, g_sphereMesh.lod[lod].indexCount, g_sphereMesh.indexType, indexOffset(g_sphereMesh, lod));
 }
 
-static inline void drawSphereUnit(const glm::mat4& model)
+// ---------- Man (hierarchical model) ----------
+// Limb transforms are computed once per frame into a ManPose (swim_rig) and
+// then drawn by every pass that needs them (shadow + main).
+static ManPose g_pose;
+
+// ---------- Simulation ----------
+// Fixed steps of 1 / --sim-hz seconds (default 120), at most --sim-max-steps
+// per wake-up, on their own thread (sim_thread.h). A step poses the main
+// swimmer. After its steps the thread publishes a FrameSnapshot through a
+// triple buffer: both last states, the camera and the crowd split. The GL
+// thread only takes the newest snapshot and submits it, blending the two
+// states; neither side waits for the other. The crowd is a pure function of
+// time: the GPU paths evaluate it at the blended time, the CPU path's bones
+// come with the snapshot, at the newest step's time.
+struct SimState {
+	double timeSec;
+	ManPose pose;
+};
+
+struct FrameSnapshot {
+	uint64_t seq = 0;
+	SimThread::Clock::time_point stepWall;      // see SimThread
+	SimThread::Clock::time_point published;
+	SimState prev, curr;
+	int camMode = 0;
+	glm::vec3 eye;
+	glm::mat4 view;
+	std::vector<CrowdInstance> crowdNear, crowdFar;     // visible mesh / impostor members
+	std::vector<glm::mat4> crowdBones;                  // CPU animation: PART_COUNT per mesh member
+};
+
+static SimClockSettings g_simSettings;
+static SimState g_simPrev, g_simCurr;               // simulation thread only
+static uint64_t g_publishSeq = 0;
+static int g_publishedCamMode = 0;
+static float g_publishedAspect = 0.0f;
+static std::atomic<float> g_aspect(1.0f);           // set by resize, culls on the sim thread
+static TripleBuffer<FrameSnapshot> g_frames;
+static const FrameSnapshot* g_frame = NULL;         // GL thread: the snapshot being drawn
+
+// GL thread, --sim-stats 1: how old snapshots are when display picks them up
+struct SnapshotStats {
+	int taken = 0;
+	int skipped = 0;        // published, overwritten before display saw them
+	int reused = 0;         // frames drawn from an already drawn snapshot
+	double ageSumMs = 0.0, ageMaxMs = 0.0;
+};
+static bool g_simStatsOn = false;
+static SnapshotStats g_snapStats;
+static int g_simStatsPrevMS = 0;
+
+// ---------- Crowd pipeline ----------
+// Runs on the simulation thread for every snapshot, as tasks on the
+// work-stealing scheduler (task_scheduler.h; --threads N, default one per core):
+//   cull     frustum test, mesh/impostor split per member     parallel
+//   build    compact the visible members into the draw lists  serial
+//   sample   clip channels per mesh member                    parallel  (CPU animation)
+//   FK       bone matrices per mesh member                    parallel  (CPU animation)
+// sample and FK are continuations spawned by build, the first stage to know
+// the mesh count. Submission stays on the GL thread, which draws snapshot N
+// while this builds N + 1. A build's scratch arrays come from the simulation
+// thread's frame arena (frame_arena.h). Only the simulation thread wait()s
+// on g_tasks: a waiting thread runs whatever task comes next. The GL thread
+// must never end up running crowd work, so it block()s on its own tasks.
+enum { CROWD_MESH = 1, CROWD_IMPOSTOR = 2 };
+enum { CULL_GRAIN = 1024, SAMPLE_GRAIN = 256, FK_GRAIN = 64 };
+static TaskScheduler g_tasks;
+static int g_taskThreads = 0;
+static glm::vec3 g_crowdCenter;                     // body bounds over the cycle, from the root
+static float g_crowdRadius = 1.0f;
+
+// One build, on the simulation thread's stack; its tasks capture a pointer
+struct CrowdBuild {
+	FrameSnapshot* f;
+	FrameArena* arena;
+	TaskCounter done;
+	glm::vec4 planes[6];
+	double timeSec;
+	int count;
+	unsigned char* cls;         // per member: CROWD_* bits, 0 when culled
+	float* channels;            // ANIM_CHANNEL_COUNT per mesh member
+};
+
+// FRAME_ALLOC_CHECK builds (frame_arena.h): display and publishFrame must
+// not touch the heap once nothing has changed for a second, and neither may
+// the tasks they create, on whichever thread those run. Camera, window and
+// crowd changes grow the draw lists, and streaming allocates while busy.
+static std::atomic<long long> g_changedAt(0);       // SimThread::Clock ticks
+
+static void markChanged()
 {
-	glBindVertexArray(vaoSphere);
+	g_changedAt = (long long)SimThread::Clock::now().time_since_epoch().count();
+}
 
-	glm::mat4 modelMat = model;
-	glUniformMatrix4fv(modelMatrixID, 1, GL_FALSE, &modelMat[0][0]);
+static bool steadyFor(double sec)
+{
+	const SimThread::Clock::duration since = SimThread::Clock::now().time_since_epoch() -
+		SimThread::Clock::duration(g_changedAt.load(std::memory_order_relaxed));
+	return std::chrono::duration<double>(since).count() > sec;
+}
+
+// Declared after everything its callbacks touch: destroyed (joined) first at exit
+static SimThread g_simThread;
 
-	glDrawArrays(GL_TRIANGLES, 0, g_sphereVertCount);
+static inline float cycleAt(double timeSec, float cycleSec)
+{
+	return fmod(float(timeSec / cycleSec), 1.0f);
 }
 
-static inline glm::mat4 rotX_deg(const glm::mat4& M, float deg)
+void poseMan(double timeSec, ManPose& pose)
 {
-	return glm::rotate(M, glm::radians(deg), glm::vec3(1, 0, 0));
+	poseManAt(cycleAt(timeSec, g_cycleSec), pose);
 }
 
-// ---------- Man (hierarchical model) ----------
-// All dimensions are in "unit cube" scale space.
-void drawMan(double timeSec)
-{
-	// Cycle t in [0,1)
-	float tCycle = fmod(float(timeSec / g_cycleSec), 1.0f);
-
-	// Interpolated attributes (degrees)
-	float shoulderR = kfLerp(k_shoulderR, K + 1, tCycle);
-	float shoulderL = kfLerp(k_shoulderL, K + 1, tCycle);
-	float elbowR = kfLerp(k_elbowR, K + 1, tCycle);
-	float elbowL = kfLerp(k_elbowL, K + 1, tCycle);
-	float hipR = kfLerp(k_hipR, K + 1, tCycle);
-	float hipL = kfLerp(k_hipL, K + 1, tCycle);
-	float kneeR = kfLerp(k_kneeR, K + 1, tCycle);
-	float kneeL = kfLerp(k_kneeL, K + 1, tCycle);
-	float bobY = kfLerp(k_torsoBobY, K + 1, tCycle);
-
-	// Base/prone: rotate torso -90 about X so the man "lies facing down"
-	glm::mat4 base = glm::translate(glm::mat4(1.0f), glm::vec3(0, bobY, 0));
-	base = rotX_deg(base, -90.0f);
-
-	// Sizes
-	const glm::vec3 torsoS(0.7f, 1.0f, 0.3f);
-	const glm::vec3 headS(0.3f, 0.3f, 0.3f);
-	const glm::vec3 uArmS(0.2f, 0.5f, 0.2f);
-	const glm::vec3 fArmS(0.2f, 0.6f, 0.2f);
-	const glm::vec3 uLegS(0.2f, 0.8f, 0.2f);
-	const glm::vec3 lLegS(0.2f, 0.8f, 0.2f);
-
-	// Torso (centered)
-	glm::mat4 torso = glm::scale(base, torsoS);
-	drawUnit(torso);
-
-	// Head (above torso along +Y in torso space)
-	glm::mat4 head = base;
-	head = glm::translate(head, glm::vec3(0, torsoS.y * 0.5f + headS.y * 0.5f, 0));
-	head = glm::scale(head, headS);
-	drawSphereUnit(head);
-
-	// Shoulder/hip anchors in torso space
-	const float shoulderY = torsoS.y * 0.55f;
-	const float shoulderX = torsoS.x * 0.67f;
-	const float hipY = -torsoS.y * 0.55f;
-	const float hipX = torsoS.x * 0.33f;
-
-	// ----- Right arm -----
-	{   // Upper arm pivot at shoulder; rotate around X; then drop half length
-		glm::mat4 A = base;
-		A = glm::translate(A, glm::vec3(+shoulderX, shoulderY, 0));
-		A = rotX_deg(A, shoulderR);  // continuous monotonic rotation
-		A = glm::translate(A, glm::vec3(0, -uArmS.y * 0.55f, 0));
-		A = glm::scale(A, uArmS);
-		drawUnit(A);
-
-		// Forearm: from upper-arm end; elbow flex around X; drop half length
-		glm::mat4 F = base;
-		F = glm::translate(F, glm::vec3(+shoulderX, shoulderY, 0));
-		F = rotX_deg(F, shoulderR);
-		F = glm::translate(F, glm::vec3(0, -uArmS.y, 0));
-		F = rotX_deg(F, elbowR);
-		F = glm::translate(F, glm::vec3(0, -fArmS.y * 0.55f, 0));
-		F = glm::scale(F, fArmS);
-		drawUnit(F);
+// textureModeLoc is the main program's isTexture (-1 in other passes); it
+// switches the head to the virtual texture when one is loaded.
+static void recordManPose(CommandBuffer& cb, GLint modelLoc, const ManPose& pose, GLint textureModeLoc = -1)
+{
+	for (int i = 0; i < PART_COUNT; i++) {
+		if (i == PART_HEAD) {
+			if (g_vtOn) cb.uniform1i(textureModeLoc, 3);
+			recordSphereUnit(cb, modelLoc, pose.part[i]);
+			if (g_vtOn) cb.uniform1i(textureModeLoc, 1);
+		}
+		else recordUnit(cb, modelLoc, pose.part[i]);
 	}
-	// ----- Left arm -----
-	{
-		glm::mat4 A = base;
-		A = glm::translate(A, glm::vec3(-shoulderX, shoulderY, 0));
-		A = rotX_deg(A, shoulderL);
-		A = glm::translate(A, glm::vec3(0, -uArmS.y * 0.55f, 0));
-		A = glm::scale(A, uArmS);
-		drawUnit(A);
-
-		glm::mat4 F = base;
-		F = glm::translate(F, glm::vec3(-shoulderX, shoulderY, 0));
-		F = rotX_deg(F, shoulderL);
-		F = glm::translate(F, glm::vec3(0, -uArmS.y, 0));
-		F = rotX_deg(F, elbowL);
-		F = glm::translate(F, glm::vec3(0, -fArmS.y * 0.55f, 0));
-		F = glm::scale(F, fArmS);
-		drawUnit(F);
+}
+
+// ---------- Crowd ----------
+// Procedural swimsuit skin: suit colour from a golden-ratio hue walk with
+// white stripes on the lower half, skin tone on the upper half.
+static void makeSkin(int index, unsigned char* rgba)
+{
+	float h = fmod(index * 0.618034f, 1.0f) * 6.0f;
+	glm::vec3 suit = glm::clamp(glm::vec3(fabs(h - 3.0f) - 1.0f, 2.0f - fabs(h - 2.0f), 2.0f - fabs(h - 4.0f)), 0.0f, 1.0f);
+	glm::vec3 skin = glm::mix(glm::vec3(0.96f, 0.80f, 0.69f), glm::vec3(0.55f, 0.38f, 0.26f), (index % 4) / 3.0f);
+
+	for (int y = 0; y < SKIN_SIZE; y++) {
+		for (int x = 0; x < SKIN_SIZE; x++) {
+			bool lower = y < SKIN_SIZE * 45 / 100;
+			glm::vec3 c = lower ? suit : skin;
+			if (lower && (x / 8 + index) % 4 == 0) c = glm::mix(c, glm::vec3(1.0f), 0.6f);
+			unsigned char* p = rgba + ((size_t)y * SKIN_SIZE + x) * 4;
+			p[0] = (unsigned char)(c.r * 255.0f + 0.5f);
+			p[1] = (unsigned char)(c.g * 255.0f + 0.5f);
+			p[2] = (unsigned char)(c.b * 255.0f + 0.5f);
+			p[3] = 255;
+		}
 	}
+}
 
-	// ----- Right leg -----
-	{
-		glm::mat4 U = base;
-		U = glm::translate(U, glm::vec3(+hipX, hipY, 0));
-		U = rotX_deg(U, hipR);
-		U = glm::translate(U, glm::vec3(0, -uLegS.y * 0.5f, 0));
-		U = glm::scale(U, uLegS);
-		drawUnit(U);
-
-		glm::mat4 L = base;
-		L = glm::translate(L, glm::vec3(+hipX, hipY, 0));
-		L = rotX_deg(L, hipR);
-		L = glm::translate(L, glm::vec3(0, -uLegS.y, 0));
-		L = rotX_deg(L, kneeR);
-		L = glm::translate(L, glm::vec3(0, -lLegS.y * 0.55f, 0));
-		L = glm::scale(L, lLegS);
-		drawUnit(L);
+// Lanes beside the main swimmer (away from the side camera), rows along z
+static void spawnSwimmer()
+{
+	const int i = g_crowdSpawned++;
+	const int lane = i % 3, row = i / 3;
+	SwimmerRoot root = { glm::vec3(-1.3f * (lane + 1), 0.0f, -2.5f * row + 0.5f * lane) };
+	SwimmerAnim anim = { fmodf(i * 0.618034f, 1.0f) * g_cycleSec, g_cycleSec };
+	SwimmerLook look = { (float)(i % g_skins.layers()) };
+	g_swimmers.create(root, anim, look);
+}
+
+static void initCrowd()
+{
+	if (g_crowdSize <= 0) return;
+	// Per-instance attributes (instanceAttrib) are GL 3.3 or ARB_instanced_arrays;
+	// the context is only 3.2. Without them there is no crowd, so no impostors.
+	if (!(GLEW_VERSION_3_3 || GLEW_ARB_instanced_arrays)) {
+		printf("crowd: instanced arrays not supported, --crowd ignored\n");
+		g_crowdSize = 0;
+		return;
 	}
-	// ----- Left leg -----
-	{
-		glm::mat4 U = base;
-		U = glm::translate(U, glm::vec3(-hipX, hipY, 0));
-		U = rotX_deg(U, hipL);
-		U = glm::translate(U, glm::vec3(0, -uLegS.y * 0.5f, 0));
-		U = glm::scale(U, uLegS);
-		drawUnit(U);
-
-		glm::mat4 L = base;
-		L = glm::translate(L, glm::vec3(-hipX, hipY, 0));
-		L = rotX_deg(L, hipL);
-		L = glm::translate(L, glm::vec3(0, -uLegS.y, 0));
-		L = rotX_deg(L, kneeL);
-		L = glm::translate(L, glm::vec3(0, -lLegS.y * 0.56f, 0));
-		L = glm::scale(L, lLegS);
-		drawUnit(L);
+
+	// Skins live on unit 2 (0: earth, 1: shadow map)
+	glsActiveTexture(GL_TEXTURE2);
+	g_skins.init(SKIN_SIZE, SKIN_SIZE, SKIN_COUNT);
+	std::vector<unsigned char> rgba((size_t)SKIN_SIZE * SKIN_SIZE * 4);
+	for (int i = 0; i < SKIN_COUNT; i++) {
+		makeSkin(i, &rgba[0]);
+		g_skins.add(&rgba[0]);
 	}
+	glsActiveTexture(GL_TEXTURE0);
+	glsUniform1i(glGetUniformLocation(programID, "skinTextures"), 2);
+
+	g_swimmers.reserve(g_crowdSize);
+	for (int i = 0; i < g_crowdSize; i++) spawnSwimmer();
+	// Filled per snapshot (takeSnapshot)
+	glGenBuffers(1, &bufferCrowd);
 }
 
-// ---------- OpenGL init ----------
-void init()
+// Simulation thread: the '+' / '-' requests. Removals walk the crowd by the
+// golden ratio, so they come from all over it rather than the end.
+static bool applyCrowdEdits()
 {
-	colorcube();
+	int edit = g_crowdEdit.exchange(0, std::memory_order_relaxed);
+	if (edit == 0) return false;
+	for (; edit > 0; edit--) spawnSwimmer();
+	for (; edit < 0 && !g_swimmers.empty(); edit++) {
+		const size_t row = (size_t)(fmod(g_crowdRemoved++ * 0.618034, 1.0) * g_swimmers.size());
+		g_swimmers.destroy(g_swimmers.handle(row));
+	}
+	return true;
+}
 
-	// ----- build shader program -----
-	programID = InitShader("src/vshader.glsl", "src/fshader.glsl");
-	glUseProgram(programID);
+// ---------- Skinned body ----------
+// The welded unit cube and a head sphere, scaled by the limb sizes. Normals
+// take the inverse scale so the bone matrices can stay rigid. LOD 0 is the
+// crowd's body with a 20x20 head (VATs and impostors are baked from it),
+// LOD 1 the main swimmer's with the original 40x40 one.
+enum { BODY_LOD_CROWD, BODY_LOD_MAIN };
 
-	// attribute/uniform locations
-	GLuint vPosition = glGetAttribLocation(programID, "vPosition");
-	GLuint vNormal = glGetAttribLocation(programID, "vNormal");
-	GLuint vColor = glGetAttribLocation(programID, "vColor");
-	GLuint vTexCoord = glGetAttribLocation(programID, "vTexCoord");
-	GLint  textureModeID = glGetUniformLocation(programID, "isTexture");
-	GLint  samplerID = glGetUniformLocation(programID, "sphereTexture");
+static void appendBody(MeshData& out, int headSegments)
+{
+	MeshData parts;
+	bakeCube(parts);
+	GenMesh head;
+	genUVSphere(head, headSegments, headSegments);
+	appendMeshLod(parts, head.positions.data(), head.normals.data(), NULL, head.texCoords.data(),
+		head.vertexCount(), head.indices.data(), head.indices.size(), 1e30f);
+	for (size_t i = parts.colors.size() - head.vertexCount(); i < parts.colors.size(); i++)
+		parts.colors[i] = glm::vec4(1.0f, 0.8f, 0.6f, 1.0f);
+
+	MeshData body;
+	for (int bone = 0; bone < PART_COUNT; bone++) {
+		const MeshLod& src = parts.lods[bone == PART_HEAD ? 1 : 0];
+		const glm::vec3 size = k_partSize[bone];
+		const uint32_t first = (uint32_t)body.positions.size();
+		for (uint32_t v = src.firstVertex; v < src.firstVertex + src.vertexCount; v++) {
+			body.positions.push_back(glm::vec4(glm::vec3(parts.positions[v]) * size, 1.0f));
+			body.normals.push_back(glm::vec4(glm::normalize(glm::vec3(parts.normals[v]) / size), 0.0f));
+			body.colors.push_back(parts.colors[v]);
+			body.texCoords.push_back(parts.texCoords[v]);
+			body.bones.push_back((float)bone);
+		}
+		for (uint32_t i = src.firstIndex; i < src.firstIndex + src.indexCount; i++)
+			body.indices.push_back(parts.indices[i] - src.firstVertex + first);
+	}
+	appendMeshLod(out, body.positions.data(), body.normals.data(), body.colors.data(),
+		body.texCoords.data(), body.positions.size(), body.indices.data(), body.indices.size(), 1e30f);
+	out.bones.insert(out.bones.end(), body.bones.begin(), body.bones.end());
+}
 
-	// ----- texture -----
-	GLuint Texture = loadBMP_custom("earth.bmp");
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, Texture);
-	glUniform1i(samplerID, 0);
-	glUniform1i(textureModeID, 1);
+static void bakeBody(MeshData& out)
+{
+	appendBody(out, 20);
+	appendBody(out, 40);
+}
 
-	// ----- cube VAO -----
-	glGenVertexArrays(1, &vaoCube);
-	glBindVertexArray(vaoCube);
+static void instanceAttrib(const char* name, GLint size, size_t offset)
+{
+	GLint loc = glGetAttribLocation(programID, name);
+	if (loc < 0) return;
+	glEnableVertexAttribArray(loc);
+	glVertexAttribPointer(loc, size, GL_FLOAT, GL_FALSE, sizeof(CrowdInstance), BUFFER_OFFSET(offset));
+	if (GLEW_VERSION_3_3) glVertexAttribDivisor(loc, 1);
+	else glVertexAttribDivisorARB(loc, 1);
+}
 
-	glGenBuffers(1, &bufferCube);
-	glBindBuffer(GL_ARRAY_BUFFER, bufferCube);
-	glBufferData(GL_ARRAY_BUFFER,
-		sizeof(points) + sizeof(normals) + sizeof(colors) + sizeof(tcoords),
-		NULL, GL_STATIC_DRAW);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(points), points);
-	glBufferSubData(GL_ARRAY_BUFFER, sizeof(points), sizeof(normals), normals);
-	glBufferSubData(GL_ARRAY_BUFFER, sizeof(points) + sizeof(normals), sizeof(colors), colors);
-	glBufferSubData(GL_ARRAY_BUFFER, sizeof(points) + sizeof(normals) + sizeof(colors), sizeof(tcoords), tcoords);
+// Body streams plus the per-instance CrowdInstance fields from bufferCrowd
+static GLuint makeCrowdVAO(const GLint attribs[MESH_SEMANTIC_COUNT])
+{
+	GLuint vao;
+	glGenVertexArrays(1, &vao);
+	glsBindVertexArray(vao);
+	bindMeshAttribs(g_bodyMesh, attribs);
+	glsBindBuffer(GL_ARRAY_BUFFER, bufferCrowd);
+	instanceAttrib("vSkinLayer", 1, offsetof(CrowdInstance, skinLayer));
+	instanceAttrib("vInstanceOffset", 3, offsetof(CrowdInstance, offset));
+	instanceAttrib("vInstancePhase", 2, offsetof(CrowdInstance, phase));
+	return vao;
+}
 
-	glEnableVertexAttribArray(vPosition);
-	glVertexAttribPointer(vPosition, 4, GL_FLOAT, GL_FALSE, 0, (GLvoid*)(0));
+// std140 image of the shader's AnimClip block
+enum { CLIP_MAX_CHANNELS = 12, CLIP_MAX_KEYS = 16, CLIP_MAX_BONES = 16 };
+struct AnimClipBlock {
+	int32_t segments;
+	float pronePitch;
+	int32_t bobChannel;
+	int32_t pad;
+	glm::vec4 keys[CLIP_MAX_CHANNELS * CLIP_MAX_KEYS / 4];   // channel c, key k: [c * 4 + k / 4][k % 4]
+	glm::vec4 rig[CLIP_MAX_BONES * 3];                       // anchor, mid, tip; w: joint channel or -1
+};
 
-	glEnableVertexAttribArray(vNormal);
-	glVertexAttribPointer(vNormal, 4, GL_FLOAT, GL_FALSE, 0, (GLvoid*)(sizeof(points)));
+static void initClipBlock()
+{
+	static_assert((int)ANIM_CHANNEL_COUNT <= CLIP_MAX_CHANNELS && CLIP_SEGMENTS + 1 <= CLIP_MAX_KEYS &&
+		(int)PART_COUNT <= CLIP_MAX_BONES, "clip does not fit the AnimClip block");
+	AnimClipBlock block;
+	memset(&block, 0, sizeof(block));
+	block.segments = CLIP_SEGMENTS;
+	block.pronePitch = k_pronePitch;
+	block.bobChannel = ANIM_BOB_Y;
+	for (int c = 0; c < ANIM_CHANNEL_COUNT; c++)
+		for (int k = 0; k <= CLIP_SEGMENTS; k++) block.keys[c * 4 + k / 4][k % 4] = k_clip[c][k];
+	for (int i = 0; i < PART_COUNT; i++) {
+		block.rig[i * 3 + 0] = glm::vec4(k_rig[i].anchor, (float)k_rig[i].joint0);
+		block.rig[i * 3 + 1] = glm::vec4(k_rig[i].mid, (float)k_rig[i].joint1);
+		block.rig[i * 3 + 2] = glm::vec4(k_rig[i].tip, -1.0f);
+	}
 
-	glEnableVertexAttribArray(vColor);
-	glVertexAttribPointer(vColor, 4, GL_FLOAT, GL_FALSE, 0, (GLvoid*)(sizeof(points) + sizeof(normals)));
+	glGenBuffers(1, &uboClip);
+	glsBindBuffer(GL_UNIFORM_BUFFER, uboClip);
+	glsBufferData(GL_UNIFORM_BUFFER, sizeof(block), &block, GL_STATIC_DRAW);
+	glsBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glsBindBufferBase(GL_UNIFORM_BUFFER, 0, uboClip);
+	glUniformBlockBinding(programID, glGetUniformBlockIndex(programID, "AnimClip"), 0);
+}
+
+// After initCrowd (the crowd VAO needs bufferCrowd)
+static void initBody(const GLint attribs[MESH_SEMANTIC_COUNT])
+{
+	loadMeshCached("body.mesh", BODY_MESH_KEY, bakeBody, attribs, g_bodyMesh);
+	vaoBody = g_bodyMesh.vao;
+	if (g_crowdSize > 0) vaoBodyCrowd = makeCrowdVAO(attribs);
+
+	glGenBuffers(1, &bufferPalette);
+	glsBindBuffer(GL_TEXTURE_BUFFER, bufferPalette);
+	glGenTextures(1, &texPalette);
+	glsActiveTexture(GL_TEXTURE5);
+	glsBindTexture(GL_TEXTURE_BUFFER, texPalette);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, bufferPalette);
+	glsActiveTexture(GL_TEXTURE0);
+	glsBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	g_boneCountLoc = glGetUniformLocation(programID, "boneCount");
+	g_paletteBaseLoc = glGetUniformLocation(programID, "paletteBase");
+	glsUniform1i(glGetUniformLocation(programID, "bonePalette"), 5);
+	glsUniform1i(g_boneCountLoc, 0);
+
+	g_gpuAnimLoc = glGetUniformLocation(programID, "gpuAnimation");
+	g_animTimeLoc = glGetUniformLocation(programID, "animTime");
+	glsUniform1i(g_gpuAnimLoc, 0);
+	initClipBlock();      // always: the block is active in the program either way
+
+	if (g_crowdAnim == CROWD_ANIM_VAT) {
+		// gl_VertexID is the VAT column, so the body must start at vertex 0
+		if (g_bodyMesh.lod[BODY_LOD_CROWD].firstVertex == 0 &&
+			g_vat.load(g_vatPath, BODY_MESH_KEY, g_bodyMesh.lod[BODY_LOD_CROWD].vertexCount, 6))
+			g_vat.setUniforms(programID);
+		else {
+			printf("VAT: falling back to GPU clip evaluation\n");
+			g_crowdAnim = CROWD_ANIM_CLIP;
+		}
+	}
+}
 
-	glEnableVertexAttribArray(vTexCoord);
-	glVertexAttribPointer(vTexCoord, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)(sizeof(points) + sizeof(normals) + sizeof(colors)));
+// g_palette, then count more matrices from tail
+static void uploadPalette(const glm::mat4* tail = NULL, size_t count = 0)
+{
+	// Orphan, then fill: the previous frame's palette may still be in use
+	const size_t head = g_palette.size() * sizeof(glm::mat4);
+	const GLsizeiptr bytes = (GLsizeiptr)(head + count * sizeof(glm::mat4));
+	glsBindBuffer(GL_TEXTURE_BUFFER, bufferPalette);
+	glsBufferData(GL_TEXTURE_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+	glsBufferSubData(GL_TEXTURE_BUFFER, 0, head, &g_palette[0][0][0]);
+	if (count) glsBufferSubData(GL_TEXTURE_BUFFER, head, count * sizeof(glm::mat4), &tail[0][0][0]);
+	glsBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
 
-	// ----- sphere VAO -----
-	g_sphereVertCount = static_cast<int>(g_sphere.verts.size());
+// The main swimmer's pose is g_pose, followed by the snapshot's crowd bones
+// (CPU animation). Otherwise only the main swimmer (also the shadow caster).
+static void updatePalette()
+{
+	PROFILE_ZONE("updatePalette");
+	g_palette.resize(PART_COUNT);
+	for (int b = 0; b < PART_COUNT; b++) g_palette[b] = g_pose.bone[b];
+	const std::vector<glm::mat4>& crowd = g_frame->crowdBones;
+	uploadPalette(crowd.empty() ? NULL : &crowd[0], crowd.size());
+}
 
-	glGenVertexArrays(1, &vaoSphere);
-	glBindVertexArray(vaoSphere);
+// count swimmers starting at palette slot first, in one draw
+static void recordBody(CommandBuffer& cb, GLuint vao, int lod, int first, int count)
+{
+	cb.bindVertexArray(vao);
+	cb.uniform1i(g_boneCountLoc, PART_COUNT);
+	cb.uniform1i(g_paletteBaseLoc, first);
+	cb.drawElementsInstanced(GL_TRIANGLES, g_bodyMesh.lod[lod].indexCount, g_bodyMesh.indexType,
+		indexOffset(g_bodyMesh, lod), count);
+	cb.uniform1i(g_boneCountLoc, 0);
+}
 
-	glGenBuffers(1, &bufferSphere);
-	glBindBuffer(GL_ARRAY_BUFFER, bufferSphere);
+// Wrapped hourly so the float keeps sub-millisecond precision
+static inline float crowdAnimTime()
+{
+	return (float)fmod(g_timeSec, 3600.0);
+}
 
-	int vertSize = sizeof(g_sphere.verts[0]) * g_sphere.verts.size();
-	int normalSize = sizeof(g_sphere.normals[0]) * g_sphere.normals.size();
-	int texSize = sizeof(g_sphere.texCoords[0]) * g_sphere.texCoords.size();
+// The mesh members; the impostors have their own program (drawImpostors)
+static void recordCrowd(CommandBuffer& cb)
+{
+	PROFILE_ZONE("recordCrowd");
+	if (g_crowdSize <= 0) return;
+	const int count = (int)g_frame->crowdNear.size();
+	if (g_impOn) {
+		const ImpostorSettings& s = g_impostors.config();
+		cb.uniform2f(g_lodFadeLoc, s.distance - s.fadeRange, s.distance);
+	}
+	cb.uniform1i(g_textureModeLoc, 2);
+	if (count > 0 && g_crowdAnim != CROWD_ANIM_CPU) {
+		cb.uniform1i(g_gpuAnimLoc, g_crowdAnim);
+		cb.uniform1f(g_animTimeLoc, crowdAnimTime());
+		recordBody(cb, vaoBodyCrowd, BODY_LOD_CROWD, 0, count);
+		cb.uniform1i(g_gpuAnimLoc, 0);
+	}
+	else if (count > 0) recordBody(cb, vaoBodyCrowd, BODY_LOD_CROWD, 1, count);
+	cb.uniform1i(g_textureModeLoc, 1);
+	if (g_impOn) cb.uniform2f(g_lodFadeLoc, 0.0f, 0.0f);
+}
 
-	std::vector<glm::vec4> sphereColors(
-		g_sphere.verts.size(), glm::vec4(1.0f, 0.8f, 0.6f, 1.0f));
-	int colorSize = sizeof(sphereColors[0]) * sphereColors.size();
+static void drawImpostors(const glm::vec3& eye)
+{
+	if (g_impOn) g_impostors.draw(vaoImpostor, (int)g_frame->crowdFar.size(), projectMat, viewMat, eye, crowdAnimTime());
+}
 
-	glBufferData(GL_ARRAY_BUFFER,
-		vertSize + normalSize + colorSize + texSize,
-		NULL, GL_STATIC_DRAW);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, vertSize, g_sphere.verts.data());
-	glBufferSubData(GL_ARRAY_BUFFER, vertSize, normalSize, g_sphere.normals.data());
-	glBufferSubData(GL_ARRAY_BUFFER, vertSize + normalSize, colorSize, sphereColors.data());
-	glBufferSubData(GL_ARRAY_BUFFER, vertSize + normalSize + colorSize, texSize, g_sphere.texCoords.data());
+// ---------- Impostors ----------
+// Bounds of the body over the whole cycle, relative to its root: the part
+// boxes (unit cubes, the head a unit sphere) through the limb transforms.
+static void swimmerBounds(glm::vec3& center, float& radius)
+{
+	const int samples = 64;
+	glm::vec3 lo(1e30f), hi(-1e30f);
+	std::vector<glm::vec3> corners;
+	ManPose pose;
+	for (int t = 0; t < samples; t++) {
+		poseManAt((float)t / samples, pose);
+		for (int b = 0; b < PART_COUNT; b++) {
+			const float e = b == PART_HEAD ? 1.0f : 0.5f;
+			for (int c = 0; c < 8; c++) {
+				glm::vec3 p(pose.part[b] * glm::vec4(c & 1 ? e : -e, c & 2 ? e : -e, c & 4 ? e : -e, 1.0f));
+				lo = glm::min(lo, p);
+				hi = glm::max(hi, p);
+				corners.push_back(p);
+			}
+		}
+	}
+	center = (lo + hi) * 0.5f;
+	radius = 0.0f;
+	for (size_t i = 0; i < corners.size(); i++) radius = fmaxf(radius, glm::length(corners[i] - center));
+}
 
-	glEnableVertexAttribArray(vPosition);
-	glVertexAttribPointer(vPosition, 4, GL_FLOAT, GL_FALSE, 0, (GLvoid*)(0));
+// Bake callback: the palette holds one pose per phase (see initImpostors)
+static void drawImpostorPhase(int phase, GLuint program)
+{
+	glsUniform1i(glGetUniformLocation(program, "bonePalette"), 5);
+	glsUniform1i(glGetUniformLocation(program, "boneCount"), PART_COUNT);
+	glsUniform1i(glGetUniformLocation(program, "paletteBase"), phase);
+	glsBindVertexArray(vaoBody);
+	glsDrawElements(GL_TRIANGLES, g_bodyMesh.lod[BODY_LOD_CROWD].indexCount, g_bodyMesh.indexType,
+		meshLodIndexOffset(g_bodyMesh, BODY_LOD_CROWD));
+}
 
-	glEnableVertexAttribArray(vNormal);
-	glVertexAttribPointer(vNormal, 4, GL_FLOAT, GL_FALSE, 0, (GLvoid*)(vertSize));
+// After initBody and the lighting uniforms (the impostor program copies them)
+static void initImpostors()
+{
+	if (g_crowdSize <= 0 || g_impSettings.distance <= 0.0f) return;
+
+	glm::vec3 center;
+	float radius;
+	swimmerBounds(center, radius);
+	g_impOn = g_impostors.init(g_impSettings, programID, center, radius, 8, 2);
+	if (!g_impOn) return;
+
+	g_palette.resize((size_t)g_impostors.config().phases * PART_COUNT);
+	ManPose pose;
+	for (int p = 0; p < g_impostors.config().phases; p++) {
+		poseManAt((float)p / g_impostors.config().phases, pose);
+		for (int b = 0; b < PART_COUNT; b++) g_palette[(size_t)p * PART_COUNT + b] = pose.bone[b];
+	}
+	uploadPalette();
+	g_impostors.bake(drawImpostorPhase);
+
+	glGenBuffers(1, &bufferImpostor);
+	glGenVertexArrays(1, &vaoImpostor);
+	glsBindVertexArray(vaoImpostor);
+	glsBindBuffer(GL_ARRAY_BUFFER, bufferImpostor);
+	instanceAttrib("vSkinLayer", 1, offsetof(CrowdInstance, skinLayer));
+	instanceAttrib("vInstanceOffset", 3, offsetof(CrowdInstance, offset));
+	instanceAttrib("vInstancePhase", 2, offsetof(CrowdInstance, phase));
+	glsBindVertexArray(0);
+	g_lodFadeLoc = glGetUniformLocation(programID, "lodFade");
+}
 
-	glEnableVertexAttribArray(vColor);
-	glVertexAttribPointer(vColor, 4, GL_FLOAT, GL_FALSE, 0, (GLvoid*)(vertSize + normalSize));
+static void streamInstances(GLuint buffer, const std::vector<CrowdInstance>& list)
+{
+	glsBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glsBufferData(GL_ARRAY_BUFFER, list.size() * sizeof(CrowdInstance), NULL, GL_STREAM_DRAW);
+	if (!list.empty()) glsBufferSubData(GL_ARRAY_BUFFER, 0, list.size() * sizeof(CrowdInstance), list.data());
+}
 
-	glEnableVertexAttribArray(vTexCoord);
-	glVertexAttribPointer(vTexCoord, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)(vertSize + normalSize + colorSize));
+// ---------- Crowd pipeline ----------
+static glm::mat4 projectionFor(float aspect)
+{
+	return glm::perspective(glm::radians(65.0f), aspect, 0.1f, 100.0f);
+}
+
+// Planes of the clip volume of m; xyz: inward unit normal, w: offset
+static void frustumPlanes(const glm::mat4& m, glm::vec4 planes[6])
+{
+	const glm::mat4 rows = glm::transpose(m);
+	for (int i = 0; i < 3; i++) {
+		planes[i * 2 + 0] = rows[3] + rows[i];
+		planes[i * 2 + 1] = rows[3] - rows[i];
+	}
+	for (int i = 0; i < 6; i++) planes[i] /= glm::length(glm::vec3(planes[i]));
+}
+
+// Cull: each member's cycle bounds against the frustum, then the impostor
+// split. Mesh when d < D, impostor when d > D - F: both in the fade band.
+static void cullCrowd(const CrowdBuild& b, int begin, int end)
+{
+	PROFILE_ZONE("cullCrowd");
+	const glm::vec4* planes = b.planes;
+	const glm::vec3& eye = b.f->eye;
+	const float meshEnd = g_impOn ? g_impostors.config().distance : 1e30f;
+	const float impStart = g_impOn ? meshEnd - g_impostors.config().fadeRange : 1e30f;
+	const SwimmerRoot* root = g_swimmers.column<SwimmerRoot>();
+	for (int i = begin; i < end; i++) {
+		const glm::vec3 c = root[i].position + g_crowdCenter;
+		bool visible = true;
+		for (int p = 0; p < 6 && visible; p++)
+			visible = glm::dot(glm::vec3(planes[p]), c) + planes[p].w >= -g_crowdRadius;
+		unsigned char cls = 0;
+		if (visible) {
+			const float d = glm::distance(eye, root[i].position);
+			if (d < meshEnd) cls |= CROWD_MESH;
+			if (d > impStart) cls |= CROWD_IMPOSTOR;
+		}
+		b.cls[i] = cls;
+	}
+}
+
+static inline CrowdInstance packInstance(int i)
+{
+	CrowdInstance c;
+	c.offset = g_swimmers.column<SwimmerRoot>()[i].position;
+	c.skinLayer = g_swimmers.column<SwimmerLook>()[i].skinLayer;
+	c.phase = g_swimmers.column<SwimmerAnim>()[i].phase;
+	c.cycle = g_swimmers.column<SwimmerAnim>()[i].cycle;
+	return c;
+}
+
+static void sampleCrowd(const CrowdBuild& b, int begin, int end)
+{
+	PROFILE_ZONE("sampleCrowd");
+	const std::vector<CrowdInstance>& crowd = b.f->crowdNear;
+	for (int i = begin; i < end; i++)
+		sampleClip(cycleAt(b.timeSec + crowd[i].phase, crowd[i].cycle), &b.channels[(size_t)i * ANIM_CHANNEL_COUNT]);
+}
+
+static void poseCrowd(const CrowdBuild& b, int begin, int end)
+{
+	PROFILE_ZONE("poseCrowd");
+	const std::vector<CrowdInstance>& crowd = b.f->crowdNear;
+	std::vector<glm::mat4>& bones = b.f->crowdBones;
+	ManPose pose;
+	for (int i = begin; i < end; i++) {
+		poseFromChannels(&b.channels[(size_t)i * ANIM_CHANNEL_COUNT], pose);
+		const glm::mat4 root = glm::translate(glm::mat4(1.0f), crowd[i].offset);
+		for (int b = 0; b < PART_COUNT; b++) bones[(size_t)i * PART_COUNT + b] = root * pose.bone[b];
+	}
+}
+
+// Fill f's draw lists (and bones) for its camera; returns when all stages ran
+static void buildCrowd(FrameSnapshot& f, float aspect)
+{
+	PROFILE_ZONE("buildCrowd");
+	f.crowdNear.clear();
+	f.crowdFar.clear();
+	f.crowdBones.clear();
+	const int n = (int)g_swimmers.size();
+	if (n == 0) return;
+
+	CrowdBuild b;
+	b.f = &f;
+	b.arena = &frameArena();
+	frustumPlanes(projectionFor(aspect) * f.view, b.planes);
+	b.timeSec = f.curr.timeSec;
+	b.count = n;
+	b.cls = b.arena->allocArray<unsigned char>(n);
+	b.channels = NULL;
+
+	CrowdBuild* job = &b;
+	Task* cull = g_tasks.parallelFor(0, n, CULL_GRAIN, [job](int lo, int hi) { cullCrowd(*job, lo, hi); });
+	Task* build = g_tasks.create([job] {
+		FrameSnapshot& f = *job->f;
+		for (int i = 0; i < job->count; i++) {
+			if (!job->cls[i]) continue;
+			const CrowdInstance c = packInstance(i);
+			if (job->cls[i] & CROWD_MESH) f.crowdNear.push_back(c);
+			if (job->cls[i] & CROWD_IMPOSTOR) f.crowdFar.push_back(c);
+		}
+		const int m = (int)f.crowdNear.size();
+		if (g_crowdAnim != CROWD_ANIM_CPU || m == 0) return;
+		job->channels = job->arena->allocArray<float>((size_t)m * ANIM_CHANNEL_COUNT);
+		f.crowdBones.resize((size_t)m * PART_COUNT);
+		Task* sample = g_tasks.parallelFor(0, m, SAMPLE_GRAIN, [job](int lo, int hi) { sampleCrowd(*job, lo, hi); });
+		Task* fk = g_tasks.parallelFor(0, m, FK_GRAIN, [job](int lo, int hi) { poseCrowd(*job, lo, hi); });
+		g_tasks.depend(fk, sample);
+		g_tasks.submit(fk, &job->done);
+		g_tasks.submit(sample, &job->done);
+	});
+	g_tasks.depend(build, cull);
+	g_tasks.submit(build, &b.done);
+	g_tasks.submit(cull, &b.done);
+	g_tasks.wait(b.done);
+}
+
+// ---------- Shadows ----------
+static void drawShadowCaster(int userId, GLint modelLoc)
+{
+	g_passCmds.clear();
+	if (userId == CASTER_FLOOR) recordUnit(g_passCmds, modelLoc, g_floorMat);
+	else recordManPose(g_passCmds, modelLoc, g_pose);
+	g_replayer.replay(g_passCmds);
+}
+
+static void initShadows(GLuint vPosition)
+{
+	g_shadowsOn = g_shadow.init(g_shadowSettings, vPosition);
+	if (!g_shadowsOn) return;
+
+	g_shadow.addCaster(true, CASTER_FLOOR, 7.1f);
+	g_manCaster = g_shadow.addCaster(false, CASTER_MAN, 1.6f);
+	g_shadow.setLight(glm::normalize(g_lightPos) * 12.0f, glm::vec3(0.0f),
+		6.0f, 0.1f, 30.0f);
+
+	glsActiveTexture(GL_TEXTURE1);
+	glsBindTexture(GL_TEXTURE_2D, g_shadow.depthTexture());
+	glsActiveTexture(GL_TEXTURE0);
+	glsUniform1i(glGetUniformLocation(programID, "shadowMap"), 1);
+	glsUniformMatrix4fv(lightViewProjID, 1, GL_FALSE, &g_shadow.lightViewProj()[0][0]);
+}
+
+// Print the shadow pass cost about once a second, separate from the frame
+static void reportShadowStats()
+{
+	int now = glutGet(GLUT_ELAPSED_TIME);
+	if (now - g_statsPrevMS < 1000) return;
+	g_statsPrevMS = now;
+
+	const ShadowStats& s = g_shadow.stats();
+	printf("shadow pass: %.3f ms GPU, %.3f ms CPU | %d frames, %d static / %d far refreshes\n",
+		s.gpuMs, s.cpuMs, s.frames, s.staticRedraws, s.farRedraws);
+	g_shadow.resetStats();
+}
+
+// ---------- Virtual texture ----------
+static void drawVirtualTextured(GLint modelLoc)
+{
+	g_passCmds.clear();
+	recordSphereUnit(g_passCmds, modelLoc, g_pose.part[PART_HEAD]);
+	g_replayer.replay(g_passCmds);
+}
+
+static void reportVTStats()
+{
+	int now = glutGet(GLUT_ELAPSED_TIME);
+	if (now - g_vtStatsPrevMS < 1000) return;
+	g_vtStatsPrevMS = now;
+
+	const VTStats& s = g_vt.stats();
+	printf("virtual texture: %d tiles wanted, %d resident | %d uploads, %d evictions, %d misses, %.1f MB GPU\n",
+		s.requested, s.resident, s.uploads, s.evictions, s.misses, g_vt.gpuBytes() / 1048576.0);
+	g_vt.resetStats();
+}
+
+// ---------- OpenGL init ----------
+void init()
+{
+	// ----- build shader program -----
+	programID = InitShader("src/vshader.glsl", "src/fshader.glsl");
+	glsUseProgram(programID);
+
+	// attribute/uniform locations
+	GLuint vPosition = glGetAttribLocation(programID, "vPosition");
+	GLuint vNormal = glGetAttribLocation(programID, "vNormal");
+	GLuint vColor = glGetAttribLocation(programID, "vColor");
+	GLuint vTexCoord = glGetAttribLocation(programID, "vTexCoord");
+	GLint  textureModeID = glGetUniformLocation(programID, "isTexture");
+	GLint  samplerID = glGetUniformLocation(programID, "sphereTexture");
+	g_modelLoc = glGetUniformLocation(programID, "mModel");
+	g_textureModeLoc = textureModeID;
+
+	// ----- texture -----
+	// Prefer the block-compressed asset from tools/texcompress when present.
+	// Loaded in the background; a placeholder is bound until it has streamed in.
+	g_textures.init();
+	g_earthTex = g_textures.request("earth.dds", "earth.bmp");
+	glsActiveTexture(GL_TEXTURE0);
+	glsBindTexture(GL_TEXTURE_2D, g_textures.texture(g_earthTex));
+	glsUniform1i(samplerID, 0);
+	glsUniform1i(textureModeID, 1);
+
+	// ----- meshes -----
+	// Mapped from cube.mesh / sphere.mesh and uploaded without parsing;
+	// generated and written on the first run (or when a generator changes).
+	const GLint meshAttribs[MESH_SEMANTIC_COUNT] = {
+		(GLint)vPosition, (GLint)vNormal, (GLint)vColor, (GLint)vTexCoord,
+		glGetAttribLocation(programID, "vBone")
+	};
+	loadMeshCached("cube.mesh", CUBE_MESH_KEY, bakeCube, meshAttribs, g_cubeMesh);
+	loadMeshCached("sphere.mesh", SPHERE_MESH_KEY, bakeSphere, meshAttribs, g_sphereMesh);
+	vaoCube = g_cubeMesh.vao;
+	vaoSphere = g_sphereMesh.vao;
+
+	initCrowd();
+	initBody(meshAttribs);
 
 	// ----- uniforms -----
 	projectMatrixID = glGetUniformLocation(programID, "mProject");
@@ -373,55 +1018,64 @@ void init()
 	materialSpecularID = glGetUniformLocation(programID, "materialSpecular");
 	materialShininessID =
 		glGetUniformLocation(programID, "materialShininess");
+	lightViewProjID = glGetUniformLocation(programID, "mLightViewProj");
 
 	// projection matrix
-	projectMat = glm::perspective(glm::radians(65.0f),
-		1.0f, 0.1f, 100.0f);
-	glUniformMatrix4fv(projectMatrixID, 1, GL_FALSE, &projectMat[0][0]);
+	projectMat = projectionFor(1.0f);
+	glsUniformMatrix4fv(projectMatrixID, 1, GL_FALSE, &projectMat[0][0]);
 
 	// default view (applyCamera ÿ֡Ḳ)
 	viewMat = glm::lookAt(glm::vec3(3.0f, 0.6f, 1.2f),
 		glm::vec3(0, 0, 0),
 		glm::vec3(0, 1, 0));
-	glUniformMatrix4fv(viewMatrixID, 1, GL_FALSE, &viewMat[0][0]);
+	glsUniformMatrix4fv(viewMatrixID, 1, GL_FALSE, &viewMat[0][0]);
 
 	// lighting setup
-	glm::vec3 lightPos(2.0f, 3.0f, 2.0f);
-	glUniform3fv(lightPosID, 1, &lightPos[0]);
+	glsUniform3fv(lightPosID, 1, &g_lightPos[0]);
 
 	glm::vec3 La(0.2f, 0.2f, 0.2f);
 	glm::vec3 Ld(1.0f, 1.0f, 1.0f);
 	glm::vec3 Ls(1.0f, 1.0f, 1.0f);
-	glUniform3fv(lightAmbientID, 1, &La[0]);
-	glUniform3fv(lightDiffuseID, 1, &Ld[0]);
-	glUniform3fv(lightSpecularID, 1, &Ls[0]);
+	glsUniform3fv(lightAmbientID, 1, &La[0]);
+	glsUniform3fv(lightDiffuseID, 1, &Ld[0]);
+	glsUniform3fv(lightSpecularID, 1, &Ls[0]);
 
 	glm::vec3 Ma(0.2f, 0.2f, 0.2f);
 	glm::vec3 Md(0.8f, 0.8f, 0.8f);
 	glm::vec3 Ms(0.8f, 0.8f, 0.8f);
-	glUniform3fv(materialAmbientID, 1, &Ma[0]);
-	glUniform3fv(materialDiffuseID, 1, &Md[0]);
-	glUniform3fv(materialSpecularID, 1, &Ms[0]);
-	glUniform1f(materialShininessID, 32.0f);
+	glsUniform3fv(materialAmbientID, 1, &Ma[0]);
+	glsUniform3fv(materialDiffuseID, 1, &Md[0]);
+	glsUniform3fv(materialSpecularID, 1, &Ms[0]);
+	glsUniform1f(materialShininessID, 32.0f);
+
+	glsEnable(GL_DEPTH_TEST);
+	glsClearColor(0.0, 0.0, 0.0, 1.0);
 
-	glEnable(GL_DEPTH_TEST);
-	glClearColor(0.0, 0.0, 0.0, 1.0);
+	initShadows(vPosition);
+	glsUniform1i(glGetUniformLocation(programID, "useShadows"), g_shadowsOn ? 1 : 0);
 
-	g_prevMS = glutGet(GLUT_ELAPSED_TIME);
+	// Units 3 and 4: page table and page cache
+	if (g_vtPath) g_vtOn = g_vt.init(g_vtPath, g_vtSettings, programID, 3);
+	if (g_vtOn) g_vt.setUniforms(programID);
+
+	// Units 8 and 9: impostor atlas
+	initImpostors();
+
+	g_statsPrevMS = glutGet(GLUT_ELAPSED_TIME);
 }
 
 // ---------- Camera control ----------
-static inline void applyCamera()
+// Simulation thread: eye and view matrix of a camera mode
+static inline void cameraFor(int camMode, glm::vec3& eye, glm::mat4& view)
 {
-    glm::vec3 eye;
     glm::vec3 center(0.0f, 0.0f, 0.0f);
     glm::vec3 up(0.0f, 1.0f, 0.0f);
 
-    if (g_camMode == 1) {
+    if (camMode == 1) {
         // Side view
         eye = glm::vec3(5.0f, 0.0f, 0.0f);
     }
-    else if (g_camMode == 2) {
+    else if (camMode == 2) {
         // Over-the-shoulder: slightly above & right behind
         eye = glm::vec3(0.5f, 1.5f, 3.0f);
         center = glm::vec3(0.0f, 0.1f, 0.0f);
@@ -431,38 +1085,248 @@ static inline void applyCamera()
         eye = glm::vec3(0.0f, 0.5f, -3.2f);
     }
 
-    viewMat = glm::lookAt(eye, center, up);
-    glUniformMatrix4fv(viewMatrixID, 1, GL_FALSE, &viewMat[0][0]);
-    glUniform3fv(viewPosID, 1, &eye[0]);
+    view = glm::lookAt(eye, center, up);
 }
 
-// ---------- Display ----------
-void display(void)
+// GL thread: the snapshot's camera
+static inline void applyCamera(const FrameSnapshot& f)
+{
+    PROFILE_ZONE("applyCamera");
+    viewMat = f.view;
+    glsUniformMatrix4fv(viewMatrixID, 1, GL_FALSE, &viewMat[0][0]);
+    glsUniform3fv(viewPosID, 1, &f.eye[0]);
+}
+
+// ---------- Simulation thread ----------
+static void simStep(double timeSec)
+{
+	PROFILE_THREAD("simulation");   // the GL thread's first calls keep its name
+	PROFILE_ZONE("simStep");
+	g_simPrev = g_simCurr;
+	g_simCurr.timeSec = timeSec;
+	poseMan(timeSec, g_simCurr.pose);
+}
+
+static void publishFrame(SimThread::Clock::time_point stepWall, bool stepped)
+{
+	// Paused: only a camera change or a crowd edit is worth a snapshot
+	const int camMode = g_camMode.load(std::memory_order_relaxed);
+	const float aspect = g_aspect.load(std::memory_order_relaxed);
+	const bool edited = applyCrowdEdits();
+	if (!stepped && !edited && camMode == g_publishedCamMode && aspect == g_publishedAspect) return;
+
+	PROFILE_ZONE("publishFrame");
+	beginFrameArena();
+	HeapAllocCheck allocCheck("publishFrame", steadyFor(1.0));
+	FrameSnapshot& f = g_frames.writeSlot();
+	f.seq = ++g_publishSeq;
+	f.stepWall = stepWall;
+	f.prev = g_simPrev;
+	f.curr = g_simCurr;
+	f.camMode = camMode;
+	cameraFor(camMode, f.eye, f.view);
+	buildCrowd(f, aspect);
+	f.published = SimThread::Clock::now();
+	g_frames.publish();
+
+	g_publishedCamMode = camMode;
+	g_publishedAspect = aspect;
+	if (!stepped) g_pacer.invalidate();
+}
+
+// The first snapshot is published here, so display always has one
+static void initSim()
+{
+	g_tasks.init(g_taskThreads);
+	swimmerBounds(g_crowdCenter, g_crowdRadius);
+	markChanged();
+	simStep(0.0);
+	g_simPrev = g_simCurr;
+	publishFrame(SimThread::Clock::now(), true);
+	g_simThread.start(g_simSettings, simStep, publishFrame, g_pacerSettings.pollMs);
+}
+
+// ---------- Snapshots (GL thread) ----------
+// Take the newest snapshot if there is one; its crowd lists go to the
+// instance buffers only when it is new.
+static void takeSnapshot()
+{
+	PROFILE_ZONE("takeSnapshot");
+	if (!g_frames.acquire()) {
+		g_snapStats.reused++;
+		return;
+	}
+	const uint64_t prevSeq = g_frame ? g_frame->seq : 0;
+	g_frame = &g_frames.readSlot();
+	const double age = std::chrono::duration<double, std::milli>(SimThread::Clock::now() - g_frame->published).count();
+	g_snapStats.taken++;
+	g_snapStats.skipped += (int)(g_frame->seq - prevSeq - 1);
+	g_snapStats.ageSumMs += age;
+	if (age > g_snapStats.ageMaxMs) g_snapStats.ageMaxMs = age;
+
+	if (g_crowdSize > 0) streamInstances(bufferCrowd, g_frame->crowdNear);
+	if (g_impOn) streamInstances(bufferImpostor, g_frame->crowdFar);
+}
+
+static void reportSimStats()
+{
+	int now = glutGet(GLUT_ELAPSED_TIME);
+	if (now - g_simStatsPrevMS < 1000) return;
+	g_simStatsPrevMS = now;
+
+	const SnapshotStats& s = g_snapStats;
+	printf("sim: %d snapshots drawn, %d skipped, %d frames reused one | age at pickup %.2f ms avg, %.2f ms max\n",
+		s.taken, s.skipped, s.reused, s.taken ? s.ageSumMs / s.taken : 0.0, s.ageMaxMs);
+	g_snapStats = SnapshotStats();
+}
+
+static void reportCommandStats()
+{
+	int now = glutGet(GLUT_ELAPSED_TIME);
+	if (now - g_cmdStatsPrevMS < 1000) return;
+	g_cmdStatsPrevMS = now;
+
+	const ReplayStats& s = g_replayer.stats();
+	printf("commands: %d replayed, %d draws | %d state calls issued, %d skipped\n",
+		s.commands, s.draws, s.stateCalls, s.stateSkipped);
+	g_replayer.resetStats();
+}
+
+static void reportGLStats()
+{
+	int now = glutGet(GLUT_ELAPSED_TIME);
+	if (now - g_glStatsPrevMS < 1000) return;
+	g_glStatsPrevMS = now;
+	glStatsPrint("gl frame", glStatsFrame());
+	printf("gl state cache: %llu redundant calls filtered in the last second%s\n",
+		(unsigned long long)(glStateFiltered() - g_glFilteredPrev), g_glCacheOn ? "" : " (off)");
+	g_glFilteredPrev = glStateFiltered();
+}
+
+// ---------- Main pass recording ----------
+// Scene (floor and main swimmer) and crowd, one task each into their own
+// buffer. Everything they read is final for the frame before they start.
+// With --threads 1 there is no worker to run them and the GL thread records
+// them itself.
+static void recordScene(CommandBuffer& cb)
+{
+	PROFILE_ZONE("recordScene");
+	cb.clear();
+	recordUnit(cb, g_modelLoc, g_floorMat);
+	// The virtual-textured head needs its own draw; otherwise one skinned draw
+	if (g_vtOn) recordManPose(cb, g_modelLoc, g_pose, g_textureModeLoc);
+	else recordBody(cb, vaoBody, BODY_LOD_MAIN, 0, 1);
+}
+
+static void recordCrowdPass()
 {
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	applyCamera();
-	drawMan(g_timeSec);
-	glutSwapBuffers();
+	g_crowdCmds.clear();
+	recordCrowd(g_crowdCmds);
 }
 
-// ---------- Idle (time-based) ----------
-void idle()
+static void recordMainPass(TaskCounter& done)
 {
-	int curr = glutGet(GLUT_ELAPSED_TIME);
-	int dtms = curr - g_prevMS;
-	if (dtms <= 0) return;
-	g_prevMS = curr;
-	g_timeSec += dtms * 0.001; // seconds
-	glutPostRedisplay();
+	if (g_tasks.threadCount() == 1) {
+		recordScene(g_sceneCmds);
+		recordCrowdPass();
+		return;
+	}
+	g_tasks.submit(g_tasks.create([] { recordScene(g_sceneCmds); }), &done);
+	g_tasks.submit(g_tasks.create([] { recordCrowdPass(); }), &done);
+}
+
+// ---------- Display ----------
+void display(void)
+{
+	profilerEndFrame();             // resolves an older frame's GPU zones
+	PROFILE_GPU_ZONE("display");
+	beginFrameArena();
+	HeapAllocCheck allocCheck("display",
+		steadyFor(1.0) && !g_textures.busy() && !(g_vtOn && g_vt.settling()));
+	takeSnapshot();
+	const FrameSnapshot& f = *g_frame;
+	const double sinceStep = std::chrono::duration<double>(SimThread::Clock::now() - f.stepWall).count();
+	const float alpha = (float)glm::clamp(sinceStep / g_simThread.stepSec(), 0.0, 1.0);
+	g_timeSec = f.prev.timeSec + (f.curr.timeSec - f.prev.timeSec) * alpha;
+	lerpPose(f.prev.pose, f.curr.pose, alpha, g_pose);
+	applyCamera(f);
+	const glm::vec3 eye = f.eye;
+	updatePalette();
+	TaskCounter recorded;
+	recordMainPass(recorded);
+
+	g_textures.pump();
+	glsActiveTexture(GL_TEXTURE0);
+	glsBindTexture(GL_TEXTURE_2D, g_textures.texture(g_earthTex));
+
+	if (g_vtOn) g_vt.update(projectMat, viewMat, drawVirtualTextured);
+
+	if (g_shadowsOn) {
+		g_shadow.setCasterCenter(g_manCaster, glm::vec3(g_pose.part[PART_TORSO][3]));
+		g_shadow.update(eye, drawShadowCaster);
+	}
+
+	{
+		PROFILE_GPU_ZONE("main pass");
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		{
+			PROFILE_ZONE("wait for recording");
+			g_tasks.block(recorded);
+		}
+		const CommandBuffer* mainPass[] = { &g_sceneCmds, &g_crowdCmds };
+		g_replayer.replay(mainPass, 2);
+		drawImpostors(eye);
+	}
+	{
+		PROFILE_ZONE("swap");
+		glutSwapBuffers();
+	}
+	glStatsEndFrame();
+
+	if (g_shadowsOn) reportShadowStats();
+	if (g_vtOn) reportVTStats();
+	if (g_simStatsOn) reportSimStats();
+	if (g_cmdStatsOn) reportCommandStats();
+	if (g_glStatsOn) reportGLStats();
+
+	// On-demand pacing: keep drawing until streamed textures have landed
+	if (g_textures.busy() || (g_vtOn && g_vt.settling())) g_pacer.invalidate();
 }
 
 // ---------- Keyboard ----------
+// 'i' prints the profile of the last second, 't' writes what the profiler
+// still holds as a Chrome trace (--trace, default trace.json). Zones are
+// only recorded in builds with PROFILER defined (profiler.h).
+static const char* g_tracePath = "trace.json";
+
 void keyboard(unsigned char key, int, int)
 {
 	switch (key) {
-	case '1': g_camMode = 1; glutPostRedisplay(); break;
-	case '2': g_camMode = 2; glutPostRedisplay(); break;
-	case '3': g_camMode = 3; glutPostRedisplay(); break;
+	// The sim thread picks camera changes up and invalidates the pacer once
+	// the snapshot is out
+	case '1': case '2': case '3':
+		g_camMode = key - '0';
+		markChanged();
+		break;
+	case '+': case '=':
+		if (g_crowdSize > 0) g_crowdEdit += CROWD_EDIT;
+		markChanged();
+		break;
+	case '-':
+		if (g_crowdSize > 0) g_crowdEdit -= CROWD_EDIT;
+		markChanged();
+		break;
+	case 'i': case 'I':
+		profilerPrintSummary();
+		break;
+	case 't': case 'T':
+		profilerWriteTrace(g_tracePath);
+		break;
+	case 'p': case 'P':
+		g_simThread.setPaused(!g_simThread.isPaused());
+		g_pacer.setAnimating(!g_simThread.isPaused());
+		g_pacer.invalidate();
+		break;
 	case 033: // ESC
 	case 'q': case 'Q':
 		exit(EXIT_SUCCESS);
@@ -474,31 +1338,103 @@ void keyboard(unsigned char key, int, int)
 void resize(int w, int h)
 {
 	float ratio = (h > 0) ? (float)w / (float)h : 1.0f;
-	glViewport(0, 0, w, h);
-	projectMat = glm::perspective(glm::radians(65.0f), ratio, 0.1f, 100.0f);
-	glUseProgram(programID);
-	glUniformMatrix4fv(projectMatrixID, 1, GL_FALSE, &projectMat[0][0]);
-	glutPostRedisplay();
+	glsViewport(0, 0, w, h);
+	projectMat = projectionFor(ratio);
+	g_aspect = ratio;
+	markChanged();
+	glsUseProgram(programID);
+	glsUniformMatrix4fv(projectMatrixID, 1, GL_FALSE, &projectMat[0][0]);
+	g_pacer.invalidate();
+}
+
+// ---------- Command line ----------
+// --shadow-res N, --shadow-far-interval N, --shadow-far-dist D, --crowd N,
+// --vt file.vtex, --vt-cache N (pages per side), --anim cpu|gpu, --vat file.vat,
+// --impostors D (eye distance), --impostor-fade F, --pace target|uncapped|demand,
+// --fps N, --pace-stats 1, --sim-hz N, --sim-max-steps N, --sim-stats 1,
+// --threads N (crowd pipeline workers, 0: one per core), --cmd-stats 1,
+// --trace file.json (where 't' writes the profile), --gl-stats 1, --gl-cache 0|1
+static void parseArgs(int argc, char** argv)
+{
+	for (int i = 1; i + 1 < argc; i++) {
+		if (!strcmp(argv[i], "--shadow-res"))
+			g_shadowSettings.resolution = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--shadow-far-interval"))
+			g_shadowSettings.farUpdateInterval = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--shadow-far-dist"))
+			g_shadowSettings.farDistance = (float)atof(argv[++i]);
+		else if (!strcmp(argv[i], "--crowd"))
+			g_crowdSize = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--vt"))
+			g_vtPath = argv[++i];
+		else if (!strcmp(argv[i], "--vt-cache"))
+			g_vtSettings.cacheSide = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--anim"))
+			g_crowdAnim = !strcmp(argv[++i], "gpu") ? CROWD_ANIM_CLIP : CROWD_ANIM_CPU;
+		else if (!strcmp(argv[i], "--vat")) {
+			g_vatPath = argv[++i];
+			g_crowdAnim = CROWD_ANIM_VAT;
+		}
+		else if (!strcmp(argv[i], "--impostors"))
+			g_impSettings.distance = (float)atof(argv[++i]);
+		else if (!strcmp(argv[i], "--impostor-fade"))
+			g_impSettings.fadeRange = (float)atof(argv[++i]);
+		else if (!strcmp(argv[i], "--pace")) {
+			const char* mode = argv[++i];
+			g_pacerSettings.mode = !strcmp(mode, "uncapped") ? PACE_UNCAPPED :
+				!strcmp(mode, "demand") ? PACE_ON_DEMAND : PACE_TARGET;
+		}
+		else if (!strcmp(argv[i], "--fps"))
+			g_pacerSettings.targetFps = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--pace-stats"))
+			g_pacerSettings.reportMs = atoi(argv[++i]) ? 1000.0 : 0.0;
+		else if (!strcmp(argv[i], "--sim-hz"))
+			g_simSettings.stepHz = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--sim-max-steps"))
+			g_simSettings.maxSteps = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--sim-stats"))
+			g_simStatsOn = atoi(argv[++i]) != 0;
+		else if (!strcmp(argv[i], "--threads"))
+			g_taskThreads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--cmd-stats"))
+			g_cmdStatsOn = atoi(argv[++i]) != 0;
+		else if (!strcmp(argv[i], "--trace"))
+			g_tracePath = argv[++i];
+		else if (!strcmp(argv[i], "--gl-stats"))
+			g_glStatsOn = atoi(argv[++i]) != 0;
+		else if (!strcmp(argv[i], "--gl-cache"))
+			g_glCacheOn = atoi(argv[++i]) != 0;
+	}
 }
 
 // ---------- Main ----------
 int main(int argc, char** argv)
 {
+	PROFILE_THREAD("GL");
 	glutInit(&argc, argv);
+	parseArgs(argc, argv);
 	glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE | GLUT_DEPTH);
 	glutInitWindowSize(512, 512);
 	glutInitContextVersion(3, 2);
 	glutInitContextProfile(GLUT_CORE_PROFILE);
+#ifdef GL_STATS
+	glutInitContextFlags(GLUT_DEBUG);     // KHR_debug messages only come to debug contexts
+#endif
 	glutCreateWindow("Cubeman Swim");
 
 	glewInit();
+	glStatsInitDebug();
+	glStateSetFiltering(g_glCacheOn);
 	init();
+	profilerInitGL();
 
 	glutDisplayFunc(display);
 	glutKeyboardFunc(keyboard);
 	glutReshapeFunc(resize);
-	glutIdleFunc(idle);
 
-	glutMainLoop();
+	// Instead of glutMainLoop: sleeps between frames rather than spinning in idle
+	initSim();
+	g_pacer.init(g_pacerSettings);
+	g_pacer.run(NULL);
 	return 0;
 }
@@ -0,0 +1,132 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "dds.h"
+#include <stdio.h>
+#include <string.h>
+
+static BCFormat formatFromDXGI(uint32_t dxgi)
+{
+    // sRGB variants are sampled as UNORM, like the BMP path (the shaders
+    // work in gamma space).
+    switch (dxgi) {
+    case DXGI_FORMAT_BC1_UNORM: case DXGI_FORMAT_BC1_UNORM_SRGB: return BC_FORMAT_BC1;
+    case DXGI_FORMAT_BC3_UNORM: case DXGI_FORMAT_BC3_UNORM_SRGB: return BC_FORMAT_BC3;
+    case DXGI_FORMAT_BC7_UNORM: case DXGI_FORMAT_BC7_UNORM_SRGB: return BC_FORMAT_BC7;
+    default: return BC_FORMAT_NONE;
+    }
+}
+
+static bool fail(const char** error, const char* why)
+{
+    if (error) *error = why;
+    return false;
+}
+
+bool parseDDS(const unsigned char* data, size_t size, DDSImage& out, const char** error)
+{
+    if (size < 4 + sizeof(DDSHeader)) return fail(error, "file too small");
+
+    uint32_t magic;
+    DDSHeader h;
+    memcpy(&magic, data, 4);        // memcpy: the buffer may be unaligned
+    memcpy(&h, data + 4, sizeof(h));
+    if (magic != DDS_MAGIC) return fail(error, "bad magic");
+    if (h.size != sizeof(DDSHeader) || h.ddspf.size != sizeof(DDSPixelFormat))
+        return fail(error, "bad header size");
+    if (!(h.ddspf.flags & DDPF_FOURCC)) return fail(error, "uncompressed DDS not supported");
+    if (h.caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME)) return fail(error, "cube/volume textures not supported");
+
+    size_t offset = 4 + sizeof(DDSHeader);
+    BCFormat format = BC_FORMAT_NONE;
+    switch (h.ddspf.fourCC) {
+    case DDS_FOURCC('D', 'X', 'T', '1'): format = BC_FORMAT_BC1; break;
+    case DDS_FOURCC('D', 'X', 'T', '5'): format = BC_FORMAT_BC3; break;
+    case DDS_FOURCC('D', 'X', '1', '0'): {
+        if (size < offset + sizeof(DDSHeaderDX10)) return fail(error, "truncated DX10 header");
+        DDSHeaderDX10 dx10;
+        memcpy(&dx10, data + offset, sizeof(dx10));
+        offset += sizeof(dx10);
+        if (dx10.resourceDimension != DDS_DIMENSION_TEXTURE2D) return fail(error, "not a 2D texture");
+        if (dx10.arraySize > 1) return fail(error, "texture arrays not supported");
+        format = formatFromDXGI(dx10.dxgiFormat);
+        break;
+    }
+    default: break;
+    }
+    if (format == BC_FORMAT_NONE) return fail(error, "unsupported pixel format");
+
+    if (h.width == 0 || h.height == 0 || h.width > 16384 || h.height > 16384)
+        return fail(error, "bad dimensions");
+
+    int maxLevels = 1;
+    for (uint32_t d = h.width > h.height ? h.width : h.height; d > 1; d >>= 1) maxLevels++;
+    int levels = 1;
+    if ((h.flags & DDSD_MIPMAPCOUNT) && h.mipMapCount > 0) levels = (int)h.mipMapCount;
+    if (levels > maxLevels || levels > DDS_MAX_LEVELS) return fail(error, "bad mip count");
+
+    out.format = format;
+    out.width = (int)h.width;
+    out.height = (int)h.height;
+    out.levelCount = levels;
+    int w = out.width, hh = out.height;
+    for (int i = 0; i < levels; i++) {
+        size_t bytes = bcLevelSize(format, w, hh);
+        if (bytes > size - offset) return fail(error, "truncated mip data");
+        out.level[i] = data + offset;
+        out.levelSize[i] = bytes;
+        offset += bytes;
+        w = w > 1 ? w / 2 : 1;
+        hh = hh > 1 ? hh / 2 : 1;
+    }
+    return true;
+}
+
+bool writeDDS(const char* path, BCFormat format, int width, int height,
+              int levelCount, const unsigned char* const* levels)
+{
+    if (format == BC_FORMAT_NONE || levelCount < 1 || levelCount > DDS_MAX_LEVELS) return false;
+
+    DDSHeader h;
+    memset(&h, 0, sizeof(h));
+    h.size = sizeof(DDSHeader);
+    h.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE;
+    h.height = (uint32_t)height;
+    h.width = (uint32_t)width;
+    h.pitchOrLinearSize = (uint32_t)bcLevelSize(format, width, height);
+    h.mipMapCount = (uint32_t)levelCount;
+    h.ddspf.size = sizeof(DDSPixelFormat);
+    h.ddspf.flags = DDPF_FOURCC;
+    h.caps = DDSCAPS_TEXTURE;
+    if (levelCount > 1) {
+        h.flags |= DDSD_MIPMAPCOUNT;
+        h.caps |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+    }
+
+    DDSHeaderDX10 dx10;
+    memset(&dx10, 0, sizeof(dx10));
+    switch (format) {
+    case BC_FORMAT_BC1: h.ddspf.fourCC = DDS_FOURCC('D', 'X', 'T', '1'); break;
+    case BC_FORMAT_BC3: h.ddspf.fourCC = DDS_FOURCC('D', 'X', 'T', '5'); break;
+    default:
+        h.ddspf.fourCC = DDS_FOURCC('D', 'X', '1', '0');
+        dx10.dxgiFormat = DXGI_FORMAT_BC7_UNORM;
+        dx10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+        dx10.arraySize = 1;
+        break;
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+    bool ok = fwrite(&DDS_MAGIC, 4, 1, file) == 1 && fwrite(&h, sizeof(h), 1, file) == 1;
+    if (ok && format == BC_FORMAT_BC7) ok = fwrite(&dx10, sizeof(dx10), 1, file) == 1;
+    int w = width, hh = height;
+    for (int i = 0; ok && i < levelCount; i++) {
+        size_t bytes = bcLevelSize(format, w, hh);
+        ok = fwrite(levels[i], 1, bytes, file) == bytes;
+        w = w > 1 ? w / 2 : 1;
+        hh = hh > 1 ? hh / 2 : 1;
+    }
+    fclose(file);
+    if (!ok) remove(path);
+    return ok;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "bc.h"
+
+// DirectDraw Surface container (little endian), DX9 header with the
+// optional DX10 extension. Only single 2D textures are supported.
+
+#define DDS_FOURCC(a, b, c, d) \
+    ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+static const uint32_t DDS_MAGIC = DDS_FOURCC('D', 'D', 'S', ' ');
+
+enum {
+    DDSD_CAPS = 0x1, DDSD_HEIGHT = 0x2, DDSD_WIDTH = 0x4, DDSD_PITCH = 0x8,
+    DDSD_PIXELFORMAT = 0x1000, DDSD_MIPMAPCOUNT = 0x20000, DDSD_LINEARSIZE = 0x80000,
+    DDPF_FOURCC = 0x4,
+    DDSCAPS_COMPLEX = 0x8, DDSCAPS_TEXTURE = 0x1000, DDSCAPS_MIPMAP = 0x400000,
+    DDSCAPS2_CUBEMAP = 0x200, DDSCAPS2_VOLUME = 0x200000,
+};
+
+enum {
+    DXGI_FORMAT_BC1_UNORM = 71, DXGI_FORMAT_BC1_UNORM_SRGB = 72,
+    DXGI_FORMAT_BC3_UNORM = 77, DXGI_FORMAT_BC3_UNORM_SRGB = 78,
+    DXGI_FORMAT_BC7_UNORM = 98, DXGI_FORMAT_BC7_UNORM_SRGB = 99,
+    DDS_DIMENSION_TEXTURE2D = 3,
+};
+
+struct DDSPixelFormat {
+    uint32_t size;              // 32
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t rgbBitCount;
+    uint32_t rMask, gMask, bMask, aMask;
+};
+
+struct DDSHeader {
+    uint32_t size;              // 124
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitchOrLinearSize;
+    uint32_t depth;
+    uint32_t mipMapCount;
+    uint32_t reserved1[11];
+    DDSPixelFormat ddspf;
+    uint32_t caps, caps2, caps3, caps4;
+    uint32_t reserved2;
+};
+
+struct DDSHeaderDX10 {
+    uint32_t dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
+
+enum { DDS_MAX_LEVELS = 16 };
+
+// A parsed DDS file; level pointers alias the caller's buffer.
+struct DDSImage {
+    BCFormat format;
+    int width, height;
+    int levelCount;
+    const unsigned char* level[DDS_MAX_LEVELS];
+    size_t levelSize[DDS_MAX_LEVELS];
+};
+
+// Validate headers and level sizes against the buffer. Returns false (with a
+// reason in *error) for anything malformed or unsupported.
+bool parseDDS(const unsigned char* data, size_t size, DDSImage& out, const char** error);
+
+// Write a block-compressed texture with levelCount mips (sizes follow
+// bcLevelSize). BC1/BC3 use FourCC headers, BC7 the DX10 extension.
+bool writeDDS(const char* path, BCFormat format, int width, int height,
+              int levelCount, const unsigned char* const* levels);
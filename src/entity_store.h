@@ -0,0 +1,146 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Entities of one archetype (a fixed set of component types), stored as
+// structure of arrays: one contiguous column per component, row i of every
+// column belonging to the same entity. A system that needs two components
+// streams through exactly those two arrays.
+//
+// Entities are named by handles that stay valid while rows move. A handle
+// is a slot index plus the slot's generation; destroy() bumps the
+// generation, so a stale handle is detected rather than aliasing whichever
+// entity reuses the slot. Removal moves the last row into the hole (O(1),
+// the columns stay dense), so row order is not stable: iterate rows, keep
+// handles.
+//
+//   Archetype<Position, Velocity> movers;
+//   EntityHandle h = movers.create(Position{...}, Velocity{...});
+//   Position* p = movers.column<Position>();
+//   const Velocity* v = movers.column<Velocity>();
+//   for (size_t i = 0; i < movers.size(); i++) p[i].x += v[i].x * dt;
+//   movers.destroy(h);
+//
+// Not synchronized: mutate from one thread, and not while others iterate.
+
+struct EntityHandle {
+    uint32_t slot = ~0u;
+    uint32_t generation = 0;
+};
+
+namespace entity_detail {
+    // Position of C in Cs...
+    template<class C, class... Cs> struct IndexOf;
+    template<class C, class... Cs> struct IndexOf<C, C, Cs...> { enum { value = 0 }; };
+    template<class C, class D, class... Cs> struct IndexOf<C, D, Cs...> { enum { value = 1 + IndexOf<C, Cs...>::value }; };
+
+    // Call f(column) for every column
+    template<class Tuple, class F, size_t... I>
+    void forEach(Tuple& t, F&& f, std::index_sequence<I...>)
+    {
+        int dummy[] = { 0, (f(std::get<I>(t)), 0)... };
+        (void)dummy;
+    }
+}
+
+template<class... Components>
+class Archetype {
+public:
+    size_t size() const { return owner.size(); }
+    bool empty() const { return owner.empty(); }
+
+    void reserve(size_t n)
+    {
+        owner.reserve(n);
+        eachColumn([n](auto& c) { c.reserve(n); });
+    }
+
+    EntityHandle create(const Components&... values)
+    {
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            slot = (uint32_t)slots.size();
+            slots.push_back(Slot());
+        }
+        slots[slot].row = (uint32_t)owner.size();
+        owner.push_back(slot);
+        push(std::index_sequence_for<Components...>(), values...);
+
+        EntityHandle h;
+        h.slot = slot;
+        h.generation = slots[slot].generation;
+        return h;
+    }
+
+    // False for a stale or invalid handle
+    bool destroy(EntityHandle h)
+    {
+        if (!alive(h)) return false;
+        const uint32_t row = slots[h.slot].row;
+        const uint32_t last = (uint32_t)owner.size() - 1;
+        if (row != last) {
+            eachColumn([row, last](auto& c) { c[row] = std::move(c[last]); });
+            owner[row] = owner[last];
+            slots[owner[row]].row = row;
+        }
+        eachColumn([](auto& c) { c.pop_back(); });
+        owner.pop_back();
+        slots[h.slot].generation++;
+        freeSlots.push_back(h.slot);
+        return true;
+    }
+
+    bool alive(EntityHandle h) const
+    {
+        return h.slot < slots.size() && slots[h.slot].generation == h.generation;
+    }
+
+    // Row of a live entity; only valid until the next destroy()
+    size_t row(EntityHandle h) const { return slots[h.slot].row; }
+
+    // Handle of the entity in row i
+    EntityHandle handle(size_t i) const
+    {
+        EntityHandle h;
+        h.slot = owner[i];
+        h.generation = slots[h.slot].generation;
+        return h;
+    }
+
+    template<class C> C* column() { return std::get<Index<C>::value>(columns).data(); }
+    template<class C> const C* column() const { return std::get<Index<C>::value>(columns).data(); }
+    template<class C> C& get(EntityHandle h) { return column<C>()[row(h)]; }
+    template<class C> const C& get(EntityHandle h) const { return column<C>()[row(h)]; }
+
+private:
+    template<class C> struct Index : entity_detail::IndexOf<C, Components...> {};
+
+    struct Slot {
+        uint32_t row = 0;
+        uint32_t generation = 0;
+    };
+
+    template<class F> void eachColumn(F&& f)
+    {
+        entity_detail::forEach(columns, f, std::index_sequence_for<Components...>());
+    }
+
+    template<size_t... I>
+    void push(std::index_sequence<I...>, const Components&... values)
+    {
+        int dummy[] = { 0, (std::get<I>(columns).push_back(values), 0)... };
+        (void)dummy;
+    }
+
+    std::tuple<std::vector<Components>...> columns;
+    std::vector<uint32_t> owner;        // row -> slot
+    std::vector<Slot> slots;            // slot -> row, generation
+    std::vector<uint32_t> freeSlots;
+};
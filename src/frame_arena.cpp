@@ -0,0 +1,188 @@
+#include "frame_arena.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+FrameArena::~FrameArena()
+{
+    for (size_t i = 0; i < spill.size(); i++) free(spill[i]);
+    free(base);
+}
+
+void* FrameArena::allocSlow(size_t bytes, size_t align)
+{
+    if (!base) {
+        size = chunkBytes > bytes + align ? chunkBytes : bytes + align;
+        base = (unsigned char*)malloc(size);
+        offset = 0;
+        return alloc(bytes, align);
+    }
+    // Past the end: a block of its own until reset() makes room
+    unsigned char* block = (unsigned char*)malloc(bytes + align);
+    spill.push_back(block);
+    spillBytes += bytes + align;
+    return (void*)(((size_t)block + align - 1) & ~(align - 1));
+}
+
+void FrameArena::reset()
+{
+    if (!spill.empty()) {
+        for (size_t i = 0; i < spill.size(); i++) free(spill[i]);
+        spill.clear();
+        // Room for the whole peak in one block next time
+        free(base);
+        size += spillBytes;
+        base = (unsigned char*)malloc(size);
+        spillBytes = 0;
+    }
+    offset = 0;
+}
+
+// ---------- Per-thread arenas ----------
+
+namespace {
+    struct ThreadArenas {
+        FrameArena arena[2];
+        int current = 0;
+    };
+}
+
+static thread_local ThreadArenas t_arenas;
+
+FrameArena& frameArena()
+{
+    return t_arenas.arena[t_arenas.current];
+}
+
+void beginFrameArena()
+{
+    t_arenas.current ^= 1;
+    t_arenas.arena[t_arenas.current].reset();
+}
+
+// ---------- Heap allocation check ----------
+
+static thread_local AllocAccount t_ownAccount;
+static thread_local AllocAccount* t_account = nullptr;
+
+AllocAccount* allocAccount()
+{
+    return t_account ? t_account : &t_ownAccount;
+}
+
+AllocAccount* setAllocAccount(AllocAccount* account)
+{
+    AllocAccount* prev = allocAccount();
+    t_account = account;
+    return prev;
+}
+
+#ifdef FRAME_ALLOC_CHECK
+static inline void countAllocation()
+{
+    allocAccount()->allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void* operator new(size_t bytes)
+{
+    countAllocation();
+    if (void* p = malloc(bytes ? bytes : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t bytes)
+{
+    return ::operator new(bytes);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
+
+#if __cpp_aligned_new
+// Over-aligned types; these need the matching aligned free
+void* operator new(size_t bytes, std::align_val_t align)
+{
+    countAllocation();
+    void* p = NULL;
+#ifdef _WIN32
+    p = _aligned_malloc(bytes ? bytes : 1, (size_t)align);
+#else
+    if (posix_memalign(&p, (size_t)align, bytes ? bytes : 1) != 0) p = NULL;
+#endif
+    if (p) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t bytes, std::align_val_t align)
+{
+    return ::operator new(bytes, align);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+void operator delete[](void* p, std::align_val_t align) noexcept
+{
+    ::operator delete(p, align);
+}
+
+void operator delete(void* p, size_t, std::align_val_t align) noexcept
+{
+    ::operator delete(p, align);
+}
+
+void operator delete[](void* p, size_t, std::align_val_t align) noexcept
+{
+    ::operator delete(p, align);
+}
+#endif
+
+size_t heapAllocations()
+{
+    return allocAccount()->allocations.load(std::memory_order_relaxed);
+}
+#else
+size_t heapAllocations()
+{
+    return 0;
+}
+#endif
+
+HeapAllocCheck::HeapAllocCheck(const char* where, bool enforce)
+    : where(where), enforce(enforce), before(heapAllocations())
+{
+}
+
+HeapAllocCheck::~HeapAllocCheck()
+{
+    const size_t made = heapAllocations() - before;
+    if (!enforce || made == 0) return;
+    fprintf(stderr, "%s: %zu heap allocations in a steady-state frame\n", where, made);
+    assert(!"heap allocation in the frame loop");
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <stdint.h>
+#include <new>
+#include <vector>
+
+// Per-frame scratch memory.
+//
+// A FrameArena hands out memory by bumping an offset and takes it all back
+// at once in reset(). Nothing is freed one allocation at a time and nothing
+// is destroyed: keep trivially destructible things there, or containers
+// whose elements are. If a frame needs more than the arena holds, the excess
+// comes from extra blocks, and the next reset() merges everything into one
+// block big enough for that peak. From then on a frame of the same size
+// never touches the heap.
+//
+// Each thread has two arenas and uses one per frame. beginFrameArena() swaps
+// them and resets the one it switches to, so memory allocated during frame
+// N is still valid during frame N + 1. A pipelined consumer can read the
+// previous frame's scratch while the next one is being built. Only threads
+// with a frame loop (GL, simulation) call beginFrameArena(). Any other
+// thread's arena is never reset, so tasks must use the arena of the thread
+// that owns the frame and passes it in.
+//
+// ArenaAllocator puts standard containers in an arena; deallocation is a
+// no-op, so reserve() up front rather than letting a vector grow:
+//
+//   ArenaVector<Upload> ops(frameArena());
+//   ops.reserve(expected);
+//
+// Builds with FRAME_ALLOC_CHECK defined count operator new calls against an
+// AllocAccount (heapAllocations()). Each thread starts with one of its own.
+// The task scheduler runs a task under the account of the thread that
+// created it, so a frame's count includes what its tasks allocate, whichever
+// thread runs them. HeapAllocCheck asserts that a scope makes no allocations;
+// it is how the frame loops verify their steady state. Without the define the
+// count is always 0 and the check does nothing.
+
+class FrameArena {
+public:
+    explicit FrameArena(size_t initialBytes = 256 << 10) : chunkBytes(initialBytes) {}
+    ~FrameArena();
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* alloc(size_t bytes, size_t align = alignof(std::max_align_t))
+    {
+        // Align the address: malloc only promises max_align_t for base
+        const uintptr_t start = (uintptr_t)base + offset;
+        const size_t at = offset + (size_t)(((start + align - 1) & ~(uintptr_t)(align - 1)) - start);
+        if (at + bytes > size) return allocSlow(bytes, align);
+        offset = at + bytes;
+        return base + at;
+    }
+
+    // Uninitialized storage for n Ts
+    template<class T> T* allocArray(size_t n) { return (T*)alloc(n * sizeof(T), alignof(T)); }
+
+    // Everything allocated since the last reset is gone
+    void reset();
+
+    size_t used() const { return offset + spillBytes; }
+    size_t capacity() const { return size; }
+
+private:
+    void* allocSlow(size_t bytes, size_t align);
+
+    unsigned char* base = nullptr;
+    size_t size = 0, offset = 0;
+    size_t chunkBytes;
+    std::vector<unsigned char*> spill;  // blocks past the end this frame
+    size_t spillBytes = 0;
+};
+
+// The calling thread's arena for its current frame
+FrameArena& frameArena();
+// Calling thread: switch to the other arena and reset it
+void beginFrameArena();
+
+template<class T>
+struct ArenaAllocator {
+    typedef T value_type;
+
+    ArenaAllocator(FrameArena& a) : arena(&a) {}
+    template<class U> ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) { return arena->allocArray<T>(n); }
+    void deallocate(T*, size_t) {}
+
+    template<class U> bool operator==(const ArenaAllocator<U>& o) const { return arena == o.arena; }
+    template<class U> bool operator!=(const ArenaAllocator<U>& o) const { return arena != o.arena; }
+
+    FrameArena* arena;
+};
+
+template<class T> using ArenaVector = std::vector<T, ArenaAllocator<T> >;
+
+struct AllocAccount {
+    std::atomic<size_t> allocations{0};
+};
+
+// The account the calling thread's allocations go to
+AllocAccount* allocAccount();
+// Returns the previous account; NULL goes back to the thread's own
+AllocAccount* setAllocAccount(AllocAccount* account);
+
+// operator new calls counted against the calling thread's account so far
+// (FRAME_ALLOC_CHECK)
+size_t heapAllocations();
+
+class HeapAllocCheck {
+public:
+    // enforce: false while caches are still allowed to grow
+    HeapAllocCheck(const char* where, bool enforce);
+    ~HeapAllocCheck();
+
+private:
+    const char* where;
+    bool enforce;
+    size_t before;
+};
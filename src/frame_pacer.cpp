@@ -0,0 +1,115 @@
+#include "cube.h"
+#include "frame_pacer.h"
+#include "profiler.h"
+#include <stdio.h>
+#include <thread>
+
+#ifdef _WIN32
+#  include <windows.h>
+#  include <mmsystem.h>
+#  pragma comment(lib, "winmm.lib")
+#endif
+
+static double msBetween(FramePacer::Clock::time_point a, FramePacer::Clock::time_point b)
+{
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+void FramePacer::init(const PacerSettings& s)
+{
+    settings = s;
+    if (settings.targetFps <= 0.0) settings.targetFps = 60.0;
+    if (settings.spinMs < 0.0) settings.spinMs = 0.0;
+    if (settings.pollMs < 1.0) settings.pollMs = 1.0;
+    period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / settings.targetFps));
+#ifdef _WIN32
+    // The default 15.6 ms scheduler tick would make every sleep a whole frame
+    timeBeginPeriod(1);
+#endif
+    next = lastFrame = statsStart = Clock::now();
+}
+
+bool FramePacer::frameWanted() const
+{
+    return settings.mode != PACE_ON_DEMAND || dirty || animating;
+}
+
+void FramePacer::resetStats()
+{
+    stat = PacerStats();
+    statsStart = Clock::now();
+}
+
+void FramePacer::report()
+{
+    const double wall = stat.wallMs > 0.0 ? stat.wallMs : 1.0;
+    printf("pacer: %d frames in %.0f ms (%.1f fps) | idle %.0f%%, spin %.1f%%, work %.1f%% | worst late %.2f ms\n",
+        stat.frames, stat.wallMs, stat.frames * 1000.0 / wall, 100.0 * stat.sleepMs / wall,
+        100.0 * stat.spinMs / wall, 100.0 * stat.workMs / wall, stat.worstLateMs);
+    resetStats();
+}
+
+// Sleep, then spin for the last spinMs: sleeps overshoot, spinning doesn't
+void FramePacer::waitUntil(Clock::time_point deadline, double spinMs)
+{
+    PROFILE_ZONE("FramePacer::wait");
+    Clock::time_point now = Clock::now();
+    const Clock::duration spin =
+        std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(spinMs));
+    if (deadline - now > spin) {
+        std::this_thread::sleep_until(deadline - spin);
+        Clock::time_point woke = Clock::now();
+        stat.sleepMs += msBetween(now, woke);
+        now = woke;
+    }
+    Clock::time_point spinStart = now;
+    while (now < deadline) {
+        std::this_thread::yield();
+        now = Clock::now();
+    }
+    stat.spinMs += msBetween(spinStart, now);
+}
+
+void FramePacer::run(PacerFrameFn frame)
+{
+    running = true;
+    next = lastFrame = Clock::now();
+    while (running) {
+        Clock::time_point t0 = Clock::now();
+        glutMainLoopEvent();        // input may invalidate() or stop()
+        if (!running) break;
+
+        Clock::time_point now = Clock::now();
+        const bool wanted = frameWanted();
+        if (!wanted) lastFrame = now;       // idle time is not simulated time
+        else if (now >= next) {
+            double late = msBetween(next, now);
+            if (late > stat.worstLateMs) stat.worstLateMs = late;
+            dirty.store(false);
+            if (frame) frame(std::chrono::duration<double>(now - lastFrame).count());
+            lastFrame = now;
+            glutPostRedisplay();
+            glutMainLoopEvent();    // draws and swaps
+            stat.frames++;
+
+            if (settings.mode == PACE_UNCAPPED) next = now;
+            else {
+                next += period;
+                if (next < now) next = now + period;
+            }
+        }
+        now = Clock::now();
+        stat.workMs += msBetween(t0, now);
+
+        // Nothing to draw: poll for input with plain sleeps, precision is moot
+        if (!frameWanted())
+            waitUntil(now + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::milli>(settings.pollMs)), 0.0);
+        else if (settings.mode != PACE_UNCAPPED) waitUntil(next, settings.spinMs);
+        stat.wallMs = msBetween(statsStart, Clock::now());
+        if (settings.reportMs > 0.0 && stat.wallMs >= settings.reportMs) report();
+    }
+#ifdef _WIN32
+    timeEndPeriod(1);
+#endif
+}
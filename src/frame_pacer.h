@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+
+// Frame pacing for the GLUT event loop. Replaces glutMainLoop plus a busy idle
+// callback: the pacer pumps events with glutMainLoopEvent, starts frames when
+// they are due and sleeps in between, on a monotonic high-resolution clock.
+//   PACE_TARGET     a frame every 1 / targetFps seconds
+//   PACE_UNCAPPED   frames back to back (vsync, if on, still limits them)
+//   PACE_ON_DEMAND  a frame only after invalidate() or while animating,
+//                   no faster than targetFps; otherwise events are polled
+//                   every pollMs and the process sleeps
+// Deadlines advance by whole periods, so one late frame does not shift the
+// ones after it; after a stall of more than a period the schedule restarts
+// from now instead of catching up in a burst.
+
+enum PaceMode { PACE_TARGET, PACE_UNCAPPED, PACE_ON_DEMAND };
+
+struct PacerSettings {
+    PaceMode mode = PACE_TARGET;
+    double targetFps = 60.0;
+    double spinMs = 1.0;            // the end of each wait is spun, sleeps overshoot
+    double pollMs = 10.0;           // ON_DEMAND with nothing to draw
+    double reportMs = 0.0;          // print the stats this often; 0 = never
+};
+
+struct PacerStats {
+    int    frames = 0;              // since the last resetStats()
+    double wallMs = 0.0;
+    double sleepMs = 0.0;           // blocked in the OS: the idle CPU
+    double spinMs = 0.0;
+    double workMs = 0.0;            // events, frame callbacks, drawing
+    double worstLateMs = 0.0;       // latest frame start past its deadline
+};
+
+// Called before each frame is drawn with the seconds since the previous one
+// (0 after the pacer sat idle in ON_DEMAND); typically advances the
+// simulation. The pacer posts the redisplay itself. May be NULL.
+typedef void (*PacerFrameFn)(double dtSec);
+
+class FramePacer {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    void init(const PacerSettings& settings);
+
+    // Pump events and draw frames until stop()
+    void run(PacerFrameFn frame);
+    void stop() { running = false; }
+
+    // ON_DEMAND: something changed, draw a frame. Ignored by the other modes.
+    // Safe to call from any thread.
+    void invalidate() { dirty.store(true); }
+    // ON_DEMAND: every frame changes something (e.g. animation not paused)
+    void setAnimating(bool on) { animating = on; }
+
+    const PacerSettings& config() const { return settings; }
+    const PacerStats& stats() const { return stat; }
+    void resetStats();
+
+private:
+    bool frameWanted() const;
+    void report();
+    void waitUntil(Clock::time_point deadline, double spinMs);
+
+    PacerSettings settings;
+    Clock::duration period;
+    Clock::time_point next, lastFrame, statsStart;
+    bool running = false;
+    std::atomic<bool> dirty{true};
+    bool animating = true;
+    PacerStats stat;
+};
@@ -4,11 +4,25 @@ in  vec3 fragPos;
 in  vec3 fragNormal;
 in  vec4 fragColor;
 in  vec2 texCoord;
+in  vec4 lightSpacePos;
+flat in float skinLayer;
+flat in float fade;
 
 out vec4 fColor;
 
-uniform int  isTexture;
+uniform int  isTexture;         // 0: vertex color, 1: sphereTexture, 2: skinTextures, 3: virtual texture
 uniform sampler2D sphereTexture;
+uniform sampler2DArray skinTextures;
+
+// Virtual texture (virtual_texture.h)
+uniform sampler2D vtPageTable;  // per tile: cache page x, y and resident level
+uniform sampler2D vtCache;
+uniform float vtTiles;          // tiles per side at level 0
+uniform float vtVirtualSize;    // texels per side at level 0
+uniform float vtMaxLevel;
+uniform vec3  vtPageScale;      // page stride, border, tile size in cache UV
+uniform int  useShadows;
+uniform sampler2DShadow shadowMap;
 
 uniform vec3 lightPos;
 uniform vec3 viewPos;
@@ -22,8 +36,45 @@ uniform vec3 materialDiffuse;
 uniform vec3 materialSpecular;
 uniform float materialShininess;
 
+// 3x3 PCF over the cached shadow map; 1 = lit, 0 = fully shadowed
+float shadowFactor()
+{
+    vec3 p = lightSpacePos.xyz / lightSpacePos.w * 0.5 + 0.5;
+    if (p.z > 1.0) return 1.0;
+
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0));
+    float sum = 0.0;
+    for (int y = -1; y <= 1; y++)
+        for (int x = -1; x <= 1; x++)
+            sum += texture(shadowMap, vec3(p.xy + vec2(x, y) * texel, p.z));
+    return sum / 9.0;
+}
+
+vec3 sampleVirtual(vec2 uv)
+{
+    vec2 t = uv * vtVirtualSize;
+    vec2 dx = dFdx(t), dy = dFdy(t);
+    float lod = clamp(0.5 * log2(max(dot(dx, dx), dot(dy, dy))), 0.0, vtMaxLevel);
+
+    // The entry names the finest resident ancestor; locate uv inside that page
+    vec3 e = textureLod(vtPageTable, uv, floor(lod)).rgb * 255.0;
+    vec2 inPage = fract(uv * vtTiles / exp2(e.b));
+    vec2 p = e.rg * vtPageScale.x + vtPageScale.y + inPage * vtPageScale.z;
+    return textureLod(vtCache, p, 0.0).rgb;
+}
+
+// 4x4 ordered dither in (0, 1); impostors keep the complementary pixels
+float bayer4(vec2 p)
+{
+    ivec2 i = ivec2(mod(p, 4.0));
+    int b[16] = int[16](0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5);
+    return (float(b[i.y * 4 + i.x]) + 0.5) / 16.0;
+}
+
 void main()
 {
+    if (fade < 1.0 && bayer4(gl_FragCoord.xy) >= fade) discard;
+
     vec3 N = normalize(fragNormal);
     vec3 L = normalize(lightPos - fragPos);
     float diff = max(dot(N, L), 0.0);
@@ -42,6 +93,13 @@ void main()
     if (isTexture == 1) {
         baseColor = texture(sphereTexture, texCoord).rgb;
     }
-    vec3 color = (ambient + diffuse + specular) * baseColor;
+    else if (isTexture == 2) {
+        baseColor = texture(skinTextures, vec3(texCoord, skinLayer)).rgb;
+    }
+    else if (isTexture == 3) {
+        baseColor = sampleVirtual(texCoord);
+    }
+    float lit = (useShadows == 1) ? shadowFactor() : 1.0;
+    vec3 color = (ambient + lit * (diffuse + specular)) * baseColor;
     fColor = vec4(color, fragColor.a);
 }
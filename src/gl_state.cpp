@@ -0,0 +1,119 @@
+#include "gl_state.h"
+#include <string.h>
+
+GLStateCache g_glState;
+
+void GLStateCache::invalidate()
+{
+    program = vao = unit = UNKNOWN;
+    for (int i = 0; i < BUFFER_TARGETS; i++) buffer[i] = UNKNOWN;
+    for (int u = 0; u < UNITS; u++)
+        for (int i = 0; i < TEXTURE_TARGETS; i++) texture[u][i] = UNKNOWN;
+    for (int i = 0; i < CAPS; i++) cap[i] = UNKNOWN;
+    drawFramebuffer = readFramebuffer = UNKNOWN;
+    viewportKnown = clearColorKnown = false;
+}
+
+void glStateInvalidate()
+{
+    g_glState.invalidate();
+}
+
+void glStateSetFiltering(bool on)
+{
+    g_glState.filtering = on;
+}
+
+uint64_t glStateFiltered()
+{
+    return g_glState.filtered;
+}
+
+void glStateForgetBuffers(GLsizei n, const GLuint* buffers)
+{
+    for (GLsizei k = 0; k < n; k++) {
+        if (!buffers[k]) continue;
+        for (int i = 0; i < GLStateCache::BUFFER_TARGETS; i++)
+            if (g_glState.buffer[i] == buffers[k]) g_glState.buffer[i] = 0;
+    }
+}
+
+void glStateForgetTextures(GLsizei n, const GLuint* textures)
+{
+    for (GLsizei k = 0; k < n; k++) {
+        if (!textures[k]) continue;
+        for (int u = 0; u < GLStateCache::UNITS; u++)
+            for (int i = 0; i < GLStateCache::TEXTURE_TARGETS; i++)
+                if (g_glState.texture[u][i] == textures[k]) g_glState.texture[u][i] = 0;
+    }
+}
+
+void glStateForgetFramebuffers(GLsizei n, const GLuint* framebuffers)
+{
+    for (GLsizei k = 0; k < n; k++) {
+        if (!framebuffers[k]) continue;
+        if (g_glState.drawFramebuffer == framebuffers[k]) g_glState.drawFramebuffer = 0;
+        if (g_glState.readFramebuffer == framebuffers[k]) g_glState.readFramebuffer = 0;
+    }
+}
+
+// ---------- Queries ----------
+
+static GLuint queryName(GLenum pname)
+{
+    GLint value = 0;
+    glGetIntegerv(pname, &value);
+    return (GLuint)value;
+}
+
+GLuint glStateProgram()
+{
+    GLuint& p = g_glState.program;
+    if (p == GLStateCache::UNKNOWN) p = queryName(GL_CURRENT_PROGRAM);
+    return p;
+}
+
+GLuint glStateDrawFramebuffer()
+{
+    GLuint& f = g_glState.drawFramebuffer;
+    if (f == GLStateCache::UNKNOWN) f = queryName(GL_DRAW_FRAMEBUFFER_BINDING);
+    return f;
+}
+
+GLenum glStateActiveTexture()
+{
+    GLuint& u = g_glState.unit;
+    if (u == GLStateCache::UNKNOWN) u = queryName(GL_ACTIVE_TEXTURE) - GL_TEXTURE0;
+    return GL_TEXTURE0 + u;
+}
+
+GLuint glStateTexture(GLenum target)
+{
+    const int slot = glStateTextureSlot(target);
+    const GLuint unit = glStateActiveTexture() - GL_TEXTURE0;
+    GLenum pname = GL_TEXTURE_BINDING_2D;
+    if (target == GL_TEXTURE_2D_ARRAY) pname = GL_TEXTURE_BINDING_2D_ARRAY;
+    else if (target == GL_TEXTURE_BUFFER) pname = GL_TEXTURE_BINDING_BUFFER;
+    if (slot < 0 || unit >= GLStateCache::UNITS) return queryName(pname);
+    GLuint& t = g_glState.texture[unit][slot];
+    if (t == GLStateCache::UNKNOWN) t = queryName(pname);
+    return t;
+}
+
+void glStateViewport(GLint viewport[4])
+{
+    if (!g_glState.viewportKnown) {
+        glGetIntegerv(GL_VIEWPORT, g_glState.viewport);
+        g_glState.viewportKnown = true;
+    }
+    memcpy(viewport, g_glState.viewport, sizeof(g_glState.viewport));
+}
+
+void glStateClearColor(GLfloat color[4])
+{
+    if (!g_glState.clearColorKnown) {
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, g_glState.clearColor);
+        g_glState.clearColorKnown = true;
+    }
+    memcpy(color, g_glState.clearColor, sizeof(g_glState.clearColor));
+}
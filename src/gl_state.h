@@ -0,0 +1,116 @@
+#pragma once
+#include <stdint.h>
+#include "GL/glew.h"
+
+// Shadow copy of the GL binding state behind the gls* wrappers (gl_stats.h).
+//
+// The cache holds the current program and vertex array, the buffer bound to
+// each target, the active texture unit and what each unit has bound, the
+// enable/disable capabilities, the framebuffers, the viewport and the clear
+// color. A call that would set what is already set is dropped before it
+// reaches the driver. That matters where every GL call costs real CPU time,
+// as on llvmpipe. Targets and capabilities the cache has no slot for always
+// go through.
+//
+// Everything starts unknown, and setting an unknown value is always issued.
+// The cache is only right while every change goes through the wrappers.
+// Code that changes this state behind their back (raw GL, another library)
+// calls glStateInvalidate() afterwards. Binding a vertex array makes the
+// element buffer unknown, because that binding belongs to the vertex array.
+// Deleting a bound buffer, texture or framebuffer unbinds it; the glsDelete*
+// wrappers keep the cache in step.
+//
+// Code that saves state to restore it later reads it with glStateProgram()
+// and its neighbours instead of glGet, which is a driver round trip. They
+// answer from the cache and only query GL while the value is unknown.
+//
+// glStateFiltered() counts the calls dropped so far. With filtering off the
+// cache is still kept but every call is issued, for comparison. GL thread
+// only.
+
+struct GLStateCache {
+    enum { UNITS = 16, BUFFER_TARGETS = 6, TEXTURE_TARGETS = 3, CAPS = 6 };
+    static const GLuint UNKNOWN = 0xffffffffu;
+
+    GLStateCache() { invalidate(); }
+    void invalidate();
+
+    bool filtering = true;
+    GLuint program, vao;
+    GLuint unit;                                // active unit, 0-based
+    GLuint buffer[BUFFER_TARGETS];
+    GLuint texture[UNITS][TEXTURE_TARGETS];
+    GLuint cap[CAPS];                           // 0, 1 or UNKNOWN
+    GLuint drawFramebuffer, readFramebuffer;
+    bool viewportKnown, clearColorKnown;
+    GLint viewport[4];
+    GLfloat clearColor[4];
+    uint64_t filtered = 0;
+};
+
+extern GLStateCache g_glState;
+
+void glStateInvalidate();
+void glStateSetFiltering(bool on);
+uint64_t glStateFiltered();
+// Deleted names are unbound wherever the cache has them
+void glStateForgetBuffers(GLsizei n, const GLuint* buffers);
+void glStateForgetTextures(GLsizei n, const GLuint* textures);
+void glStateForgetFramebuffers(GLsizei n, const GLuint* framebuffers);
+
+// Current state, from the cache when known
+GLuint glStateProgram();
+GLuint glStateDrawFramebuffer();
+GLenum glStateActiveTexture();                  // GL_TEXTUREi
+GLuint glStateTexture(GLenum target);           // on the active unit
+void glStateViewport(GLint viewport[4]);
+void glStateClearColor(GLfloat color[4]);
+
+enum { GL_STATE_ELEMENT_SLOT = 1 };
+
+inline int glStateBufferSlot(GLenum target)
+{
+    switch (target) {
+    case GL_ARRAY_BUFFER: return 0;
+    case GL_ELEMENT_ARRAY_BUFFER: return GL_STATE_ELEMENT_SLOT;
+    case GL_UNIFORM_BUFFER: return 2;
+    case GL_TEXTURE_BUFFER: return 3;
+    case GL_PIXEL_UNPACK_BUFFER: return 4;
+    case GL_PIXEL_PACK_BUFFER: return 5;
+    default: return -1;
+    }
+}
+
+inline int glStateTextureSlot(GLenum target)
+{
+    switch (target) {
+    case GL_TEXTURE_2D: return 0;
+    case GL_TEXTURE_2D_ARRAY: return 1;
+    case GL_TEXTURE_BUFFER: return 2;
+    default: return -1;
+    }
+}
+
+inline int glStateCapSlot(GLenum cap)
+{
+    switch (cap) {
+    case GL_DEPTH_TEST: return 0;
+    case GL_CULL_FACE: return 1;
+    case GL_BLEND: return 2;
+    case GL_POLYGON_OFFSET_FILL: return 3;
+    case GL_SCISSOR_TEST: return 4;
+    case GL_STENCIL_TEST: return 5;
+    default: return -1;
+    }
+}
+
+// Records value; false if it was already current and the call can be dropped
+inline bool glStateChange(GLuint& cached, GLuint value)
+{
+    if (cached == value && g_glState.filtering) {
+        g_glState.filtered++;
+        return false;
+    }
+    cached = value;
+    return true;
+}
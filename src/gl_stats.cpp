@@ -0,0 +1,104 @@
+#include "cube.h"
+#include "gl_stats.h"
+#include <stdio.h>
+#include <vector>
+
+static GLStats g_frame, g_total;
+
+#ifdef GL_STATS
+GLStats g_glStatsCurrent;
+
+static void add(GLStats& to, const GLStats& s)
+{
+    to.draws += s.draws;
+    to.triangles += s.triangles;
+    to.stateChanges += s.stateChanges;
+    to.stateFiltered += s.stateFiltered;
+    to.uniformCalls += s.uniformCalls;
+    to.uniformBytes += s.uniformBytes;
+    to.bufferBytes += s.bufferBytes;
+    to.perfWarnings += s.perfWarnings;
+}
+
+// ---------- Debug output ----------
+
+static std::vector<GLuint> g_seenIds;      // performance warnings printed once
+
+static const char* sourceName(GLenum source)
+{
+    switch (source) {
+    case GL_DEBUG_SOURCE_API: return "api";
+    case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window system";
+    case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+    case GL_DEBUG_SOURCE_THIRD_PARTY: return "third party";
+    case GL_DEBUG_SOURCE_APPLICATION: return "application";
+    default: return "other";
+    }
+}
+
+static void GLAPIENTRY onDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity,
+    GLsizei, const GLchar* message, const void*)
+{
+    if (type == GL_DEBUG_TYPE_PERFORMANCE) {
+        g_glStatsCurrent.perfWarnings++;
+        for (size_t i = 0; i < g_seenIds.size(); i++)
+            if (g_seenIds[i] == id) return;
+        g_seenIds.push_back(id);
+        printf("gl perf (%s, id %u): %s\n", sourceName(source), id, message);
+    }
+    else if (type == GL_DEBUG_TYPE_ERROR || severity == GL_DEBUG_SEVERITY_HIGH)
+        printf("gl error (%s, id %u): %s\n", sourceName(source), id, message);
+}
+
+void glStatsInitDebug()
+{
+    g_seenIds.reserve(64);
+    if (GLEW_VERSION_4_3 || GLEW_KHR_debug) {
+        glEnable(GL_DEBUG_OUTPUT);
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        glDebugMessageCallback(onDebugMessage, NULL);
+        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_TRUE);
+    }
+    else if (GLEW_ARB_debug_output) {
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB);
+        glDebugMessageCallbackARB(onDebugMessage, NULL);
+        glDebugMessageControlARB(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_TRUE);
+    }
+    else printf("gl stats: no debug output extension, performance warnings not counted\n");
+}
+
+void glStatsEndFrame()
+{
+    static uint64_t filteredBefore = 0;
+    g_glStatsCurrent.stateFiltered = (uint32_t)(glStateFiltered() - filteredBefore);
+    filteredBefore = glStateFiltered();
+    g_frame = g_glStatsCurrent;
+    add(g_total, g_glStatsCurrent);
+    g_glStatsCurrent = GLStats();
+}
+#else
+void glStatsInitDebug()
+{
+}
+
+void glStatsEndFrame()
+{
+}
+#endif
+
+const GLStats& glStatsFrame()
+{
+    return g_frame;
+}
+
+const GLStats& glStatsTotal()
+{
+    return g_total;
+}
+
+void glStatsPrint(const char* label, const GLStats& s)
+{
+    printf("%s: %u draws, %llu triangles | %u state changes, %u filtered | %u uniform calls, %.1f KB | %.1f KB buffer uploads | %u perf warnings\n",
+        label, s.draws, (unsigned long long)s.triangles, s.stateChanges, s.stateFiltered, s.uniformCalls,
+        s.uniformBytes / 1024.0, s.bufferBytes / 1024.0, s.perfWarnings);
+}
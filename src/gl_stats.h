@@ -0,0 +1,279 @@
+#pragma once
+#include <stdint.h>
+#include "GL/glew.h"
+#include "gl_state.h"
+
+// Counted GL calls.
+//
+// The calls that make up a frame's cost go through the gls* wrappers below
+// instead of straight to GL: draws, uniform uploads, binds, enables and
+// buffer uploads. Builds with GL_STATS defined add
+// each call to the GL thread's counters before making it. Without the define
+// the wrappers are inline forwards and the counters stay zero. Binds and
+// enables also go through the state cache (gl_state.h) in every build, which
+// drops the ones that change nothing.
+//
+// glStatsEndFrame() (after the swap) closes the frame. glStatsFrame() is then
+// what the last complete frame issued, and glStatsTotal() everything since
+// start. That is what a benchmark asserts its budget on:
+//
+//   assert(glStatsFrame().draws <= 64);
+//
+// glStatsInitDebug() hooks KHR_debug (or ARB_debug_output) messages in
+// GL_STATS builds. Performance warnings are counted and printed once per
+// message id; errors are always printed. Drivers only send messages to a
+// debug context, which main asks for in those builds. Output is synchronous,
+// so the callback runs on the GL thread and the counters need no locking.
+
+struct GLStats {
+    uint32_t draws = 0;
+    uint64_t triangles = 0;         // all instances
+    uint32_t stateChanges = 0;      // binds, active unit, enable/disable
+    uint32_t stateFiltered = 0;     // dropped by the state cache
+    uint32_t uniformCalls = 0;
+    uint64_t uniformBytes = 0;
+    uint64_t bufferBytes = 0;       // glBufferData with data, glBufferSubData
+    uint32_t perfWarnings = 0;      // KHR_debug performance messages
+};
+
+// GL thread, once the context exists
+void glStatsInitDebug();
+// GL thread, after the swap
+void glStatsEndFrame();
+const GLStats& glStatsFrame();
+const GLStats& glStatsTotal();
+void glStatsPrint(const char* label, const GLStats& s);
+
+#ifdef GL_STATS
+extern GLStats g_glStatsCurrent;    // the frame being issued
+
+inline uint64_t glStatsTriangles(GLenum mode, GLsizei count)
+{
+    if (mode == GL_TRIANGLES) return (uint64_t)count / 3;
+    if (mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN) return count > 2 ? (uint64_t)count - 2 : 0;
+    return 0;
+}
+
+inline void glStatsDraw(GLenum mode, GLsizei count, GLsizei instances)
+{
+    g_glStatsCurrent.draws++;
+    g_glStatsCurrent.triangles += glStatsTriangles(mode, count) * (uint64_t)instances;
+}
+
+inline void glStatsState() { g_glStatsCurrent.stateChanges++; }
+
+inline void glStatsUniform(size_t bytes)
+{
+    g_glStatsCurrent.uniformCalls++;
+    g_glStatsCurrent.uniformBytes += bytes;
+}
+
+inline void glStatsUpload(size_t bytes) { g_glStatsCurrent.bufferBytes += bytes; }
+#else
+inline void glStatsDraw(GLenum, GLsizei, GLsizei) {}
+inline void glStatsState() {}
+inline void glStatsUniform(size_t) {}
+inline void glStatsUpload(size_t) {}
+#endif
+
+// ---------- Wrappers ----------
+
+inline void glsUniform1i(GLint location, GLint v)
+{
+    glStatsUniform(sizeof(GLint));
+    glUniform1i(location, v);
+}
+
+inline void glsUniform1f(GLint location, GLfloat v)
+{
+    glStatsUniform(sizeof(GLfloat));
+    glUniform1f(location, v);
+}
+
+inline void glsUniform2f(GLint location, GLfloat x, GLfloat y)
+{
+    glStatsUniform(2 * sizeof(GLfloat));
+    glUniform2f(location, x, y);
+}
+
+inline void glsUniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z)
+{
+    glStatsUniform(3 * sizeof(GLfloat));
+    glUniform3f(location, x, y, z);
+}
+
+inline void glsUniform3fv(GLint location, GLsizei count, const GLfloat* v)
+{
+    glStatsUniform(count * 3 * sizeof(GLfloat));
+    glUniform3fv(location, count, v);
+}
+
+inline void glsUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* v)
+{
+    glStatsUniform(count * 16 * sizeof(GLfloat));
+    glUniformMatrix4fv(location, count, transpose, v);
+}
+
+inline void glsUseProgram(GLuint program)
+{
+    if (!glStateChange(g_glState.program, program)) return;
+    glStatsState();
+    glUseProgram(program);
+}
+
+inline void glsBindVertexArray(GLuint vao)
+{
+    if (!glStateChange(g_glState.vao, vao)) return;
+    g_glState.buffer[GL_STATE_ELEMENT_SLOT] = GLStateCache::UNKNOWN;
+    glStatsState();
+    glBindVertexArray(vao);
+}
+
+inline void glsBindBuffer(GLenum target, GLuint buffer)
+{
+    const int slot = glStateBufferSlot(target);
+    if (slot >= 0 && !glStateChange(g_glState.buffer[slot], buffer)) return;
+    glStatsState();
+    glBindBuffer(target, buffer);
+}
+
+// Also binds the target's general binding point
+inline void glsBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    const int slot = glStateBufferSlot(target);
+    if (slot >= 0) g_glState.buffer[slot] = buffer;
+    glStatsState();
+    glBindBufferBase(target, index, buffer);
+}
+
+inline void glsActiveTexture(GLenum unit)
+{
+    if (!glStateChange(g_glState.unit, unit - GL_TEXTURE0)) return;
+    glStatsState();
+    glActiveTexture(unit);
+}
+
+inline void glsBindTexture(GLenum target, GLuint texture)
+{
+    const int slot = glStateTextureSlot(target);
+    const GLuint unit = g_glState.unit;
+    if (slot >= 0 && unit < GLStateCache::UNITS && !glStateChange(g_glState.texture[unit][slot], texture)) return;
+    glStatsState();
+    glBindTexture(target, texture);
+}
+
+inline void glsEnable(GLenum cap)
+{
+    const int slot = glStateCapSlot(cap);
+    if (slot >= 0 && !glStateChange(g_glState.cap[slot], 1)) return;
+    glStatsState();
+    glEnable(cap);
+}
+
+inline void glsDisable(GLenum cap)
+{
+    const int slot = glStateCapSlot(cap);
+    if (slot >= 0 && !glStateChange(g_glState.cap[slot], 0)) return;
+    glStatsState();
+    glDisable(cap);
+}
+
+inline void glsBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    const bool draw = target != GL_READ_FRAMEBUFFER, read = target != GL_DRAW_FRAMEBUFFER;
+    if (g_glState.filtering && (!draw || g_glState.drawFramebuffer == framebuffer)
+        && (!read || g_glState.readFramebuffer == framebuffer)) {
+        g_glState.filtered++;
+        return;
+    }
+    if (draw) g_glState.drawFramebuffer = framebuffer;
+    if (read) g_glState.readFramebuffer = framebuffer;
+    glStatsState();
+    glBindFramebuffer(target, framebuffer);
+}
+
+inline void glsViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    GLint* v = g_glState.viewport;
+    if (g_glState.filtering && g_glState.viewportKnown && v[0] == x && v[1] == y && v[2] == width && v[3] == height) {
+        g_glState.filtered++;
+        return;
+    }
+    v[0] = x;
+    v[1] = y;
+    v[2] = width;
+    v[3] = height;
+    g_glState.viewportKnown = true;
+    glStatsState();
+    glViewport(x, y, width, height);
+}
+
+inline void glsClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+{
+    GLfloat* c = g_glState.clearColor;
+    if (g_glState.filtering && g_glState.clearColorKnown && c[0] == r && c[1] == g && c[2] == b && c[3] == a) {
+        g_glState.filtered++;
+        return;
+    }
+    c[0] = r;
+    c[1] = g;
+    c[2] = b;
+    c[3] = a;
+    g_glState.clearColorKnown = true;
+    glStatsState();
+    glClearColor(r, g, b, a);
+}
+
+inline void glsDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+    glStateForgetBuffers(n, buffers);
+    glDeleteBuffers(n, buffers);
+}
+
+inline void glsDeleteTextures(GLsizei n, const GLuint* textures)
+{
+    glStateForgetTextures(n, textures);
+    glDeleteTextures(n, textures);
+}
+
+inline void glsDeleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+{
+    glStateForgetFramebuffers(n, framebuffers);
+    glDeleteFramebuffers(n, framebuffers);
+}
+
+inline void glsDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    glStatsDraw(mode, count, 1);
+    glDrawArrays(mode, first, count);
+}
+
+inline void glsDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances)
+{
+    glStatsDraw(mode, count, instances);
+    glDrawArraysInstanced(mode, first, count, instances);
+}
+
+inline void glsDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices)
+{
+    glStatsDraw(mode, count, 1);
+    glDrawElements(mode, count, type, indices);
+}
+
+inline void glsDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices, GLsizei instances)
+{
+    glStatsDraw(mode, count, instances);
+    glDrawElementsInstanced(mode, count, type, indices, instances);
+}
+
+inline void glsBufferData(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage)
+{
+    if (data) glStatsUpload((size_t)size);
+    glBufferData(target, size, data, usage);
+}
+
+inline void glsBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data)
+{
+    glStatsUpload((size_t)size);
+    glBufferSubData(target, offset, size, data);
+}
@@ -272,10 +272,29 @@
 		((GLM_COMPILER & GLM_COMPILER_CUDA))))
 #endif
 
+// P0595 std::is_constant_evaluated http://www.open-std.org/jtc1/sc22/wg21/docs/papers/2018/p0595r2.html
+// The builtin is available in every language mode on the compilers below, but SIMD code also needs C++20
+// (P1330/P1331) to switch the active member of the vec storage union inside a constant expression.
+#if (GLM_COMPILER & GLM_COMPILER_CLANG) && defined(__has_builtin)
+#	if __has_builtin(__builtin_is_constant_evaluated)
+#		define GLM_HAS_IS_CONSTANT_EVALUATED 1
+#	endif
+#elif (GLM_COMPILER & GLM_COMPILER_GCC) && (__GNUC__ >= 9)
+#	define GLM_HAS_IS_CONSTANT_EVALUATED 1
+#elif (GLM_COMPILER & GLM_COMPILER_VC) && (_MSC_VER >= 1925)
+#	define GLM_HAS_IS_CONSTANT_EVALUATED 1
+#endif
+#ifndef GLM_HAS_IS_CONSTANT_EVALUATED
+#	define GLM_HAS_IS_CONSTANT_EVALUATED 0
+#	define GLM_IS_CONSTANT_EVALUATED() false
+#else
+#	define GLM_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+
 // N2235 Generalized Constant Expressions http://www.open-std.org/jtc1/sc22/wg21/docs/papers/2007/n2235.pdf
 // N3652 Extended Constant Expressions http://www.open-std.org/jtc1/sc22/wg21/docs/papers/2013/n3652.html
-#if (GLM_ARCH & GLM_ARCH_SIMD_BIT) // Compiler SIMD intrinsics don't support constexpr...
-#	define GLM_HAS_CONSTEXPR 0
+#if (GLM_ARCH & GLM_ARCH_SIMD_BIT) // Intrinsics aren't constexpr; SIMD paths fall back to scalar code at compile time
+#	define GLM_HAS_CONSTEXPR (GLM_HAS_IS_CONSTANT_EVALUATED && (GLM_LANG & GLM_LANG_CXX2A_FLAG))
 #elif (GLM_COMPILER & GLM_COMPILER_CLANG)
 #	define GLM_HAS_CONSTEXPR __has_feature(cxx_relaxed_constexpr)
 #elif (GLM_LANG & GLM_LANG_CXX14_FLAG)
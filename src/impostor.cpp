@@ -0,0 +1,208 @@
+#include "cube.h"
+#include "impostor.h"
+#include "profiler.h"
+#include "gl_stats.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+static const char* const kInstanceAttribs[] = { "vInstanceOffset", "vInstancePhase", "vSkinLayer" };
+static const char* const kMeshAttribs[] = {
+    "vPosition", "vNormal", "vColor", "vTexCoord", "vBone", "vSkinLayer", "vInstanceOffset", "vInstancePhase"
+};
+static const char* const kLightingUniforms[] = {
+    "lightPos", "lightAmbient", "lightDiffuse", "lightSpecular",
+    "materialAmbient", "materialDiffuse", "materialSpecular"
+};
+
+static void bindAttribs(GLuint program, GLuint mainProgram, const char* const* names, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        GLint loc = glGetAttribLocation(mainProgram, names[i]);
+        if (loc >= 0) glBindAttribLocation(program, loc, names[i]);
+    }
+    glLinkProgram(program);
+}
+
+static GLuint makeArray(int side, int layers)
+{
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glsBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, side, side, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    // No mips: cells would bleed into each other
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+    return tex;
+}
+
+// Direction of cell (x, y): the center of the cell on the hemi-octahedron
+static glm::vec3 cellDirection(int x, int y, int views)
+{
+    glm::vec2 e = (glm::vec2(x, y) + 0.5f) / (float)views * 2.0f - 1.0f;
+    glm::vec2 t = glm::vec2(e.x + e.y, e.x - e.y) * 0.5f;
+    return glm::normalize(glm::vec3(t.x, 1.0f - fabsf(t.x) - fabsf(t.y), t.y));
+}
+
+bool ImpostorAtlas::init(const ImpostorSettings& s, GLuint mainProgram, const glm::vec3& c,
+                         float r, int firstUnit, int skinUnit)
+{
+    settings = s;
+    if (settings.viewsPerSide < 2) settings.viewsPerSide = 2;
+    if (settings.phases < 1) settings.phases = 1;
+    if (settings.cellSize < 8) settings.cellSize = 8;
+    // smoothstep needs a non-empty band
+    if (settings.fadeRange < 1e-3f) settings.fadeRange = 1e-3f;
+    center = c;
+    radius = r;
+    unit = firstUnit;
+    atlasSide = settings.viewsPerSide * settings.cellSize;
+
+    GLint maxSide = 0, maxLayers = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSide);
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    if (atlasSide > maxSide || settings.phases > maxLayers) {
+        std::cerr << "Impostor atlas " << atlasSide << "x" << atlasSide << "x" << settings.phases
+                  << " exceeds the GL limits" << std::endl;
+        return false;
+    }
+
+    const GLuint prevProgram = glStateProgram(), prevFbo = glStateDrawFramebuffer();
+
+    glsActiveTexture(GL_TEXTURE0 + unit);
+    surface = makeArray(atlasSide, settings.phases);
+    glsActiveTexture(GL_TEXTURE0 + unit + 1);
+    normal = makeArray(atlasSide, settings.phases);
+    glsActiveTexture(GL_TEXTURE0);
+
+    glGenRenderbuffers(1, &depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, atlasSide, atlasSide);
+    glGenFramebuffers(1, &fbo);
+    glsBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, surface, 0, 0);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, normal, 0, 0);
+    const GLenum buffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, buffers);
+    bool ok = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glsBindFramebuffer(GL_FRAMEBUFFER, prevFbo);
+    if (!ok) {
+        std::cerr << "Impostor bake target is incomplete" << std::endl;
+        shutdown();
+        return false;
+    }
+
+    // Bake: the scene vertex shader (skinning, attribute slots) writing attributes
+    bakeProgram = InitShader("src/vshader.glsl", "src/impostor_bake_fshader.glsl");
+    glBindFragDataLocation(bakeProgram, 0, "fSurface");
+    glBindFragDataLocation(bakeProgram, 1, "fNormal");
+    bindAttribs(bakeProgram, mainProgram, kMeshAttribs, sizeof(kMeshAttribs) / sizeof(kMeshAttribs[0]));
+
+    // Draw: quads over the crowd VAO's instance attributes, lit like the scene
+    drawProgram = InitShader("src/impostor_vshader.glsl", "src/impostor_fshader.glsl");
+    bindAttribs(drawProgram, mainProgram, kInstanceAttribs, sizeof(kInstanceAttribs) / sizeof(kInstanceAttribs[0]));
+    glsUseProgram(drawProgram);
+    projectLoc = glGetUniformLocation(drawProgram, "mProject");
+    viewLoc = glGetUniformLocation(drawProgram, "mView");
+    viewPosLoc = glGetUniformLocation(drawProgram, "viewPos");
+    animTimeLoc = glGetUniformLocation(drawProgram, "animTime");
+    glsUniform3fv(glGetUniformLocation(drawProgram, "impCenter"), 1, &center[0]);
+    glsUniform1f(glGetUniformLocation(drawProgram, "impRadius"), radius);
+    glsUniform1i(glGetUniformLocation(drawProgram, "impViews"), settings.viewsPerSide);
+    glsUniform1i(glGetUniformLocation(drawProgram, "impPhases"), settings.phases);
+    glsUniform2f(glGetUniformLocation(drawProgram, "lodFade"),
+                settings.distance - settings.fadeRange, settings.distance);
+    glsUniform1i(glGetUniformLocation(drawProgram, "impSurface"), unit);
+    glsUniform1i(glGetUniformLocation(drawProgram, "impNormal"), unit + 1);
+    glsUniform1i(glGetUniformLocation(drawProgram, "skinTextures"), skinUnit);
+    for (size_t i = 0; i < sizeof(kLightingUniforms) / sizeof(kLightingUniforms[0]); i++) {
+        GLfloat v[3];
+        glGetUniformfv(mainProgram, glGetUniformLocation(mainProgram, kLightingUniforms[i]), v);
+        glsUniform3fv(glGetUniformLocation(drawProgram, kLightingUniforms[i]), 1, v);
+    }
+    GLfloat shininess;
+    glGetUniformfv(mainProgram, glGetUniformLocation(mainProgram, "materialShininess"), &shininess);
+    glsUniform1f(glGetUniformLocation(drawProgram, "materialShininess"), shininess);
+    glsUseProgram(prevProgram);
+
+    printf("Impostors: %d x %d views, %d phases, %d-texel cells, %.1f MB GPU\n",
+        settings.viewsPerSide, settings.viewsPerSide, settings.phases, settings.cellSize,
+        gpuBytes() / 1048576.0);
+    return true;
+}
+
+void ImpostorAtlas::shutdown()
+{
+    if (fbo) glsDeleteFramebuffers(1, &fbo);
+    if (depth) glDeleteRenderbuffers(1, &depth);
+    if (surface) glsDeleteTextures(1, &surface);
+    if (normal) glsDeleteTextures(1, &normal);
+    if (bakeProgram) glDeleteProgram(bakeProgram);
+    if (drawProgram) glDeleteProgram(drawProgram);
+    fbo = depth = surface = normal = bakeProgram = drawProgram = 0;
+}
+
+size_t ImpostorAtlas::gpuBytes() const
+{
+    return (size_t)atlasSide * atlasSide * 4 * (2 * settings.phases + 1);
+}
+
+void ImpostorAtlas::bake(ImpostorDrawFn drawFn)
+{
+    const GLuint prevProgram = glStateProgram();
+    GLint viewport[4];
+    glStateViewport(viewport);
+    GLfloat clear[4];
+    glStateClearColor(clear);
+
+    glsUseProgram(bakeProgram);
+    const GLint bakeProjectLoc = glGetUniformLocation(bakeProgram, "mProject");
+    const GLint bakeViewLoc = glGetUniformLocation(bakeProgram, "mView");
+    // Orthographic, just enclosing the bounding sphere from 2 radii out
+    const glm::mat4 proj = glm::ortho(-radius, radius, -radius, radius, radius, 3.0f * radius);
+    glsUniformMatrix4fv(bakeProjectLoc, 1, GL_FALSE, &proj[0][0]);
+
+    glsBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glsClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    const int views = settings.viewsPerSide, cs = settings.cellSize;
+    for (int p = 0; p < settings.phases; p++) {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, surface, 0, p);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, normal, 0, p);
+        glsViewport(0, 0, atlasSide, atlasSide);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        for (int y = 0; y < views; y++) {
+            for (int x = 0; x < views; x++) {
+                // Same basis as sampleView() in impostor_fshader.glsl
+                glm::vec3 d = cellDirection(x, y, views);
+                glm::vec3 up = fabsf(d.y) > 0.999f ? glm::vec3(0, 0, -1) : glm::vec3(0, 1, 0);
+                glm::mat4 view = glm::lookAt(center + d * (2.0f * radius), center, up);
+                glsUniformMatrix4fv(bakeViewLoc, 1, GL_FALSE, &view[0][0]);
+                glsViewport(x * cs, y * cs, cs, cs);
+                drawFn(p, bakeProgram);
+            }
+        }
+    }
+
+    glsBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glsViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glsClearColor(clear[0], clear[1], clear[2], clear[3]);
+    glsUseProgram(prevProgram);
+}
+
+void ImpostorAtlas::draw(GLuint vao, int count, const glm::mat4& proj, const glm::mat4& view,
+                         const glm::vec3& eye, float animTime)
+{
+    if (count <= 0) return;
+    PROFILE_GPU_ZONE("ImpostorAtlas::draw");
+    const GLuint prevProgram = glStateProgram();
+    glsUseProgram(drawProgram);
+    glsUniformMatrix4fv(projectLoc, 1, GL_FALSE, &proj[0][0]);
+    glsUniformMatrix4fv(viewLoc, 1, GL_FALSE, &view[0][0]);
+    glsUniform3fv(viewPosLoc, 1, &eye[0]);
+    glsUniform1f(animTimeLoc, animTime);
+    glsBindVertexArray(vao);
+    glsDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+    glsUseProgram(prevProgram);
+}
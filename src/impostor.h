@@ -0,0 +1,63 @@
+#pragma once
+#include "GL/glew.h"
+#include "glm/glm.hpp"
+
+// Octahedral impostors for distant crowd members.
+//
+// The swimmer is pre-rendered once, at init, from viewsPerSide^2 directions
+// over the upper hemisphere (hemi-octahedral grid, +Y up) and at `phases`
+// evenly spaced points of the swim cycle. Each phase is one layer of two
+// texture arrays holding surface attributes rather than colour, so a single
+// atlas serves every skin and lighting stays live:
+//   surface  RG: texture coordinate, A: coverage
+//   normal   RGB: world normal * 0.5 + 0.5
+// At draw time every instance is one camera-facing quad. impostor_fshader.glsl
+// reprojects each pixel into the four nearest views and the two nearest
+// phases, blends them, and shades like fshader.glsl (without shadows).
+// Swimmers only translate, so world and bake directions agree.
+
+// Draw the swimmer at phase index `phase` with `program` (vshader.glsl plus
+// the bake fragment shader) bound; mProject/mView are already set.
+typedef void (*ImpostorDrawFn)(int phase, GLuint program);
+
+struct ImpostorSettings {
+    int   viewsPerSide = 8;         // view grid is viewsPerSide^2 cells
+    int   phases = 8;               // cycle samples (array layers)
+    int   cellSize = 64;            // texels per cell side
+    float distance = 0.0f;          // eye distance where the mesh is gone; 0 = impostors off
+    float fadeRange = 2.0f;         // cross-fade band, ending at distance
+};
+
+class ImpostorAtlas {
+public:
+    // mainProgram supplies the attribute slots (the bake program reuses
+    // vshader.glsl, the draw program the crowd VAO's instance attributes)
+    // and the lighting uniforms. center/radius bound the swimmer over the
+    // whole cycle, relative to its root. The atlas goes to units
+    // firstUnit and firstUnit + 1; skinUnit holds the skin texture array.
+    bool init(const ImpostorSettings& settings, GLuint mainProgram, const glm::vec3& center,
+              float radius, int firstUnit, int skinUnit);
+    void shutdown();
+
+    // Render every view and phase. Restores FBO 0, the viewport and the program.
+    void bake(ImpostorDrawFn draw);
+
+    // count instances from vao (instance attributes only) as quads.
+    // Restores the program.
+    void draw(GLuint vao, int count, const glm::mat4& proj, const glm::mat4& view,
+              const glm::vec3& eye, float animTime);
+
+    const ImpostorSettings& config() const { return settings; }
+    size_t gpuBytes() const;
+
+private:
+    ImpostorSettings settings;
+    glm::vec3 center;
+    float radius = 1.0f;
+    int unit = 0;
+    int atlasSide = 0;
+    GLuint surface = 0, normal = 0;
+    GLuint fbo = 0, depth = 0;
+    GLuint bakeProgram = 0, drawProgram = 0;
+    GLint projectLoc = -1, viewLoc = -1, viewPosLoc = -1, animTimeLoc = -1;
+};
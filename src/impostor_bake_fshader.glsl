@@ -0,0 +1,16 @@
+#version 150
+
+// Impostor bake: surface attributes instead of colour, so the atlas works
+// for every skin and the light can still move.
+
+in  vec3 fragNormal;
+in  vec2 texCoord;
+
+out vec4 fSurface;      // RG: texture coordinate, A: coverage
+out vec4 fNormal;       // RGB: world normal * 0.5 + 0.5
+
+void main()
+{
+    fSurface = vec4(texCoord, 0.0, 1.0);
+    fNormal = vec4(normalize(fragNormal) * 0.5 + 0.5, 1.0);
+}
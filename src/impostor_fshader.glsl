@@ -0,0 +1,97 @@
+#version 150
+
+in  vec3 worldPos;
+flat in vec3 center;
+flat in ivec2 cell;
+flat in vec2 cellWeight;
+flat in ivec2 layer;
+flat in float layerWeight;
+flat in float skinLayer;
+flat in float fade;
+
+out vec4 fColor;
+
+uniform vec3 viewPos;
+uniform float impRadius;
+uniform int impViews;
+uniform sampler2DArray impSurface;  // RG: texture coordinate, A: coverage
+uniform sampler2DArray impNormal;
+uniform sampler2DArray skinTextures;
+
+uniform vec3 lightPos;
+uniform vec3 lightAmbient;
+uniform vec3 lightDiffuse;
+uniform vec3 lightSpecular;
+uniform vec3 materialAmbient;
+uniform vec3 materialDiffuse;
+uniform vec3 materialSpecular;
+uniform float materialShininess;
+
+vec3 hemiOctDecode(vec2 e)
+{
+    vec2 t = vec2(e.x + e.y, e.x - e.y) * 0.5;
+    return normalize(vec3(t.x, 1.0 - abs(t.x) - abs(t.y), t.y));
+}
+
+// 4x4 ordered dither in (0, 1); the mesh keeps the complementary pixels
+float bayer4(vec2 p)
+{
+    ivec2 i = ivec2(mod(p, 4.0));
+    int b[16] = int[16](0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5);
+    return (float(b[i.y * 4 + i.x]) + 0.5) / 16.0;
+}
+
+vec3 g_base, g_normal;
+float g_weight;
+
+// The pixel's eye ray meets the plane through the center facing view c;
+// sample the view there, the way the bake camera saw it.
+void sampleView(ivec2 c, float w)
+{
+    vec3 d = hemiOctDecode((vec2(c) + 0.5) / float(impViews) * 2.0 - 1.0);
+    vec3 up0 = abs(d.y) > 0.999 ? vec3(0.0, 0.0, -1.0) : vec3(0.0, 1.0, 0.0);
+    vec3 right = normalize(cross(up0, d));
+    vec3 up = cross(d, right);
+
+    vec3 ray = worldPos - viewPos;
+    vec3 q = viewPos + ray * (dot(center - viewPos, d) / dot(ray, d)) - center;
+    vec2 uv = vec2(dot(q, right), dot(q, up)) / impRadius * 0.5 + 0.5;
+    if (any(lessThan(uv, vec2(0.0))) || any(greaterThan(uv, vec2(1.0)))) return;
+
+    float halfTexel = 0.5 / float(textureSize(impSurface, 0).x / impViews);
+    vec2 atlas = (vec2(c) + clamp(uv, halfTexel, 1.0 - halfTexel)) / float(impViews);
+    for (int k = 0; k < 2; k++) {
+        float wk = w * (k == 0 ? 1.0 - layerWeight : layerWeight);
+        vec3 at = vec3(atlas, float(k == 0 ? layer.x : layer.y));
+        vec4 s = texture(impSurface, at);
+        float a = wk * s.a;
+        if (a <= 0.0) continue;
+        g_base += a * texture(skinTextures, vec3(s.rg / max(s.a, 1e-3), skinLayer)).rgb;
+        g_normal += a * (texture(impNormal, at).rgb / max(s.a, 1e-3) * 2.0 - 1.0);
+        g_weight += a;
+    }
+}
+
+void main()
+{
+    if (fade < 1.0 && bayer4(gl_FragCoord.xy) < 1.0 - fade) discard;
+
+    g_base = vec3(0.0);
+    g_normal = vec3(0.0);
+    g_weight = 0.0;
+    sampleView(cell, (1.0 - cellWeight.x) * (1.0 - cellWeight.y));
+    sampleView(cell + ivec2(1, 0), cellWeight.x * (1.0 - cellWeight.y));
+    sampleView(cell + ivec2(0, 1), (1.0 - cellWeight.x) * cellWeight.y);
+    sampleView(cell + ivec2(1, 1), cellWeight.x * cellWeight.y);
+    if (g_weight < 0.5) discard;
+
+    // Same Blinn-Phong as fshader.glsl, without shadows
+    vec3 N = normalize(g_normal);
+    vec3 L = normalize(lightPos - worldPos);
+    vec3 V = normalize(viewPos - worldPos);
+    float diff = max(dot(N, L), 0.0);
+    float spec = diff > 0.0 ? pow(max(dot(N, normalize(L + V)), 0.0), materialShininess) : 0.0;
+    vec3 color = (lightAmbient * materialAmbient + lightDiffuse * materialDiffuse * diff +
+                  lightSpecular * materialSpecular * spec) * (g_base / g_weight);
+    fColor = vec4(color, 1.0);
+}
@@ -0,0 +1,63 @@
+#version 150
+
+// Octahedral impostor: one camera-facing quad per instance (4-vertex strip,
+// corners from gl_VertexID). Picks the four nearest baked views around the
+// direction to the eye and the two phases around the instance's cycle
+// position; impostor_fshader.glsl blends them.
+
+in  vec3 vInstanceOffset;   // per instance, as the crowd VAO
+in  vec2 vInstancePhase;    // phase and cycle length, seconds
+in  float vSkinLayer;
+
+out vec3 worldPos;
+flat out vec3 center;
+flat out ivec2 cell;        // lower-left of the 2x2 view cells
+flat out vec2 cellWeight;
+flat out ivec2 layer;       // the two phases
+flat out float layerWeight;
+flat out float skinLayer;
+flat out float fade;
+
+uniform mat4 mProject;
+uniform mat4 mView;
+uniform vec3 viewPos;
+uniform float animTime;
+
+uniform vec3 impCenter;     // bake bounds, relative to the instance root
+uniform float impRadius;
+uniform int impViews;       // cells per side
+uniform int impPhases;
+uniform vec2 lodFade;       // fades in over this eye-distance band
+
+vec2 hemiOctEncode(vec3 d)
+{
+    vec2 p = d.xz / (abs(d.x) + abs(d.y) + abs(d.z));
+    return vec2(p.x + p.y, p.x - p.y);
+}
+
+void main()
+{
+    center = vInstanceOffset + impCenter;
+    vec3 toEye = viewPos - center;
+    vec3 d = normalize(vec3(toEye.x, max(toEye.y, 0.0), toEye.z) + vec3(0.0, 1e-4, 0.0));
+
+    vec2 g = (hemiOctEncode(d) * 0.5 + 0.5) * float(impViews) - 0.5;
+    vec2 c0 = clamp(floor(g), 0.0, float(impViews - 2));
+    cell = ivec2(c0);
+    cellWeight = clamp(g - c0, 0.0, 1.0);
+
+    float f = fract((animTime + vInstancePhase.x) / vInstancePhase.y) * float(impPhases);
+    layer.x = min(int(f), impPhases - 1);
+    layer.y = (layer.x + 1) % impPhases;
+    layerWeight = f - float(layer.x);
+
+    skinLayer = vSkinLayer;
+    fade = smoothstep(lodFade.x, lodFade.y, distance(viewPos, vInstanceOffset));
+
+    // Billboard spanning the bake bounds, in the camera's plane
+    vec3 right = vec3(mView[0][0], mView[1][0], mView[2][0]);
+    vec3 up = vec3(mView[0][1], mView[1][1], mView[2][1]);
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+    worldPos = center + (right * corner.x + up * corner.y) * impRadius;
+    gl_Position = mProject * mView * vec4(worldPos, 1.0);
+}
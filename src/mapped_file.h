@@ -0,0 +1,27 @@
+#pragma once
+#include <stddef.h>
+
+// Read-only memory-mapped file (MapViewOfFile on Windows, mmap elsewhere).
+class MappedFile {
+public:
+    MappedFile() {}
+    ~MappedFile() { close(); }
+
+    bool open(const char* path);
+    void close();
+
+    const unsigned char* data() const { return base; }
+    size_t size() const { return length; }
+    bool isOpen() const { return base != NULL; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const unsigned char* base = NULL;
+    size_t length = 0;
+#ifdef _WIN32
+    void* fileHandle = NULL;
+    void* mappingHandle = NULL;
+#endif
+};
@@ -0,0 +1,265 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <unordered_map>
+
+#include "mesh_cache.h"
+#include "gl_stats.h"
+
+static const uint64_t BLOCK_ALIGN = 64;
+
+static inline uint64_t alignUp(uint64_t v) { return (v + BLOCK_ALIGN - 1) & ~(BLOCK_ALIGN - 1); }
+
+// ---------- Writer ----------
+namespace {
+struct Vertex {
+    glm::vec4 p, n, c;
+    glm::vec2 t;
+    bool operator==(const Vertex& o) const { return memcmp(this, &o, sizeof(Vertex)) == 0; }
+};
+
+struct VertexHash {
+    size_t operator()(const Vertex& v) const
+    {
+        // FNV-1a over the raw floats; welding is exact, so bitwise is right
+        const unsigned char* b = (const unsigned char*)&v;
+        size_t h = 1469598103u;
+        for (size_t i = 0; i < sizeof(Vertex); i++) h = (h ^ b[i]) * 16777619u;
+        return h;
+    }
+};
+}
+
+void appendMeshLod(MeshData& mesh, const glm::vec4* positions, const glm::vec4* normals,
+                   const glm::vec4* colors, const glm::vec2* texCoords, size_t count,
+                   float maxDistance)
+{
+    MeshLod lod;
+    memset(&lod, 0, sizeof(lod));
+    lod.firstIndex = (uint32_t)mesh.indices.size();
+    lod.firstVertex = (uint32_t)mesh.positions.size();
+    lod.maxDistance = maxDistance;
+
+    std::unordered_map<Vertex, uint32_t, VertexHash> seen;
+    seen.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        Vertex v;
+        memset(&v, 0, sizeof(v));      // padding-free, but keep the hash deterministic
+        v.p = positions[i];
+        v.n = normals[i];
+        v.c = colors ? colors[i] : glm::vec4(1.0f);
+        v.t = texCoords[i];
+        auto it = seen.find(v);
+        if (it == seen.end()) {
+            it = seen.emplace(v, (uint32_t)mesh.positions.size()).first;
+            mesh.positions.push_back(v.p);
+            mesh.normals.push_back(v.n);
+            mesh.colors.push_back(v.c);
+            mesh.texCoords.push_back(v.t);
+        }
+        mesh.indices.push_back(it->second);
+    }
+    lod.indexCount = (uint32_t)(mesh.indices.size() - lod.firstIndex);
+    lod.vertexCount = (uint32_t)(mesh.positions.size() - lod.firstVertex);
+    mesh.lods.push_back(lod);
+}
+
+void appendMeshLod(MeshData& mesh, const glm::vec4* positions, const glm::vec4* normals,
+                   const glm::vec4* colors, const glm::vec2* texCoords, size_t vertexCount,
+                   const uint32_t* indices, size_t indexCount, float maxDistance)
+{
+    MeshLod lod;
+    memset(&lod, 0, sizeof(lod));
+    lod.firstIndex = (uint32_t)mesh.indices.size();
+    lod.firstVertex = (uint32_t)mesh.positions.size();
+    lod.indexCount = (uint32_t)indexCount;
+    lod.vertexCount = (uint32_t)vertexCount;
+    lod.maxDistance = maxDistance;
+
+    mesh.positions.insert(mesh.positions.end(), positions, positions + vertexCount);
+    mesh.normals.insert(mesh.normals.end(), normals, normals + vertexCount);
+    if (colors) mesh.colors.insert(mesh.colors.end(), colors, colors + vertexCount);
+    else mesh.colors.resize(mesh.colors.size() + vertexCount, glm::vec4(1.0f));
+    mesh.texCoords.insert(mesh.texCoords.end(), texCoords, texCoords + vertexCount);
+    mesh.indices.reserve(mesh.indices.size() + indexCount);
+    for (size_t i = 0; i < indexCount; i++) mesh.indices.push_back(lod.firstVertex + indices[i]);
+    mesh.lods.push_back(lod);
+}
+
+static bool serializeMesh(const MeshData& mesh, uint32_t sourceKey, std::vector<unsigned char>& out)
+{
+    const size_t nv = mesh.positions.size();
+    if (!nv || mesh.lods.empty() || mesh.lods.size() > MESH_MAX_LODS || mesh.normals.size() != nv ||
+        mesh.colors.size() != nv || mesh.texCoords.size() != nv || (!mesh.bones.empty() && mesh.bones.size() != nv))
+        return false;
+
+    MeshFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "MESH", 4);
+    h.version = MESH_FILE_VERSION;
+    h.sourceKey = sourceKey;
+    h.vertexCount = (uint32_t)nv;
+    h.indexCount = (uint32_t)mesh.indices.size();
+    h.indexSize = nv > 0xFFFF ? 4 : 2;
+    h.lodCount = (uint32_t)mesh.lods.size();
+    for (size_t i = 0; i < mesh.lods.size(); i++) h.lod[i] = mesh.lods[i];
+
+    glm::vec3 lo(mesh.positions[0]), hi(lo);
+    for (size_t i = 1; i < nv; i++) {
+        lo = glm::min(lo, glm::vec3(mesh.positions[i]));
+        hi = glm::max(hi, glm::vec3(mesh.positions[i]));
+    }
+    glm::vec3 c = (lo + hi) * 0.5f;
+    float r2 = 0.0f;
+    for (size_t i = 0; i < nv; i++) {
+        glm::vec3 d = glm::vec3(mesh.positions[i]) - c;
+        r2 = std::max(r2, glm::dot(d, d));
+    }
+    for (int k = 0; k < 3; k++) {
+        h.boundsMin[k] = lo[k];
+        h.boundsMax[k] = hi[k];
+        h.center[k] = c[k];
+    }
+    h.radius = sqrtf(r2);
+
+    const uint32_t comps[MESH_SEMANTIC_COUNT] = { 4, 4, 4, 2, mesh.bones.empty() ? 0u : 1u };
+    const void* src[MESH_SEMANTIC_COUNT] = {
+        mesh.positions.data(), mesh.normals.data(), mesh.colors.data(), mesh.texCoords.data(), mesh.bones.data()
+    };
+    uint64_t off = 0;
+    for (int s = 0; s < MESH_SEMANTIC_COUNT; s++) {
+        h.stream[s].components = comps[s];
+        h.stream[s].offset = off;
+        off += (uint64_t)nv * comps[s] * sizeof(float);
+    }
+    h.vertexOffset = alignUp(sizeof(h));
+    h.vertexBytes = off;
+    h.indexOffset = alignUp(h.vertexOffset + h.vertexBytes);
+    h.indexBytes = (uint64_t)h.indexCount * h.indexSize;
+
+    out.assign((size_t)(h.indexOffset + h.indexBytes), 0);
+    memcpy(&out[0], &h, sizeof(h));
+    for (int s = 0; s < MESH_SEMANTIC_COUNT; s++)
+        if (comps[s]) memcpy(&out[(size_t)(h.vertexOffset + h.stream[s].offset)], src[s], nv * comps[s] * sizeof(float));
+    unsigned char* idx = &out[(size_t)h.indexOffset];
+    for (size_t i = 0; i < mesh.indices.size(); i++) {
+        if (h.indexSize == 2) {
+            uint16_t v = (uint16_t)mesh.indices[i];
+            memcpy(idx + i * 2, &v, 2);
+        }
+        else memcpy(idx + i * 4, &mesh.indices[i], 4);
+    }
+    return true;
+}
+
+static bool writeBlob(const char* path, const std::vector<unsigned char>& blob)
+{
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(&blob[0], 1, blob.size(), f) == blob.size();
+    fclose(f);
+    if (!ok) remove(path);
+    return ok;
+}
+
+bool writeMeshFile(const char* path, const MeshData& mesh, uint32_t sourceKey)
+{
+    std::vector<unsigned char> out;
+    return serializeMesh(mesh, sourceKey, out) && writeBlob(path, out);
+}
+
+// ---------- Reader ----------
+static bool validateMesh(const unsigned char* data, size_t size, uint32_t sourceKey, MeshFileHeader& h)
+{
+    bool ok = size >= sizeof(h);
+    if (ok) memcpy(&h, data, sizeof(h));
+    ok = ok && memcmp(h.magic, "MESH", 4) == 0 && h.version == MESH_FILE_VERSION && h.sourceKey == sourceKey &&
+         (h.indexSize == 2 || h.indexSize == 4) && h.lodCount >= 1 && h.lodCount <= MESH_MAX_LODS &&
+         h.vertexOffset <= size && h.vertexBytes <= size - h.vertexOffset &&
+         h.indexOffset <= size && h.indexBytes <= size - h.indexOffset &&
+         h.indexBytes == (uint64_t)h.indexCount * h.indexSize;
+    for (int s = 0; ok && s < MESH_SEMANTIC_COUNT; s++)
+        ok = h.stream[s].components <= 4 &&
+             h.stream[s].offset + (uint64_t)h.vertexCount * h.stream[s].components * sizeof(float) <= h.vertexBytes;
+    for (uint32_t i = 0; ok && i < h.lodCount; i++)
+        ok = (uint64_t)h.lod[i].firstIndex + h.lod[i].indexCount <= h.indexCount &&
+             (uint64_t)h.lod[i].firstVertex + h.lod[i].vertexCount <= h.vertexCount;
+    return ok;
+}
+
+bool MeshFile::open(const char* path, uint32_t sourceKey)
+{
+    if (!file.open(path)) return false;
+    if (validateMesh(file.data(), file.size(), sourceKey, h)) return true;
+    file.close();
+    return false;
+}
+
+void bindMeshAttribs(const GpuMesh& gpu, const GLint attribs[MESH_SEMANTIC_COUNT])
+{
+    glsBindBuffer(GL_ARRAY_BUFFER, gpu.vbo);
+    for (int s = 0; s < MESH_SEMANTIC_COUNT; s++) {
+        if (attribs[s] < 0 || !gpu.stream[s].components) continue;
+        glEnableVertexAttribArray(attribs[s]);
+        glVertexAttribPointer(attribs[s], gpu.stream[s].components, GL_FLOAT, GL_FALSE, 0,
+            (const GLvoid*)(size_t)gpu.stream[s].offset);
+    }
+    glsBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpu.ibo);
+}
+
+static void uploadBlob(const MeshFileHeader& h, const unsigned char* base,
+                       const GLint attribs[MESH_SEMANTIC_COUNT], GpuMesh& gpu)
+{
+    gpu.indexType = h.indexSize == 4 ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+    gpu.lodCount = (int)h.lodCount;
+    for (int i = 0; i < gpu.lodCount; i++) gpu.lod[i] = h.lod[i];
+    for (int s = 0; s < MESH_SEMANTIC_COUNT; s++) gpu.stream[s] = h.stream[s];
+    gpu.center = glm::vec3(h.center[0], h.center[1], h.center[2]);
+    gpu.radius = h.radius;
+
+    glGenVertexArrays(1, &gpu.vao);
+    glsBindVertexArray(gpu.vao);
+    glGenBuffers(1, &gpu.vbo);
+    glsBindBuffer(GL_ARRAY_BUFFER, gpu.vbo);
+    glsBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)h.vertexBytes, base + h.vertexOffset, GL_STATIC_DRAW);
+    glGenBuffers(1, &gpu.ibo);
+    glsBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpu.ibo);
+    glsBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)h.indexBytes, base + h.indexOffset, GL_STATIC_DRAW);
+    bindMeshAttribs(gpu, attribs);
+}
+
+bool uploadMesh(const MeshFile& file, const GLint attribs[MESH_SEMANTIC_COUNT], GpuMesh& gpu)
+{
+    if (!file.isOpen()) return false;
+    uploadBlob(file.header(), file.data(), attribs, gpu);
+    return true;
+}
+
+int selectMeshLod(const GpuMesh& gpu, float distance)
+{
+    for (int i = 0; i < gpu.lodCount - 1; i++)
+        if (distance <= gpu.lod[i].maxDistance) return i;
+    return gpu.lodCount - 1;
+}
+
+bool loadMeshCached(const char* path, uint32_t sourceKey, MeshBakeFn bake,
+                    const GLint attribs[MESH_SEMANTIC_COUNT], GpuMesh& gpu)
+{
+    MeshFile file;
+    if (file.open(path, sourceKey)) return uploadMesh(file, attribs, gpu);
+
+    // Missing or stale: bake, write for next time, upload from memory
+    printf("Baking mesh %s\n", path);
+    MeshData mesh;
+    bake(mesh);
+    std::vector<unsigned char> blob;
+    MeshFileHeader h;
+    if (!serializeMesh(mesh, sourceKey, blob) || !validateMesh(&blob[0], blob.size(), sourceKey, h))
+        return false;
+    if (!writeBlob(path, blob)) printf("Could not write mesh cache %s\n", path);
+    uploadBlob(h, &blob[0], attribs, gpu);
+    return true;
+}
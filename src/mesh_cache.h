@@ -0,0 +1,136 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "GL/glew.h"
+#include "glm/glm.hpp"
+#include "mapped_file.h"
+
+// Binary mesh file (.mesh, little endian), laid out so it can be memory-
+// mapped and handed to glBufferData as-is:
+//
+//   MeshFileHeader | vertex block | index block
+//
+// The vertex block holds one non-interleaved stream per semantic (the same
+// layout the scene VAOs use); the index block holds every LOD's indices,
+// already offset to that LOD's vertices. Blocks start on 64-byte boundaries.
+
+enum { MESH_FILE_VERSION = 2, MESH_MAX_LODS = 8 };
+
+enum MeshSemantic {
+    MESH_POSITION,      // vec4
+    MESH_NORMAL,        // vec4, w = 0
+    MESH_COLOR,         // vec4
+    MESH_TEXCOORD,      // vec2
+    MESH_BONE,          // float bone index, optional (skinned meshes only)
+    MESH_SEMANTIC_COUNT
+};
+
+struct MeshStream {
+    uint32_t components;            // floats per vertex, 0 = absent
+    uint32_t reserved;
+    uint64_t offset;                // from the start of the vertex block
+};
+
+struct MeshLod {
+    uint32_t firstIndex, indexCount;
+    uint32_t firstVertex, vertexCount;
+    float    maxDistance;           // use this LOD up to this eye distance
+    uint32_t reserved;
+};
+
+struct MeshFileHeader {
+    char       magic[4];            // "MESH"
+    uint32_t   version;             // MESH_FILE_VERSION
+    uint32_t   sourceKey;           // identifies the generator/source; stale when it differs
+    uint32_t   vertexCount;
+    uint32_t   indexCount;
+    uint32_t   indexSize;           // 2 or 4 bytes
+    uint32_t   lodCount;
+    uint32_t   reserved;
+    float      boundsMin[3], boundsMax[3];
+    float      center[3], radius;   // bounding sphere
+    MeshStream stream[MESH_SEMANTIC_COUNT];
+    MeshLod    lod[MESH_MAX_LODS];
+    uint64_t   vertexOffset, vertexBytes;
+    uint64_t   indexOffset, indexBytes;
+};
+
+// ---------- Writer ----------
+
+// Geometry as generated at runtime, before baking
+struct MeshData {
+    std::vector<glm::vec4> positions, normals, colors;
+    std::vector<glm::vec2> texCoords;
+    std::vector<float> bones;           // empty, or one bone index per vertex
+    std::vector<uint32_t> indices;      // absolute
+    std::vector<MeshLod> lods;
+};
+
+// Weld a triangle list (identical vertices shared) and append it as the next
+// LOD. colors may be NULL (white).
+void appendMeshLod(MeshData& mesh, const glm::vec4* positions, const glm::vec4* normals,
+                   const glm::vec4* colors, const glm::vec2* texCoords, size_t count,
+                   float maxDistance);
+
+// Append already indexed geometry (indices relative to these vertices) as
+// the next LOD, as-is. colors may be NULL (white).
+void appendMeshLod(MeshData& mesh, const glm::vec4* positions, const glm::vec4* normals,
+                   const glm::vec4* colors, const glm::vec2* texCoords, size_t vertexCount,
+                   const uint32_t* indices, size_t indexCount, float maxDistance);
+
+bool writeMeshFile(const char* path, const MeshData& mesh, uint32_t sourceKey);
+
+// ---------- Reader ----------
+
+// Maps a .mesh file; fails when malformed or when sourceKey differs.
+class MeshFile {
+public:
+    bool open(const char* path, uint32_t sourceKey);
+    void close() { file.close(); }
+    bool isOpen() const { return file.isOpen(); }
+
+    const MeshFileHeader& header() const { return h; }
+    const unsigned char* data() const { return file.data(); }
+    const unsigned char* vertexData() const { return file.data() + h.vertexOffset; }
+    const unsigned char* indexData() const { return file.data() + h.indexOffset; }
+
+private:
+    MappedFile file;
+    MeshFileHeader h;
+};
+
+// GL buffers for a mesh; vertex/index blocks go to glBufferData straight
+// from the mapping.
+struct GpuMesh {
+    GLuint vao = 0, vbo = 0, ibo = 0;
+    GLenum indexType = GL_UNSIGNED_SHORT;
+    int lodCount = 0;
+    MeshLod lod[MESH_MAX_LODS];
+    MeshStream stream[MESH_SEMANTIC_COUNT];
+    glm::vec3 center;
+    float radius = 0.0f;
+};
+
+// attribs[semantic] is the attribute slot, or -1 to skip the stream.
+// Creates gpu.vao with every stream and the index buffer attached.
+bool uploadMesh(const MeshFile& file, const GLint attribs[MESH_SEMANTIC_COUNT], GpuMesh& gpu);
+
+// Attach the mesh streams and index buffer to the currently bound VAO
+// (for extra VAOs sharing the buffers, e.g. with instance attributes).
+void bindMeshAttribs(const GpuMesh& gpu, const GLint attribs[MESH_SEMANTIC_COUNT]);
+
+// Coarsest LOD whose maxDistance still covers distance
+int selectMeshLod(const GpuMesh& gpu, float distance);
+
+inline const GLvoid* meshLodIndexOffset(const GpuMesh& gpu, int lod)
+{
+    return (const GLvoid*)((size_t)gpu.lod[lod].firstIndex * (gpu.indexType == GL_UNSIGNED_INT ? 4 : 2));
+}
+
+// Load path if it matches sourceKey; otherwise run bake(), write the file for
+// next time and upload the baked data. Returns false only if nothing could be
+// uploaded.
+typedef void (*MeshBakeFn)(MeshData& out);
+bool loadMeshCached(const char* path, uint32_t sourceKey, MeshBakeFn bake,
+                    const GLint attribs[MESH_SEMANTIC_COUNT], GpuMesh& gpu);
@@ -0,0 +1,479 @@
+#include "mesh_gen.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define GEN_SSE2 1
+#  include <emmintrin.h>
+#else
+#  define GEN_SSE2 0
+#endif
+
+static const float kPi = 3.14159265358979f;
+
+// ---------- sincos ----------
+// Cephes sinf/cosf: reduce by multiples of pi/4 in three parts (exact for
+// |x| up to ~8192), then a degree-7 sin / degree-8 cos polynomial picked per
+// octant. The scalar path is the same computation so tails match the SIMD
+// lanes bit for bit.
+static const float kFourOverPi = 1.27323954473516f;
+static const float kDP1 = 0.78515625f, kDP2 = 2.4187564849853515625e-4f, kDP3 = 3.77489497744594108e-8f;
+static const float kSin1 = -1.9515295891e-4f, kSin2 = 8.3321608736e-3f, kSin3 = -1.6666654611e-1f;
+static const float kCos1 = 2.443315711809948e-5f, kCos2 = -1.388731625493765e-3f, kCos3 = 4.166664568298827e-2f;
+
+static inline void sincosScalar(float x, float& s, float& c)
+{
+    float ax = fabsf(x);
+    int j = ((int)(ax * kFourOverPi) + 1) & ~1;
+    float y = (float)j;
+    float r = ((ax - y * kDP1) - y * kDP2) - y * kDP3;
+    float z = r * r;
+    float pc = ((kCos1 * z + kCos2) * z + kCos3) * z * z - 0.5f * z + 1.0f;
+    float ps = ((kSin1 * z + kSin2) * z + kSin3) * z * r + r;
+    bool swap = (j & 2) != 0;
+    float sv = swap ? pc : ps, cv = swap ? ps : pc;
+    if (((j & 4) != 0) != (x < 0.0f)) sv = -sv;
+    if (((j + 2) & 4) != 0) cv = -cv;
+    s = sv;
+    c = cv;
+}
+
+void sincosArray(const float* angle, float* s, float* c, size_t n)
+{
+    size_t i = 0;
+#if GEN_SSE2
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000));
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(angle + i);
+        __m128 ax = _mm_and_ps(x, absMask);
+        __m128i j = _mm_cvttps_epi32(_mm_mul_ps(ax, _mm_set1_ps(kFourOverPi)));
+        j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+        __m128 y = _mm_cvtepi32_ps(j);
+        __m128 r = _mm_sub_ps(ax, _mm_mul_ps(y, _mm_set1_ps(kDP1)));
+        r = _mm_sub_ps(r, _mm_mul_ps(y, _mm_set1_ps(kDP2)));
+        r = _mm_sub_ps(r, _mm_mul_ps(y, _mm_set1_ps(kDP3)));
+        __m128 z = _mm_mul_ps(r, r);
+
+        __m128 pc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kCos1), z), _mm_set1_ps(kCos2));
+        pc = _mm_add_ps(_mm_mul_ps(pc, z), _mm_set1_ps(kCos3));
+        pc = _mm_mul_ps(_mm_mul_ps(pc, z), z);
+        pc = _mm_add_ps(_mm_sub_ps(pc, _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_set1_ps(1.0f));
+        __m128 ps = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kSin1), z), _mm_set1_ps(kSin2));
+        ps = _mm_add_ps(_mm_mul_ps(ps, z), _mm_set1_ps(kSin3));
+        ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, z), r), r);
+
+        __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_set1_epi32(2)));
+        __m128 sv = _mm_or_ps(_mm_and_ps(swap, pc), _mm_andnot_ps(swap, ps));
+        __m128 cv = _mm_or_ps(_mm_and_ps(swap, ps), _mm_andnot_ps(swap, pc));
+        __m128 sinSign = _mm_xor_ps(_mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29)),
+                                    _mm_and_ps(x, signMask));
+        __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(
+            _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+        _mm_storeu_ps(s + i, _mm_xor_ps(sv, sinSign));
+        _mm_storeu_ps(c + i, _mm_xor_ps(cv, cosSign));
+    }
+#endif
+    for (; i < n; i++) sincosScalar(angle[i], s[i], c[i]);
+}
+
+// ---------- Threading ----------
+
+// Run fn(begin, end) over [0, rows) in contiguous slices, one per thread.
+// Every row writes a disjoint, precomputed range of the output.
+template<class Fn>
+static void parallelRows(int rows, size_t vertices, const MeshGenOptions& opt, Fn fn)
+{
+    int threads = 1;
+    if (vertices >= opt.parallelVertices) {
+        threads = opt.threads > 0 ? opt.threads : (int)std::thread::hardware_concurrency();
+        if (threads <= 0) threads = 1;
+    }
+    if (threads > rows) threads = rows;
+    if (threads <= 1) {
+        fn(0, rows);
+        return;
+    }
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++)
+        pool.emplace_back(fn, rows * t / threads, rows * (t + 1) / threads);
+    fn(0, rows / threads);
+    for (size_t i = 0; i < pool.size(); i++) pool[i].join();
+}
+
+static void resizeMesh(GenMesh& out, size_t vertices, size_t indices)
+{
+    out.positions.resize(vertices);
+    out.normals.resize(vertices);
+    out.texCoords.resize(vertices);
+    out.indices.resize(indices);
+}
+
+// ---------- Surfaces of revolution ----------
+
+// One profile row, revolved around z: a ring of longitude + 1 vertices (the
+// seam is duplicated so u runs 0..1). Rings with radius 0 are poles and only
+// get the triangles that aren't degenerate.
+struct LatheRow {
+    float radius, z;
+    float normalR, normalZ;
+    float v;
+};
+
+static void lathe(GenMesh& out, const std::vector<LatheRow>& rows, int longitude, const MeshGenOptions& opt)
+{
+    const int L = longitude;
+    const int nRows = (int)rows.size();
+    const size_t ring = (size_t)L + 1;
+
+    // Longitude trig, once for the whole mesh
+    std::vector<float> theta(ring), sinT(ring), cosT(ring);
+    for (int j = 0; j <= L; j++) theta[j] = 2.0f * kPi * j / L;
+    sincosArray(theta.data(), sinT.data(), cosT.data(), ring);
+    sinT[L] = sinT[0] = 0.0f;           // close the seam exactly
+    cosT[L] = cosT[0] = 1.0f;
+
+    // Index offset of every band, so rows can be filled independently
+    std::vector<size_t> bandStart(nRows);
+    size_t indexCount = 0;
+    for (int i = 0; i + 1 < nRows; i++) {
+        bandStart[i] = indexCount;
+        int tris = 2 - (rows[i].radius == 0.0f) - (rows[i + 1].radius == 0.0f);
+        indexCount += (size_t)L * tris * 3;
+    }
+    resizeMesh(out, ring * nRows, indexCount);
+
+    parallelRows(nRows, out.positions.size(), opt, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            const LatheRow& r = rows[i];
+            const size_t base = ring * i;
+            for (int j = 0; j <= L; j++) {
+                out.positions[base + j] = glm::vec4(r.radius * cosT[j], r.radius * sinT[j], r.z, 1.0f);
+                out.normals[base + j] = glm::vec4(r.normalR * cosT[j], r.normalR * sinT[j], r.normalZ, 0.0f);
+                out.texCoords[base + j] = glm::vec2((float)j / L, r.v);
+            }
+            if (i + 1 == nRows) continue;
+
+            // Quads (a, b, c, d) = (i, j), (i+1, j), (i+1, j+1), (i, j+1) as
+            // triangles a,b,c and a,c,d; the first collapses at a pole below,
+            // the second at a pole above.
+            uint32_t* idx = out.indices.data() + bandStart[i];
+            const bool top = r.radius == 0.0f, bottom = rows[i + 1].radius == 0.0f;
+            for (int j = 0; j < L; j++) {
+                uint32_t a = (uint32_t)(base + j), d = a + 1;
+                uint32_t b = (uint32_t)(base + ring + j), c = b + 1;
+                if (!bottom) { *idx++ = a; *idx++ = b; *idx++ = c; }
+                if (!top) { *idx++ = a; *idx++ = c; *idx++ = d; }
+            }
+        }
+    });
+}
+
+void genUVSphere(GenMesh& out, int longitude, int latitude, float radius, const MeshGenOptions& opt)
+{
+    longitude = std::max(longitude, 3);
+    latitude = std::max(latitude, 2);
+
+    std::vector<float> phi(latitude + 1), sinP(latitude + 1), cosP(latitude + 1);
+    for (int i = 0; i <= latitude; i++) phi[i] = kPi * i / latitude;
+    sincosArray(phi.data(), sinP.data(), cosP.data(), phi.size());
+    sinP[0] = sinP[latitude] = 0.0f;
+    cosP[0] = 1.0f;
+    cosP[latitude] = -1.0f;
+
+    std::vector<LatheRow> rows(latitude + 1);
+    for (int i = 0; i <= latitude; i++) {
+        LatheRow& r = rows[i];
+        r.radius = radius * sinP[i];
+        r.z = radius * cosP[i];
+        r.normalR = sinP[i];
+        r.normalZ = cosP[i];
+        r.v = 1.0f - (float)i / latitude;
+    }
+    lathe(out, rows, longitude, opt);
+}
+
+void genCapsule(GenMesh& out, int longitude, int capRings, float radius, float halfLength,
+                const MeshGenOptions& opt)
+{
+    longitude = std::max(longitude, 3);
+    capRings = std::max(capRings, 1);
+    halfLength = std::max(halfLength, 0.0f);
+
+    // Quarter circle 0..pi/2 shared by both caps
+    std::vector<float> phi(capRings + 1), sinP(capRings + 1), cosP(capRings + 1);
+    for (int i = 0; i <= capRings; i++) phi[i] = 0.5f * kPi * i / capRings;
+    sincosArray(phi.data(), sinP.data(), cosP.data(), phi.size());
+    sinP[0] = 0.0f; cosP[0] = 1.0f;
+    sinP[capRings] = 1.0f; cosP[capRings] = 0.0f;
+
+    // v follows arc length down the profile
+    const float capArc = 0.5f * kPi * radius;
+    const float total = 2.0f * capArc + 2.0f * halfLength;
+    std::vector<LatheRow> rows(2 * (capRings + 1));
+    for (int i = 0; i <= capRings; i++) {
+        LatheRow& top = rows[i];
+        top.radius = radius * sinP[i];
+        top.z = halfLength + radius * cosP[i];
+        top.normalR = sinP[i];
+        top.normalZ = cosP[i];
+        top.v = 1.0f - capArc * i / capRings / total;
+
+        LatheRow& bottom = rows[2 * capRings + 1 - i];
+        bottom.radius = top.radius;
+        bottom.z = -top.z;
+        bottom.normalR = sinP[i];
+        bottom.normalZ = -cosP[i];
+        bottom.v = 1.0f - top.v;
+    }
+    lathe(out, rows, longitude, opt);
+}
+
+// ---------- Icosphere ----------
+
+void genIcosphere(GenMesh& out, int subdivisions, float radius)
+{
+    subdivisions = std::max(0, std::min(subdivisions, 9));
+    const size_t faces = (size_t)20 << (2 * subdivisions);
+    const size_t vertices = faces / 2 + 2;
+
+    std::vector<glm::vec3> p;
+    std::vector<uint32_t> tri, next;
+    p.reserve(vertices);
+    tri.reserve(faces * 3);
+    next.reserve(faces * 3);
+
+    const float t = (1.0f + sqrtf(5.0f)) * 0.5f;
+    const float ico[12][3] = {
+        { -1, t, 0 }, { 1, t, 0 }, { -1, -t, 0 }, { 1, -t, 0 },
+        { 0, -1, t }, { 0, 1, t }, { 0, -1, -t }, { 0, 1, -t },
+        { t, 0, -1 }, { t, 0, 1 }, { -t, 0, -1 }, { -t, 0, 1 },
+    };
+    static const uint8_t icoTris[20][3] = {
+        { 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+        { 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+        { 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+        { 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 },
+    };
+    for (int i = 0; i < 12; i++) p.push_back(glm::normalize(glm::vec3(ico[i][0], ico[i][1], ico[i][2])));
+    for (int i = 0; i < 20; i++) tri.insert(tri.end(), icoTris[i], icoTris[i] + 3);
+
+    // Each level splits every triangle in four; shared edges share midpoints
+    std::unordered_map<uint64_t, uint32_t> midpoints;
+    for (int level = 0; level < subdivisions; level++) {
+        midpoints.clear();
+        midpoints.reserve(tri.size() / 2);
+        auto midpoint = [&](uint32_t a, uint32_t b) {
+            uint64_t key = a < b ? ((uint64_t)a << 32 | b) : ((uint64_t)b << 32 | a);
+            auto it = midpoints.find(key);
+            if (it != midpoints.end()) return it->second;
+            uint32_t m = (uint32_t)p.size();
+            p.push_back(glm::normalize(p[a] + p[b]));
+            midpoints.emplace(key, m);
+            return m;
+        };
+        next.clear();
+        for (size_t i = 0; i < tri.size(); i += 3) {
+            uint32_t a = tri[i], b = tri[i + 1], c = tri[i + 2];
+            uint32_t ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            const uint32_t sub[12] = { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca };
+            next.insert(next.end(), sub, sub + 12);
+        }
+        tri.swap(next);
+    }
+
+    // Spherical uv (v = 1 at +z like the UV sphere). Triangles straddling the
+    // u seam get copies of their low-u vertices shifted by one.
+    std::vector<glm::vec2> uv(p.size());
+    for (size_t i = 0; i < p.size(); i++) {
+        float u = 0.5f + atan2f(p[i].y, p[i].x) / (2.0f * kPi);
+        float v = 1.0f - acosf(std::max(-1.0f, std::min(1.0f, p[i].z))) / kPi;
+        uv[i] = glm::vec2(u, v);
+    }
+    std::unordered_map<uint32_t, uint32_t> wrapped;
+    for (size_t i = 0; i < tri.size(); i += 3) {
+        float lo = std::min(uv[tri[i]].x, std::min(uv[tri[i + 1]].x, uv[tri[i + 2]].x));
+        float hi = std::max(uv[tri[i]].x, std::max(uv[tri[i + 1]].x, uv[tri[i + 2]].x));
+        if (hi - lo <= 0.5f) continue;
+        for (int k = 0; k < 3; k++) {
+            uint32_t v = tri[i + k];
+            if (uv[v].x >= 0.5f) continue;
+            auto it = wrapped.find(v);
+            if (it == wrapped.end()) {
+                it = wrapped.emplace(v, (uint32_t)p.size()).first;
+                p.push_back(p[v]);
+                uv.push_back(uv[v] + glm::vec2(1.0f, 0.0f));
+            }
+            tri[i + k] = it->second;
+        }
+    }
+
+    resizeMesh(out, p.size(), 0);
+    for (size_t i = 0; i < p.size(); i++) {
+        out.positions[i] = glm::vec4(p[i] * radius, 1.0f);
+        out.normals[i] = glm::vec4(p[i], 0.0f);
+        out.texCoords[i] = uv[i];
+    }
+    out.indices.swap(tri);
+}
+
+// ---------- Rounded box ----------
+
+// Coordinates along one axis of the unrounded box surface: the flat span
+// plus segments steps over each rounded end, spaced so the projected normals
+// are evenly spread over the 45 degrees that belong to this face.
+static void roundedBoxAxis(float halfExtent, float radius, int segments, std::vector<float>& coords)
+{
+    const float inner = halfExtent - radius;
+    std::vector<float> ends(segments + 1);
+    for (int k = 0; k <= segments; k++)
+        ends[k] = k == segments ? 1.0f : tanf(0.25f * kPi * k / segments);
+    coords.clear();
+    for (int k = segments; k >= 1; k--) coords.push_back(-inner - radius * ends[k]);
+    coords.push_back(-inner);
+    if (inner > 0.0f) coords.push_back(inner);
+    for (int k = 1; k <= segments; k++) coords.push_back(inner + radius * ends[k]);
+}
+
+void genRoundedBox(GenMesh& out, const glm::vec3& halfExtent, float radius, int segments)
+{
+    segments = std::max(segments, 1);
+    radius = std::max(0.0f, std::min(radius, std::min(halfExtent.x, std::min(halfExtent.y, halfExtent.z))));
+    if (radius == 0.0f) segments = 0;   // plain box: just the face corners
+
+    std::vector<float> coords[3];
+    for (int a = 0; a < 3; a++) roundedBoxAxis(halfExtent[a], radius, segments, coords[a]);
+    const glm::vec3 inner = halfExtent - glm::vec3(radius);
+
+    size_t vertices = 0, indices = 0;
+    for (int a = 0; a < 3; a++) {
+        size_t nu = coords[(a + 1) % 3].size(), nv = coords[(a + 2) % 3].size();
+        vertices += 2 * nu * nv;
+        indices += 2 * (nu - 1) * (nv - 1) * 6;
+    }
+    resizeMesh(out, vertices, indices);
+
+    size_t vi = 0, ii = 0;
+    for (int face = 0; face < 6; face++) {
+        // u, v run along the other two axes in cyclic order, so u x v = +axis
+        const int a = face >> 1, ua = (a + 1) % 3, va = (a + 2) % 3;
+        const float sign = (face & 1) ? -1.0f : 1.0f;
+        const std::vector<float>& cu = coords[ua];
+        const std::vector<float>& cv = coords[va];
+        const size_t nu = cu.size(), nv = cv.size();
+        const uint32_t base = (uint32_t)vi;
+
+        for (size_t j = 0; j < nv; j++) {
+            for (size_t i = 0; i < nu; i++) {
+                glm::vec3 p;
+                p[a] = sign * halfExtent[a];
+                p[ua] = cu[i];
+                p[va] = cv[j];
+                glm::vec3 n(0.0f);
+                n[a] = sign;
+                if (radius > 0.0f) {
+                    glm::vec3 core = glm::clamp(p, -inner, inner);
+                    n = glm::normalize(p - core);
+                    p = core + n * radius;
+                }
+                float u = (cu[i] - cu.front()) / (cu.back() - cu.front());
+                float v = (cv[j] - cv.front()) / (cv.back() - cv.front());
+                out.positions[vi] = glm::vec4(p, 1.0f);
+                out.normals[vi] = glm::vec4(n, 0.0f);
+                out.texCoords[vi] = glm::vec2(sign > 0.0f ? u : 1.0f - u, v);
+                vi++;
+            }
+        }
+        for (size_t j = 0; j + 1 < nv; j++) {
+            for (size_t i = 0; i + 1 < nu; i++) {
+                uint32_t q0 = base + (uint32_t)(j * nu + i), q1 = q0 + 1;
+                uint32_t q3 = q0 + (uint32_t)nu, q2 = q3 + 1;
+                if (sign < 0.0f) std::swap(q1, q3);        // mirrored face, flip the winding
+                const uint32_t quad[6] = { q0, q1, q2, q0, q2, q3 };
+                memcpy(&out.indices[ii], quad, sizeof(quad));
+                ii += 6;
+            }
+        }
+    }
+}
+
+// ---------- Grid ----------
+
+void genGrid(GenMesh& out, int cellsX, int cellsZ, const glm::vec2& size, const MeshGenOptions& opt)
+{
+    cellsX = std::max(cellsX, 1);
+    cellsZ = std::max(cellsZ, 1);
+    const size_t nx = (size_t)cellsX + 1;
+    resizeMesh(out, nx * (cellsZ + 1), (size_t)cellsX * cellsZ * 6);
+
+    parallelRows(cellsZ + 1, out.positions.size(), opt, [&](int begin, int end) {
+        for (int j = begin; j < end; j++) {
+            const float v = (float)j / cellsZ;
+            const size_t base = nx * j;
+            for (int i = 0; i <= cellsX; i++) {
+                const float u = (float)i / cellsX;
+                out.positions[base + i] = glm::vec4((u - 0.5f) * size.x, 0.0f, (v - 0.5f) * size.y, 1.0f);
+                out.normals[base + i] = glm::vec4(0.0f, 1.0f, 0.0f, 0.0f);
+                out.texCoords[base + i] = glm::vec2(u, v);
+            }
+            if (j == cellsZ) continue;
+            // Step +z then +x: counter-clockwise seen from +y
+            uint32_t* idx = out.indices.data() + (size_t)j * cellsX * 6;
+            for (int i = 0; i < cellsX; i++) {
+                uint32_t a = (uint32_t)(base + i), b = a + (uint32_t)nx, c = b + 1, d = a + 1;
+                *idx++ = a; *idx++ = b; *idx++ = c;
+                *idx++ = a; *idx++ = c; *idx++ = d;
+            }
+        }
+    });
+}
+
+// ---------- Quantization ----------
+
+static inline int quantizeSnorm(float v, int maxValue)
+{
+    v = std::max(-1.0f, std::min(1.0f, v));
+    return (int)lrintf(v * maxValue);
+}
+
+void quantizeMesh(const GenMesh& mesh, QuantizedMesh& out)
+{
+    const size_t n = mesh.positions.size();
+    glm::vec3 lo(0.0f), hi(0.0f);
+    if (n) lo = hi = glm::vec3(mesh.positions[0]);
+    for (size_t i = 1; i < n; i++) {
+        lo = glm::min(lo, glm::vec3(mesh.positions[i]));
+        hi = glm::max(hi, glm::vec3(mesh.positions[i]));
+    }
+    out.offset = (lo + hi) * 0.5f;
+    out.scale = (hi - lo) * 0.5f;
+    glm::vec3 inv;
+    for (int a = 0; a < 3; a++) inv[a] = out.scale[a] > 0.0f ? 1.0f / out.scale[a] : 0.0f;
+
+    out.positions.resize(n * 4);
+    out.normals.resize(n);
+    out.texCoords.resize(n * 2);
+    for (size_t i = 0; i < n; i++) {
+        glm::vec3 p = (glm::vec3(mesh.positions[i]) - out.offset) * inv;
+        for (int a = 0; a < 3; a++) out.positions[i * 4 + a] = (int16_t)quantizeSnorm(p[a], 32767);
+        out.positions[i * 4 + 3] = 32767;
+
+        const glm::vec4& nm = mesh.normals[i];
+        out.normals[i] = ((uint32_t)quantizeSnorm(nm.x, 511) & 0x3FF) |
+                         (((uint32_t)quantizeSnorm(nm.y, 511) & 0x3FF) << 10) |
+                         (((uint32_t)quantizeSnorm(nm.z, 511) & 0x3FF) << 20);
+
+        for (int a = 0; a < 2; a++) {
+            float t = std::max(0.0f, std::min(1.0f, mesh.texCoords[i][a]));
+            out.texCoords[i * 2 + a] = (uint16_t)lrintf(t * 65535.0f);
+        }
+    }
+
+    out.indices16.clear();
+    out.indices32.clear();
+    if (n <= 0x10000) out.indices16.assign(mesh.indices.begin(), mesh.indices.end());
+    else out.indices32 = mesh.indices;
+}
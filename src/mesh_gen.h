@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "glm/glm.hpp"
+
+// Parametric mesh generators. Every generator writes indexed triangles with
+// non-interleaved streams (the layout MeshData and the scene VAOs use),
+// sizes its vectors exactly up front and evaluates trig once per ring rather
+// than per vertex. Surfaces of revolution (UV sphere, capsule) and grids
+// split their rows over threads once they are large enough to pay for it.
+//
+// Triangles are counter-clockwise seen from outside; texture seams and poles
+// get their own vertices, so every stream can be indexed as-is.
+
+struct GenMesh {
+    std::vector<glm::vec4> positions;   // w = 1
+    std::vector<glm::vec4> normals;     // w = 0, unit length
+    std::vector<glm::vec2> texCoords;
+    std::vector<uint32_t> indices;
+
+    size_t vertexCount() const { return positions.size(); }
+};
+
+struct MeshGenOptions {
+    int threads = 0;                    // <= 0: all cores
+    size_t parallelVertices = 1 << 16;  // stay single-threaded below this
+};
+
+// Sphere around the z axis (poles at +-z), longitude x latitude quads like
+// the old Sphere class; u follows longitude, v = 1 at +z.
+void genUVSphere(GenMesh& out, int longitude, int latitude, float radius = 1.0f,
+                 const MeshGenOptions& opt = MeshGenOptions());
+
+// Subdivided icosahedron, 20 * 4^subdivisions triangles; spherical uv.
+void genIcosphere(GenMesh& out, int subdivisions, float radius = 1.0f);
+
+// Cylinder of the given half length along z, capped by hemispheres with
+// capRings latitude rings each.
+void genCapsule(GenMesh& out, int longitude, int capRings, float radius, float halfLength,
+                const MeshGenOptions& opt = MeshGenOptions());
+
+// Box with edges and corners rounded to radius (clamped to the smallest half
+// extent); segments subdivisions per rounded edge, uv 0..1 per face.
+void genRoundedBox(GenMesh& out, const glm::vec3& halfExtent, float radius, int segments);
+
+// cellsX x cellsZ quads in the y = 0 plane centered at the origin, normal +y,
+// uv 0..1 across the whole grid.
+void genGrid(GenMesh& out, int cellsX, int cellsZ, const glm::vec2& size,
+             const MeshGenOptions& opt = MeshGenOptions());
+
+// sin/cos of n angles (radians, any range); SSE2 when available. Absolute
+// error stays below 1e-6 for |angle| < 1e4.
+void sincosArray(const float* angle, float* s, float* c, size_t n);
+
+// ---------- Quantized streams ----------
+
+// Compact vertex format for upload:
+//   position  4 x GL_SHORT, normalized;   p = q / 32767 * scale + offset
+//   normal    GL_INT_2_10_10_10_REV, normalized
+//   texcoord  2 x GL_UNSIGNED_SHORT, normalized (uv clamped to 0..1)
+//   indices   GL_UNSIGNED_SHORT when every index fits, GL_UNSIGNED_INT otherwise
+struct QuantizedMesh {
+    std::vector<int16_t> positions;     // xyz + pad per vertex
+    std::vector<uint32_t> normals;
+    std::vector<uint16_t> texCoords;
+    std::vector<uint16_t> indices16;
+    std::vector<uint32_t> indices32;    // used when indices16 is empty
+    glm::vec3 offset, scale;            // the dequantization transform for positions
+};
+
+void quantizeMesh(const GenMesh& mesh, QuantizedMesh& out);
@@ -0,0 +1,358 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "mipmap.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <string>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define MIP_SSE2 1
+#  include <emmintrin.h>
+#else
+#  define MIP_SSE2 0
+#endif
+
+// ---------- sRGB <-> linear ----------
+static const int kEncodeBits = 12;          // linear -> sRGB table resolution
+static float g_toLinear[256];
+static unsigned char g_toSRGB[1 << kEncodeBits];
+
+static bool buildTables()
+{
+    for (int i = 0; i < 256; i++) {
+        float c = i / 255.0f;
+        g_toLinear[i] = (c <= 0.04045f) ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+    }
+    const int n = 1 << kEncodeBits;
+    for (int i = 0; i < n; i++) {
+        float l = (i + 0.5f) / n;
+        float c = (l <= 0.0031308f) ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+        int v = (int)(c * 255.0f + 0.5f);
+        g_toSRGB[i] = (unsigned char)(v < 0 ? 0 : (v > 255 ? 255 : v));
+    }
+    return true;
+}
+
+static void initTables()
+{
+    static const bool ready = buildTables();   // thread-safe one-time init
+    (void)ready;
+}
+
+static inline unsigned char encodeSRGB(float l)
+{
+    int i = (int)(l * (1 << kEncodeBits));
+    if (i < 0) i = 0;
+    if (i > (1 << kEncodeBits) - 1) i = (1 << kEncodeBits) - 1;
+    return g_toSRGB[i];
+}
+
+// ---------- Row-parallel helper ----------
+template <typename Fn>
+static void parallelRows(int rows, int threads, Fn fn)
+{
+    // Small levels are not worth a thread launch
+    if (threads <= 1 || rows < 64) { fn(0, rows); return; }
+    if (threads > rows / 16) threads = rows / 16;
+
+    std::vector<std::thread> pool;
+    int chunk = (rows + threads - 1) / threads;
+    for (int t = 1; t < threads; t++) {
+        int y0 = t * chunk, y1 = (t + 1) * chunk < rows ? (t + 1) * chunk : rows;
+        if (y0 < y1) pool.emplace_back(fn, y0, y1);
+    }
+    fn(0, chunk < rows ? chunk : rows);
+    for (size_t i = 0; i < pool.size(); i++) pool[i].join();
+}
+
+// Linear float RGBA image (alpha is stored linear as-is)
+struct LinearImage {
+    int width, height;
+    std::vector<float> px;
+    float* row(int y) { return &px[(size_t)y * width * 4]; }
+    const float* row(int y) const { return &px[(size_t)y * width * 4]; }
+};
+
+static void encodeRows(const LinearImage& img, unsigned char* dst, int y0, int y1)
+{
+    for (int y = y0; y < y1; y++) {
+        const float* s = img.row(y);
+        unsigned char* d = dst + (size_t)y * img.width * 4;
+        for (int x = 0; x < img.width; x++, s += 4, d += 4) {
+            d[0] = encodeSRGB(s[0]);
+            d[1] = encodeSRGB(s[1]);
+            d[2] = encodeSRGB(s[2]);
+            float a = s[3] * 255.0f + 0.5f;
+            d[3] = (unsigned char)(a < 0.0f ? 0 : (a > 255.0f ? 255 : (int)a));
+        }
+    }
+}
+
+// ---------- Box filter ----------
+static void boxRows(const LinearImage& src, LinearImage& dst, int y0, int y1)
+{
+    for (int y = y0; y < y1; y++) {
+        int sy0 = y * 2;
+        int sy1 = (sy0 + 1 < src.height) ? sy0 + 1 : sy0;
+        const float* r0 = src.row(sy0);
+        const float* r1 = src.row(sy1);
+        float* d = dst.row(y);
+        for (int x = 0; x < dst.width; x++, d += 4) {
+            int sx0 = x * 2 * 4;
+            int sx1 = (x * 2 + 1 < src.width) ? sx0 + 4 : sx0;
+#if MIP_SSE2
+            __m128 s = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(r0 + sx0), _mm_loadu_ps(r0 + sx1)),
+                                  _mm_add_ps(_mm_loadu_ps(r1 + sx0), _mm_loadu_ps(r1 + sx1)));
+            _mm_storeu_ps(d, _mm_mul_ps(s, _mm_set1_ps(0.25f)));
+#else
+            for (int c = 0; c < 4; c++)
+                d[c] = (r0[sx0 + c] + r0[sx1 + c] + r1[sx0 + c] + r1[sx1 + c]) * 0.25f;
+#endif
+        }
+    }
+}
+
+// ---------- Kaiser filter ----------
+// 2x decimation: destination texel i sits between source texels 2i and 2i+1,
+// so the taps are at offsets -3.5 .. +3.5.
+static const int kTaps = 8;
+static float g_kaiser[kTaps];
+
+static double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+static bool buildKaiser()
+{
+    const double alpha = 4.0, halfWidth = kTaps * 0.5;
+    double total = 0.0;
+    for (int i = 0; i < kTaps; i++) {
+        double x = i - (kTaps - 1) * 0.5;            // -3.5 .. 3.5 source texels
+        double t = x * 0.5;                          // in destination texels
+        double sinc = (t == 0.0) ? 1.0 : sin(3.14159265358979 * t) / (3.14159265358979 * t);
+        double r = x / halfWidth;
+        double win = besselI0(alpha * sqrt(fmax(0.0, 1.0 - r * r))) / besselI0(alpha);
+        g_kaiser[i] = (float)(sinc * win);
+        total += g_kaiser[i];
+    }
+    for (int i = 0; i < kTaps; i++) g_kaiser[i] = (float)(g_kaiser[i] / total);
+    return true;
+}
+
+static void initKaiser()
+{
+    static const bool ready = buildKaiser();
+    (void)ready;
+}
+
+static inline int clampi(int v, int lo, int hi) { return v < lo ? lo : (v > hi ? hi : v); }
+
+// Horizontal pass: src (w x h) -> tmp (dw x h)
+static void kaiserRowsH(const LinearImage& src, LinearImage& tmp, int y0, int y1)
+{
+    for (int y = y0; y < y1; y++) {
+        const float* s = src.row(y);
+        float* d = tmp.row(y);
+        for (int x = 0; x < tmp.width; x++, d += 4) {
+            int base = x * 2 - (kTaps / 2 - 1);
+#if MIP_SSE2
+            __m128 acc = _mm_setzero_ps();
+            for (int k = 0; k < kTaps; k++) {
+                int sx = clampi(base + k, 0, src.width - 1);
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(s + sx * 4), _mm_set1_ps(g_kaiser[k])));
+            }
+            _mm_storeu_ps(d, acc);
+#else
+            float acc[4] = { 0, 0, 0, 0 };
+            for (int k = 0; k < kTaps; k++) {
+                int sx = clampi(base + k, 0, src.width - 1);
+                for (int c = 0; c < 4; c++) acc[c] += s[sx * 4 + c] * g_kaiser[k];
+            }
+            memcpy(d, acc, sizeof(acc));
+#endif
+        }
+    }
+}
+
+// Vertical pass: tmp (dw x h) -> dst (dw x dh), clamped to [0,1] for the negative lobes
+static void kaiserRowsV(const LinearImage& tmp, LinearImage& dst, int y0, int y1)
+{
+    for (int y = y0; y < y1; y++) {
+        const float* rows[kTaps];
+        int base = y * 2 - (kTaps / 2 - 1);
+        for (int k = 0; k < kTaps; k++) rows[k] = tmp.row(clampi(base + k, 0, tmp.height - 1));
+        float* d = dst.row(y);
+        for (int x = 0; x < dst.width * 4; x += 4) {
+#if MIP_SSE2
+            __m128 acc = _mm_setzero_ps();
+            for (int k = 0; k < kTaps; k++)
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(rows[k] + x), _mm_set1_ps(g_kaiser[k])));
+            acc = _mm_min_ps(_mm_max_ps(acc, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+            _mm_storeu_ps(d + x, acc);
+#else
+            for (int c = 0; c < 4; c++) {
+                float acc = 0.0f;
+                for (int k = 0; k < kTaps; k++) acc += rows[k][x + c] * g_kaiser[k];
+                d[x + c] = acc < 0.0f ? 0.0f : (acc > 1.0f ? 1.0f : acc);
+            }
+#endif
+        }
+    }
+}
+
+// ---------- Chain ----------
+void buildMipChain(const unsigned char* rgba, int width, int height,
+                   MipFilter filter, MipChain& out, int threads)
+{
+    initTables();
+    initKaiser();
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    if (threads <= 0) threads = 1;
+
+    out.filter = filter;
+    out.levels.clear();
+    size_t total = 0;
+    for (int w = width, h = height; ; w = w > 1 ? w / 2 : 1, h = h > 1 ? h / 2 : 1) {
+        MipLevel L = { w, h, total };
+        out.levels.push_back(L);
+        total += (size_t)w * h * 4;
+        if (w == 1 && h == 1) break;
+    }
+    out.data.resize(total);
+    memcpy(&out.data[0], rgba, (size_t)width * height * 4);
+
+    LinearImage cur;
+    cur.width = width;
+    cur.height = height;
+    cur.px.resize((size_t)width * height * 4);
+    parallelRows(height, threads, [&](int y0, int y1) {
+        for (size_t i = (size_t)y0 * width * 4; i < (size_t)y1 * width * 4; i += 4) {
+            cur.px[i + 0] = g_toLinear[rgba[i + 0]];
+            cur.px[i + 1] = g_toLinear[rgba[i + 1]];
+            cur.px[i + 2] = g_toLinear[rgba[i + 2]];
+            cur.px[i + 3] = rgba[i + 3] * (1.0f / 255.0f);
+        }
+    });
+
+    // Each level is filtered from the previous one in float, so rounding
+    // error does not accumulate down the chain.
+    LinearImage next, tmp;
+    for (size_t l = 1; l < out.levels.size(); l++) {
+        const MipLevel& L = out.levels[l];
+        next.width = L.width;
+        next.height = L.height;
+        next.px.resize((size_t)L.width * L.height * 4);
+
+        if (filter == MIP_FILTER_KAISER) {
+            tmp.width = L.width;
+            tmp.height = cur.height;
+            tmp.px.resize((size_t)tmp.width * tmp.height * 4);
+            parallelRows(tmp.height, threads, [&](int y0, int y1) { kaiserRowsH(cur, tmp, y0, y1); });
+            parallelRows(next.height, threads, [&](int y0, int y1) { kaiserRowsV(tmp, next, y0, y1); });
+        }
+        else {
+            parallelRows(next.height, threads, [&](int y0, int y1) { boxRows(cur, next, y0, y1); });
+        }
+
+        unsigned char* dst = &out.data[L.offset];
+        parallelRows(next.height, threads, [&](int y0, int y1) { encodeRows(next, dst, y0, y1); });
+        cur.width = next.width;
+        cur.height = next.height;
+        cur.px.swap(next.px);
+    }
+}
+
+// ---------- Cache ----------
+struct MipCacheHeader {
+    char magic[4];              // "MIPC"
+    uint32_t version;
+    uint64_t sourceSize;
+    uint64_t sourceTime;
+    uint32_t filter;
+    uint32_t levelCount;
+    uint32_t width;
+    uint32_t height;
+};
+
+static const uint32_t kMipCacheVersion = 1;
+
+static bool sourceStamp(const char* assetPath, uint64_t& size, uint64_t& time)
+{
+    struct stat st;
+    if (stat(assetPath, &st) != 0) return false;
+    size = (uint64_t)st.st_size;
+    time = (uint64_t)st.st_mtime;
+    return true;
+}
+
+bool loadMipCache(const char* assetPath, MipFilter filter, MipChain& out)
+{
+    uint64_t size, time;
+    if (!sourceStamp(assetPath, size, time)) return false;
+
+    std::string path = std::string(assetPath) + ".mips";
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    MipCacheHeader h;
+    bool ok = fread(&h, sizeof(h), 1, file) == 1
+        && memcmp(h.magic, "MIPC", 4) == 0
+        && h.version == kMipCacheVersion
+        && h.sourceSize == size && h.sourceTime == time
+        && h.filter == (uint32_t)filter
+        && h.levelCount > 0 && h.levelCount <= 32
+        && h.width > 0 && h.height > 0 && h.width <= 65536 && h.height <= 65536;
+    if (ok) {
+        out.filter = filter;
+        out.levels.clear();
+        size_t total = 0;
+        int w = (int)h.width, hh = (int)h.height;
+        for (uint32_t i = 0; i < h.levelCount; i++) {
+            MipLevel L = { w, hh, total };
+            out.levels.push_back(L);
+            total += (size_t)w * hh * 4;
+            w = w > 1 ? w / 2 : 1;
+            hh = hh > 1 ? hh / 2 : 1;
+        }
+        out.data.resize(total);
+        ok = fread(&out.data[0], 1, total, file) == total;
+    }
+    fclose(file);
+    return ok;
+}
+
+bool saveMipCache(const char* assetPath, const MipChain& chain)
+{
+    uint64_t size, time;
+    if (chain.levels.empty() || !sourceStamp(assetPath, size, time)) return false;
+
+    std::string path = std::string(assetPath) + ".mips";
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    MipCacheHeader h;
+    memcpy(h.magic, "MIPC", 4);
+    h.version = kMipCacheVersion;
+    h.sourceSize = size;
+    h.sourceTime = time;
+    h.filter = (uint32_t)chain.filter;
+    h.levelCount = (uint32_t)chain.levels.size();
+    h.width = (uint32_t)chain.levels[0].width;
+    h.height = (uint32_t)chain.levels[0].height;
+
+    bool ok = fwrite(&h, sizeof(h), 1, file) == 1
+        && fwrite(&chain.data[0], 1, chain.data.size(), file) == chain.data.size();
+    fclose(file);
+    if (!ok) remove(path.c_str());
+    return ok;
+}
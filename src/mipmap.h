@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include <stddef.h>
+
+// CPU mip-chain generation for RGBA8 images.
+//
+// Filtering is done in linear light: texels are expanded through an sRGB
+// lookup table, filtered as float4 (SSE2 where available), and re-encoded.
+// Rows of each level are split across worker threads.
+
+enum MipFilter {
+    MIP_FILTER_BOX = 0,     // 2x2 average
+    MIP_FILTER_KAISER = 1   // separable 8-tap Kaiser-windowed sinc, sharper minification
+};
+
+struct MipLevel {
+    int width;
+    int height;
+    size_t offset;          // byte offset of the level in MipChain::data
+};
+
+struct MipChain {
+    MipFilter filter = MIP_FILTER_BOX;
+    std::vector<MipLevel> levels;
+    std::vector<unsigned char> data;    // tightly packed RGBA8, level 0 first
+
+    const unsigned char* level(int i) const { return &data[levels[i].offset]; }
+    size_t levelSize(int i) const { return (size_t)levels[i].width * levels[i].height * 4; }
+};
+
+// Build the full chain down to 1x1 from an RGBA8 image (rows tightly packed).
+// threads <= 0 uses all hardware threads.
+void buildMipChain(const unsigned char* rgba, int width, int height,
+                   MipFilter filter, MipChain& out, int threads = 0);
+
+// Mip caches live next to the asset as "<asset>.mips" and are keyed on the
+// source file's size and modification time.
+bool loadMipCache(const char* assetPath, MipFilter filter, MipChain& out);
+bool saveMipCache(const char* assetPath, const MipChain& chain);
@@ -0,0 +1,266 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "cube.h"
+#include "profiler.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+    struct Event {
+        const char* name;
+        int64_t start, end;     // profilerNow()
+        int depth;
+    };
+
+    // One per thread, plus the GPU's. Never freed: a thread's events outlive it.
+    struct Track {
+        std::mutex lock;        // the owner writes, exports read
+        std::vector<Event> ring;
+        uint64_t written = 0;
+        int depth = 0;          // open zones, owner only
+        int id = 0;
+        std::string name;
+    };
+
+    const size_t RING_EVENTS = 1 << 15;
+    enum { GPU_FRAMES = 4, GPU_ZONES = 64 };
+
+    struct GpuFrame {
+        const char* name[GPU_ZONES];
+        int depth[GPU_ZONES];
+        int count = 0;
+    };
+
+    // GL thread only
+    struct GpuTimer {
+        bool on = false;
+        GLuint queries[GPU_FRAMES][GPU_ZONES * 2];     // begin, end per zone
+        GpuFrame frames[GPU_FRAMES];
+        unsigned frame = 0;
+        int depth = 0;
+        int dropped = 0;
+        int64_t calibCpu = 0, calibGpu = 0, calibAt = 0;
+        Track* track = nullptr;
+    };
+}
+
+static const std::chrono::steady_clock::time_point g_epoch = std::chrono::steady_clock::now();
+static std::mutex g_tracksLock;
+static std::vector<Track*> g_tracks;
+static thread_local Track* t_track = nullptr;
+static GpuTimer g_gpu;
+
+int64_t profilerNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+static Track* newTrack(const char* name)
+{
+    Track* t = new Track;
+    t->ring.resize(RING_EVENTS);
+    std::lock_guard<std::mutex> guard(g_tracksLock);
+    t->id = (int)g_tracks.size() + 1;
+    if (name) t->name = name;
+    else {
+        char buf[32];
+        sprintf(buf, "thread %d", t->id);
+        t->name = buf;
+    }
+    g_tracks.push_back(t);
+    return t;
+}
+
+static Track* threadTrack()
+{
+    if (!t_track) t_track = newTrack(NULL);
+    return t_track;
+}
+
+static void record(Track* t, const char* name, int64_t start, int64_t end, int depth)
+{
+    std::lock_guard<std::mutex> guard(t->lock);
+    Event& e = t->ring[t->written++ % RING_EVENTS];
+    e.name = name;
+    e.start = start;
+    e.end = end;
+    e.depth = depth;
+}
+
+void profilerNameThread(const char* name)
+{
+    if (!t_track) t_track = newTrack(name);
+}
+
+ProfileZone::ProfileZone(const char* name) : name(name)
+{
+    depth = threadTrack()->depth++;
+    start = profilerNow();
+}
+
+ProfileZone::~ProfileZone()
+{
+    const int64_t end = profilerNow();
+    t_track->depth--;
+    record(t_track, name, start, end, depth);
+}
+
+// ---------- GPU ----------
+
+void profilerInitGL()
+{
+    if (g_gpu.on || !(GLEW_VERSION_3_3 || GLEW_ARB_timer_query)) return;
+    glGenQueries(GPU_FRAMES * GPU_ZONES * 2, &g_gpu.queries[0][0]);
+    g_gpu.track = newTrack("GPU");
+    g_gpu.on = true;
+}
+
+GpuProfileZone::GpuProfileZone(const char* name) : cpu(name), query(-1)
+{
+    if (!g_gpu.on) return;
+    const unsigned slot = g_gpu.frame % GPU_FRAMES;
+    GpuFrame& f = g_gpu.frames[slot];
+    if (f.count == GPU_ZONES) return;
+    query = f.count++;
+    f.name[query] = name;
+    f.depth[query] = g_gpu.depth++;
+    glQueryCounter(g_gpu.queries[slot][query * 2], GL_TIMESTAMP);
+}
+
+GpuProfileZone::~GpuProfileZone()
+{
+    if (query < 0) return;
+    glQueryCounter(g_gpu.queries[g_gpu.frame % GPU_FRAMES][query * 2 + 1], GL_TIMESTAMP);
+    g_gpu.depth--;
+}
+
+// GPU clock -> profilerNow(), refreshed once a second against drift
+static void calibrate()
+{
+    const int64_t now = profilerNow();
+    if (g_gpu.calibAt && now - g_gpu.calibAt < 1000000000) return;
+    GLint64 gpu = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpu);
+    g_gpu.calibCpu = profilerNow();
+    g_gpu.calibGpu = gpu;
+    g_gpu.calibAt = now;
+}
+
+// Timestamps complete in order: the last one available means all are
+static void resolve(unsigned slot)
+{
+    GpuFrame& f = g_gpu.frames[slot];
+    if (f.count == 0) return;
+    GLint available = 0;
+    glGetQueryObjectiv(g_gpu.queries[slot][f.count * 2 - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) g_gpu.dropped += f.count;
+    for (int i = 0; available && i < f.count; i++) {
+        GLuint64 t0 = 0, t1 = 0;
+        glGetQueryObjectui64v(g_gpu.queries[slot][i * 2], GL_QUERY_RESULT, &t0);
+        glGetQueryObjectui64v(g_gpu.queries[slot][i * 2 + 1], GL_QUERY_RESULT, &t1);
+        record(g_gpu.track, f.name[i], g_gpu.calibCpu + ((int64_t)t0 - g_gpu.calibGpu),
+            g_gpu.calibCpu + ((int64_t)t1 - g_gpu.calibGpu), f.depth[i]);
+    }
+    f.count = 0;
+}
+
+void profilerEndFrame()
+{
+    if (!g_gpu.on) return;
+    calibrate();
+    g_gpu.frame++;
+    // The slot the next frame reuses holds the oldest frame in flight
+    resolve(g_gpu.frame % GPU_FRAMES);
+}
+
+// ---------- Export ----------
+
+static void collect(Track* t, int64_t from, std::vector<Event>& out)
+{
+    std::lock_guard<std::mutex> guard(t->lock);
+    const uint64_t n = t->written < RING_EVENTS ? t->written : RING_EVENTS;
+    for (uint64_t i = t->written - n; i < t->written; i++) {
+        const Event& e = t->ring[i % RING_EVENTS];
+        if (e.end >= from) out.push_back(e);
+    }
+}
+
+static std::vector<Track*> tracks()
+{
+    std::lock_guard<std::mutex> guard(g_tracksLock);
+    return g_tracks;
+}
+
+bool profilerWriteTrace(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        printf("profiler: cannot write %s\n", path);
+        return false;
+    }
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    const std::vector<Track*> all = tracks();
+    size_t count = 0;
+    std::vector<Event> events;
+    for (size_t i = 0; i < all.size(); i++) {
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            i ? ",\n" : "", all[i]->id, all[i]->name.c_str());
+        fprintf(file, ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"sort_index\":%d}}",
+            all[i]->id, all[i]->id);
+        events.clear();
+        collect(all[i], 0, events);
+        for (size_t e = 0; e < events.size(); e++)
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                events[e].name, all[i]->id, events[e].start * 1e-3, (events[e].end - events[e].start) * 1e-3);
+        count += events.size();
+    }
+    fprintf(file, "\n]}\n");
+    const bool ok = fclose(file) == 0;
+    printf("profiler: %zu events from %zu tracks written to %s%s\n", count, all.size(), path,
+        count ? "" : " (no zones: build with PROFILER defined)");
+    return ok;
+}
+
+void profilerPrintSummary()
+{
+    struct Row {
+        const char* name;
+        int depth, calls;
+        double totalMs, maxMs;
+    };
+    const int64_t now = profilerNow(), from = now - 1000000000;
+    const std::vector<Track*> all = tracks();
+    printf("profile, last second:\n  %-10s %-30s %6s %9s %9s %6s\n", "track", "zone", "calls", "avg ms", "max ms", "busy");
+    size_t zones = 0;
+    std::vector<Event> events;
+    for (size_t i = 0; i < all.size(); i++) {
+        events.clear();
+        collect(all[i], from, events);
+        std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return a.start < b.start; });
+        // One row per zone name and depth, in order of first appearance
+        std::vector<Row> rows;
+        for (size_t e = 0; e < events.size(); e++) {
+            const double ms = (events[e].end - events[e].start) * 1e-6;
+            size_t r = 0;
+            while (r < rows.size() && !(rows[r].depth == events[e].depth && !strcmp(rows[r].name, events[e].name))) r++;
+            if (r == rows.size()) rows.push_back(Row{ events[e].name, events[e].depth, 0, 0.0, 0.0 });
+            rows[r].calls++;
+            rows[r].totalMs += ms;
+            rows[r].maxMs = std::max(rows[r].maxMs, ms);
+        }
+        for (size_t r = 0; r < rows.size(); r++) {
+            char label[64];
+            snprintf(label, sizeof(label), "%*s%s", rows[r].depth * 2, "", rows[r].name);
+            printf("  %-10s %-30s %6d %9.3f %9.3f %5.1f%%\n", r ? "" : all[i]->name.c_str(), label,
+                rows[r].calls, rows[r].totalMs / rows[r].calls, rows[r].maxMs, rows[r].totalMs / 10.0);
+        }
+        zones += rows.size();
+    }
+    if (!zones) printf("  nothing recorded (build with PROFILER defined)\n");
+    if (g_gpu.dropped) printf("  %d GPU zones dropped (results not ready in time)\n", g_gpu.dropped);
+}
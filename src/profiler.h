@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+
+// Scoped CPU and GPU profiling zones.
+//
+//   PROFILE_ZONE("shadows");          // CPU time of the enclosing scope
+//   PROFILE_GPU_ZONE("main pass");    // the same, plus the GPU time of the
+//                                     // commands it issues (GL thread)
+//
+// Zones nest; each thread records into its own ring of the most recent
+// events, allocated on its first zone and then reused, so recording never
+// touches the heap. Name a thread's track with PROFILE_THREAD("name"); the
+// first name given sticks, other threads show up as "thread N".
+//
+// GPU zones put a timestamp query at each end. The queries of a frame are
+// read back GPU_FRAMES - 1 frames later (profilerEndFrame) if the GPU is done
+// with them; a frame still in flight by then is dropped rather than waited
+// for. Timestamps are mapped to the CPU clock, so GPU zones line up with the
+// CPU ones on a "GPU" track.
+//
+// profilerWriteTrace writes everything still in the rings as Chrome
+// trace-event JSON (chrome://tracing, ui.perfetto.dev); profilerPrintSummary
+// prints per-zone totals over the last second.
+//
+// The macros compile to nothing unless PROFILER is defined; the functions
+// stay, and report that nothing was recorded.
+
+#ifdef PROFILER
+#  define PROFILE_CONCAT_(a, b) a##b
+#  define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#  define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#  define PROFILE_GPU_ZONE(name) GpuProfileZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#  define PROFILE_THREAD(name) profilerNameThread(name)
+#else
+#  define PROFILE_ZONE(name) ((void)0)
+#  define PROFILE_GPU_ZONE(name) ((void)0)
+#  define PROFILE_THREAD(name) ((void)0)
+#endif
+
+// GL thread, once the context exists; GPU zones do nothing before (or
+// without timer queries)
+void profilerInitGL();
+// GL thread, after the frame's last GPU zone (after the swap)
+void profilerEndFrame();
+
+void profilerNameThread(const char* name);
+bool profilerWriteTrace(const char* path);
+void profilerPrintSummary();
+
+// Nanoseconds on the profiler's clock
+int64_t profilerNow();
+
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name);
+    ~ProfileZone();
+
+private:
+    const char* name;
+    int64_t start;
+    int depth;
+};
+
+class GpuProfileZone {
+public:
+    explicit GpuProfileZone(const char* name);
+    ~GpuProfileZone();
+
+private:
+    ProfileZone cpu;
+    int query;              // -1: not timed
+};
@@ -0,0 +1,237 @@
+#include "cube.h"
+#include "shadow.h"
+#include "profiler.h"
+#include "gl_stats.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include <chrono>
+
+enum { KIND_STATIC, KIND_FAR, KIND_NEAR };
+
+bool ShadowMap::init(const ShadowSettings& s, GLuint positionAttrib)
+{
+    settings = s;
+    if (settings.resolution < 16) settings.resolution = 16;
+    if (settings.farUpdateInterval < 1) settings.farUpdateInterval = 1;
+
+    const GLuint prevProgram = glStateProgram(), prevTex = glStateTexture(GL_TEXTURE_2D);
+    const GLuint prevFbo = glStateDrawFramebuffer();
+
+    // Depth-only program; vPosition must use the same slot as the scene VAOs.
+    program = InitShader("src/shadow_vshader.glsl", "src/shadow_fshader.glsl");
+    glBindAttribLocation(program, positionAttrib, "vPosition");
+    glLinkProgram(program);
+    lightVPLoc = glGetUniformLocation(program, "mLightViewProj");
+    modelLoc = glGetUniformLocation(program, "mModel");
+
+    const float border[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    bool ok = true;
+    for (int i = 0; i < LAYER_COUNT; i++)
+    {
+        Layer& L = layers[i];
+        glGenTextures(1, &L.tex);
+        glsBindTexture(GL_TEXTURE_2D, L.tex);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24,
+            settings.resolution, settings.resolution, 0,
+            GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+        if (i == LAYER_FINAL) {
+            // Sampled as sampler2DShadow: hardware 2x2 PCF on top of the shader taps
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        }
+        else {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
+
+        glGenFramebuffers(1, &L.fbo);
+        glsBindFramebuffer(GL_FRAMEBUFFER, L.fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, L.tex, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Shadow map layer " << i << " is incomplete" << std::endl;
+            ok = false;
+        }
+    }
+
+    hasTimer = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    if (hasTimer) glGenQueries(QUERY_COUNT, queries);
+
+    glsBindFramebuffer(GL_FRAMEBUFFER, prevFbo);
+    glsBindTexture(GL_TEXTURE_2D, prevTex);
+    glsUseProgram(prevProgram);
+
+    staticDirty = farDirty = true;
+    frameIndex = lastFarFrame = queryFrame = 0;
+    if (!ok) shutdown();
+    return ok;
+}
+
+void ShadowMap::shutdown()
+{
+    for (int i = 0; i < LAYER_COUNT; i++) {
+        if (layers[i].fbo) glsDeleteFramebuffers(1, &layers[i].fbo);
+        if (layers[i].tex) glsDeleteTextures(1, &layers[i].tex);
+        layers[i] = Layer();
+    }
+    if (hasTimer) glDeleteQueries(QUERY_COUNT, queries);
+    hasTimer = false;
+    if (program) glDeleteProgram(program);
+    program = 0;
+}
+
+int ShadowMap::addCaster(bool isStatic, int userId, float radius)
+{
+    Caster c;
+    c.userId = userId;
+    c.radius = radius;
+    c.center = glm::vec3(0.0f);
+    c.isStatic = isStatic;
+    c.dirty = true;
+    c.far = false;
+    casters.push_back(c);
+    return (int)casters.size() - 1;
+}
+
+void ShadowMap::setCasterCenter(int caster, const glm::vec3& center)
+{
+    Caster& c = casters[caster];
+    if (c.center != center) {
+        c.center = center;
+        c.dirty = true;
+    }
+}
+
+void ShadowMap::markDirty(int caster)
+{
+    casters[caster].dirty = true;
+}
+
+void ShadowMap::setLight(const glm::vec3& pos, const glm::vec3& target,
+                         float halfExtent, float nearZ, float farZ)
+{
+    glm::vec3 dir = glm::normalize(target - pos);
+    glm::vec3 up = (fabs(dir.y) > 0.99f) ? glm::vec3(0, 0, 1) : glm::vec3(0, 1, 0);
+    glm::mat4 vp = glm::ortho(-halfExtent, halfExtent, -halfExtent, halfExtent, nearZ, farZ)
+        * glm::lookAt(pos, target, up);
+    if (vp != lightVP) {
+        lightVP = vp;
+        staticDirty = true;     // every cached layer is in the old light space
+    }
+}
+
+void ShadowMap::beginLayer(int layer, int copyFrom)
+{
+    const int res = settings.resolution;
+    if (copyFrom < 0) {
+        glsBindFramebuffer(GL_FRAMEBUFFER, layers[layer].fbo);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        return;
+    }
+    glsBindFramebuffer(GL_READ_FRAMEBUFFER, layers[copyFrom].fbo);
+    glsBindFramebuffer(GL_DRAW_FRAMEBUFFER, layers[layer].fbo);
+    glBlitFramebuffer(0, 0, res, res, 0, 0, res, res, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glsBindFramebuffer(GL_FRAMEBUFFER, layers[layer].fbo);
+}
+
+void ShadowMap::drawCasters(ShadowDrawFn draw, int kind)
+{
+    for (size_t i = 0; i < casters.size(); i++)
+    {
+        Caster& c = casters[i];
+        int k = c.isStatic ? KIND_STATIC : (c.far ? KIND_FAR : KIND_NEAR);
+        if (k != kind) continue;
+        draw(c.userId, modelLoc);
+        c.dirty = false;
+    }
+}
+
+void ShadowMap::update(const glm::vec3& eyePos, ShadowDrawFn draw)
+{
+    PROFILE_GPU_ZONE("ShadowMap::update");
+    if (!program) return;
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    // Per-object dirty tracking: a dirty static caster invalidates the static
+    // layer; a dynamic caster crossing farDistance invalidates the far layer.
+    for (size_t i = 0; i < casters.size(); i++)
+    {
+        Caster& c = casters[i];
+        if (c.isStatic) {
+            if (c.dirty) staticDirty = true;
+            continue;
+        }
+        bool far = glm::length(c.center - eyePos) - c.radius > settings.farDistance;
+        if (far != c.far) {
+            c.far = far;
+            farDirty = true;
+        }
+    }
+    frameIndex++;
+
+    if (hasTimer) glBeginQuery(GL_TIME_ELAPSED, queries[queryFrame % QUERY_COUNT]);
+
+    const GLuint prevProgram = glStateProgram();
+    GLint prevViewport[4];
+    glStateViewport(prevViewport);
+
+    glsUseProgram(program);
+    glsUniformMatrix4fv(lightVPLoc, 1, GL_FALSE, &lightVP[0][0]);
+    glsViewport(0, 0, settings.resolution, settings.resolution);
+    glsEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+
+    if (staticDirty) {
+        beginLayer(LAYER_STATIC, -1);
+        drawCasters(draw, KIND_STATIC);
+        staticDirty = false;
+        farDirty = true;
+        stat.staticRedraws++;
+    }
+    if (farDirty || frameIndex - lastFarFrame >= settings.farUpdateInterval) {
+        beginLayer(LAYER_FAR, LAYER_STATIC);
+        drawCasters(draw, KIND_FAR);
+        lastFarFrame = frameIndex;
+        farDirty = false;
+        stat.farRedraws++;
+    }
+    beginLayer(LAYER_FINAL, LAYER_FAR);
+    drawCasters(draw, KIND_NEAR);
+
+    glsDisable(GL_POLYGON_OFFSET_FILL);
+    glsBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glsViewport(prevViewport[0], prevViewport[1], prevViewport[2], prevViewport[3]);
+    glsUseProgram(prevProgram);
+
+    if (hasTimer) {
+        glEndQuery(GL_TIME_ELAPSED);
+        // Read the oldest query in the ring so the CPU never waits on the GPU
+        queryFrame++;
+        if (queryFrame >= QUERY_COUNT) {
+            GLuint q = queries[queryFrame % QUERY_COUNT];
+            GLint available = 0;
+            glGetQueryObjectiv(q, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint64 ns = 0;
+                glGetQueryObjectui64v(q, GL_QUERY_RESULT, &ns);
+                stat.gpuMs = ns * 1.0e-6;
+            }
+        }
+    }
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    stat.cpuMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    stat.frames++;
+}
+
+void ShadowMap::resetStats()
+{
+    stat.staticRedraws = 0;
+    stat.farRedraws = 0;
+    stat.frames = 0;
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <vector>
+#include "GL/glew.h"
+#include "glm/glm.hpp"
+
+// Cached shadow map for a single directional (overhead) light.
+//
+// The depth map is built from three layers so that only what actually moved
+// is re-rendered each frame:
+//   static  - static casters, re-rendered only when one of them is dirty
+//   far     - static layer + distant dynamic casters, refreshed every
+//             farUpdateInterval frames
+//   final   - far layer + near dynamic casters, rebuilt every frame and
+//             sampled by the main pass
+// Layers are combined with depth blits, so the per-frame cost is one blit plus
+// the near casters.
+
+// Called to draw one caster; modelLoc is the model-matrix uniform to write.
+typedef void (*ShadowDrawFn)(int userId, GLint modelLoc);
+
+struct ShadowSettings {
+    int   resolution = 2048;        // width/height of each depth layer
+    int   farUpdateInterval = 4;    // frames between refreshes of distant casters
+    float farDistance = 8.0f;       // casters beyond this from the eye count as distant
+};
+
+struct ShadowStats {
+    double gpuMs = 0.0;             // last resolved GL_TIME_ELAPSED of the pass
+    double cpuMs = 0.0;             // CPU time spent issuing the pass
+    int staticRedraws = 0;          // layer refreshes since the last resetStats()
+    int farRedraws = 0;
+    int frames = 0;
+};
+
+class ShadowMap {
+public:
+    bool init(const ShadowSettings& settings, GLuint positionAttrib);
+    void shutdown();
+
+    // Casters are identified by the returned index; userId is passed back to
+    // the draw callback. radius is the bounding radius used for classification.
+    int  addCaster(bool isStatic, int userId, float radius);
+    void setCasterCenter(int caster, const glm::vec3& center);
+    void markDirty(int caster);
+
+    // Orthographic light looking from pos at target, covering +-halfExtent.
+    void setLight(const glm::vec3& pos, const glm::vec3& target,
+                  float halfExtent, float nearZ, float farZ);
+
+    // Rebuild whichever layers are out of date. Restores FBO 0, the viewport
+    // and the previously bound program.
+    void update(const glm::vec3& eyePos, ShadowDrawFn draw);
+
+    GLuint depthTexture() const { return layers[LAYER_FINAL].tex; }
+    const glm::mat4& lightViewProj() const { return lightVP; }
+    const ShadowSettings& config() const { return settings; }
+
+    const ShadowStats& stats() const { return stat; }
+    void resetStats();
+
+private:
+    enum { LAYER_STATIC, LAYER_FAR, LAYER_FINAL, LAYER_COUNT };
+    enum { QUERY_COUNT = 3 };       // results read back QUERY_COUNT-1 frames late
+
+    struct Layer {
+        GLuint fbo = 0;
+        GLuint tex = 0;
+    };
+
+    struct Caster {
+        int userId;
+        float radius;
+        glm::vec3 center;
+        bool isStatic;
+        bool dirty;
+        bool far;                   // which dynamic layer it was last drawn into
+    };
+
+    void beginLayer(int layer, int copyFrom);
+    void drawCasters(ShadowDrawFn draw, int kind);
+
+    ShadowSettings settings;
+    Layer layers[LAYER_COUNT];
+    std::vector<Caster> casters;
+
+    GLuint program = 0;
+    GLint lightVPLoc = -1;
+    GLint modelLoc = -1;
+
+    glm::mat4 lightVP = glm::mat4(1.0f);
+    bool staticDirty = true;
+    bool farDirty = true;
+    int frameIndex = 0;
+    int lastFarFrame = 0;
+
+    bool hasTimer = false;
+    GLuint queries[QUERY_COUNT] = { 0 };
+    int queryFrame = 0;
+
+    ShadowStats stat;
+};
@@ -0,0 +1,6 @@
+#version 150
+
+// Depth-only pass: no color attachments, depth is written by the rasterizer.
+void main()
+{
+}
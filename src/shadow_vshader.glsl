@@ -0,0 +1,11 @@
+#version 150
+
+in  vec4 vPosition;
+
+uniform mat4 mLightViewProj;
+uniform mat4 mModel;
+
+void main()
+{
+    gl_Position = mLightViewProj * mModel * vPosition;
+}
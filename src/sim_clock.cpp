@@ -0,0 +1,29 @@
+#include "sim_clock.h"
+
+void SimClock::init(const SimClockSettings& s)
+{
+    settings = s;
+    if (settings.stepHz <= 0.0) settings.stepHz = 120.0;
+    if (settings.maxSteps < 1) settings.maxSteps = 1;
+    step = 1.0 / settings.stepHz;
+    accumulator = 0.0;
+    dropped = 0.0;
+    count = 0;
+}
+
+int SimClock::advance(double dtSec)
+{
+    if (dtSec > 0.0) accumulator += dtSec;
+    int n = 0;
+    while (accumulator >= step && n < settings.maxSteps) {
+        accumulator -= step;
+        n++;
+    }
+    // Over the cap: keep the fraction for the blend, drop whole steps
+    if (accumulator >= step) {
+        double keep = accumulator - step * (double)(int64_t)(accumulator / step);
+        dropped += accumulator - keep;
+        accumulator = keep;
+    }
+    return n;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+
+// Fixed-step simulation clock. Real time goes into an accumulator and comes
+// out as whole steps of 1 / stepHz seconds, so the simulation advances the
+// same way at any frame rate. The renderer then blends the last two
+// simulation states by alpha(), which puts it one step behind the newest
+// state but keeps the motion smooth between steps.
+//
+// At most maxSteps run per frame. When a frame needs more (a stall, or a
+// simulation that cannot keep up) the surplus is dropped and the simulation
+// runs slower than real time for that frame, rather than falling further
+// behind every frame (the "spiral of death").
+
+struct SimClockSettings {
+    double stepHz = 120.0;
+    int    maxSteps = 8;            // per advance()
+};
+
+class SimClock {
+public:
+    void init(const SimClockSettings& settings);
+
+    // Add dtSec of real time; returns how many steps are due now. Run each
+    // with tick():
+    //   for (int n = clock.advance(dt); n > 0; n--) simulate(clock.tick());
+    int advance(double dtSec);
+    // Count one step; returns the simulation time at its end
+    double tick() { count++; return time(); }
+
+    double stepSec() const { return step; }
+    uint64_t steps() const { return count; }
+    // Simulation time after steps() steps; exact multiples of the step,
+    // so it does not drift with the frame rate
+    double time() const { return (double)count * step; }
+    // Where the render time lies between the last two states, in [0, 1)
+    float alpha() const { return (float)(accumulator / step); }
+
+    const SimClockSettings& config() const { return settings; }
+    double droppedSec() const { return dropped; }
+
+private:
+    SimClockSettings settings;
+    double step = 1.0 / 120.0;
+    double accumulator = 0.0;
+    double dropped = 0.0;           // real time thrown away by the step cap
+    uint64_t count = 0;
+};
@@ -0,0 +1,44 @@
+#include "sim_thread.h"
+
+static SimThread::Clock::duration toDuration(double sec)
+{
+    return std::chrono::duration_cast<SimThread::Clock::duration>(std::chrono::duration<double>(sec));
+}
+
+void SimThread::start(const SimClockSettings& settings, StepFn stepCb, PublishFn publishCb, double pollMs)
+{
+    stop();
+    clock.init(settings);
+    step = clock.stepSec();
+    poll = pollMs * 0.001;
+    stepFn = stepCb;
+    publishFn = publishCb;
+    stopping.store(false);
+    thread = std::thread(&SimThread::loop, this);
+}
+
+void SimThread::stop()
+{
+    if (!thread.joinable()) return;
+    stopping.store(true);
+    thread.join();
+}
+
+void SimThread::loop()
+{
+    Clock::time_point last = Clock::now();
+    while (!stopping.load(std::memory_order_relaxed)) {
+        const Clock::time_point now = Clock::now();
+        const bool hold = paused.load(std::memory_order_relaxed);
+        int n = hold ? 0 : clock.advance(std::chrono::duration<double>(now - last).count());
+        last = now;
+        const bool stepped = n > 0;
+        for (; n > 0; n--) stepFn(clock.tick());
+
+        // The newest step was due alpha() steps ago
+        const Clock::time_point stepWall = now - toDuration(clock.alpha() * step);
+        publishFn(stepWall, stepped);
+
+        std::this_thread::sleep_until(hold ? now + toDuration(poll) : stepWall + toDuration(step));
+    }
+}
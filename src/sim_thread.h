@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "sim_clock.h"
+
+// Runs a SimClock on its own thread, so simulation and animation cost never
+// delays GL submission. The thread sleeps until the next step is due, runs
+// the due steps, then calls publish once, which is expected to hand an
+// immutable snapshot to the GL thread (see triple_buffer.h).
+//
+// stepWall, passed to publish, is the wall time the newest step's simulation
+// time corresponds to. A renderer blends the last two steps by
+//   alpha = (now - stepWall) / stepSec, clamped to [0, 1]
+// and shows the simulation one step in the past, as with SimClock alone.
+//
+// Paused, no steps run, but publish is still called every pollMs so input
+// handled on the GL thread (e.g. a camera change) can reach a snapshot.
+
+class SimThread {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // Both run on the simulation thread
+    typedef void (*StepFn)(double timeSec);
+    typedef void (*PublishFn)(Clock::time_point stepWall, bool stepped);
+
+    SimThread() : stopping(false), paused(false) {}
+    ~SimThread() { stop(); }
+
+    // Steps from simulation time 0; call publish once on this thread first
+    // if the consumer needs a snapshot before the thread's first wake-up
+    void start(const SimClockSettings& settings, StepFn step, PublishFn publish, double pollMs = 10.0);
+    void stop();
+
+    void setPaused(bool on) { paused.store(on, std::memory_order_relaxed); }
+    bool isPaused() const { return paused.load(std::memory_order_relaxed); }
+    double stepSec() const { return step; }
+
+private:
+    void loop();
+
+    SimClock clock;
+    StepFn stepFn = nullptr;
+    PublishFn publishFn = nullptr;
+    double step = 1.0 / 120.0;
+    double poll = 0.01;
+    std::thread thread;
+    std::atomic<bool> stopping;
+    std::atomic<bool> paused;
+};
@@ -0,0 +1,118 @@
+#include "swim_rig.h"
+#include <math.h>
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+// 6 keyframes (+1 wrap row). Degrees.
+// This guarantees monotonic increase (no "shortest-arc" reversal).
+static const int K = CLIP_SEGMENTS;
+static const float k_shoulderR[K + 1] = { 360, 315, 270, 225, 180, 90, 0 };
+static const float k_shoulderL[K + 1] = { 225, 135, 45, 0, -45, -90, -135 };
+
+// Elbow flex (freestyle style). Rough, but plausible.
+// R-frame aligned with k_shoulderR; L-frame aligned with k_shoulderL (phase-shifted).
+static const float k_elbowR[K + 1] = { 45, 180, 270, 345, 420, 360, 405 };
+static const float k_elbowL[K + 1] = { 30, 0, 15, 45, 180, 270, 390 };
+// Flutter kick around hips; knees follow with slightly different phase/amplitude.
+static const float k_hipR[K + 1] = { 5, 15, 30, 5, 15, 30, 5 };
+static const float k_hipL[K + 1] = { 30, 20, 5, 30, 20, 5, 30 };
+static const float k_kneeR[K + 1] = { -20, 0, 0, -20, -0, 0, -20 };
+static const float k_kneeL[K + 1] = { 0, 0, -20, 0, 0, -20, 0 };
+// Torso bobbing (small). Up axis = +Y.
+static const float k_torsoBobY[K + 1] = { 0.04f, 0.02f, 0.00f, -0.02f, -0.01f, 0.02f, 0.04f };
+
+const float* const k_clip[ANIM_CHANNEL_COUNT] = {
+    k_shoulderR, k_shoulderL, k_elbowR, k_elbowL,
+    k_hipR, k_hipL, k_kneeR, k_kneeL, k_torsoBobY
+};
+
+// Sizes
+static const glm::vec3 torsoS(0.7f, 1.0f, 0.3f);
+static const glm::vec3 headS(0.3f, 0.3f, 0.3f);
+static const glm::vec3 uArmS(0.2f, 0.5f, 0.2f);
+static const glm::vec3 fArmS(0.2f, 0.6f, 0.2f);
+static const glm::vec3 uLegS(0.2f, 0.8f, 0.2f);
+static const glm::vec3 lLegS(0.2f, 0.8f, 0.2f);
+
+const glm::vec3 k_partSize[PART_COUNT] = {
+    torsoS, headS, uArmS, fArmS, uArmS, fArmS, uLegS, lLegS, uLegS, lLegS
+};
+
+// Shoulder/hip anchors in torso space
+static const float shoulderY = torsoS.y * 0.55f;
+static const float shoulderX = torsoS.x * 0.67f;
+static const float hipY = -torsoS.y * 0.55f;
+static const float hipX = torsoS.x * 0.33f;
+
+const BoneRig k_rig[PART_COUNT] = {
+    // Torso (centered), head above it along +Y
+    { glm::vec3(0.0f), -1, glm::vec3(0.0f), -1, glm::vec3(0.0f) },
+    { glm::vec3(0, torsoS.y * 0.5f + headS.y * 0.5f, 0), -1, glm::vec3(0.0f), -1, glm::vec3(0.0f) },
+    // Arms: upper arm pivots at the shoulder; forearm from its end at the elbow
+    { glm::vec3(+shoulderX, shoulderY, 0), ANIM_SHOULDER_R, glm::vec3(0, -uArmS.y * 0.55f, 0), -1, glm::vec3(0.0f) },
+    { glm::vec3(+shoulderX, shoulderY, 0), ANIM_SHOULDER_R, glm::vec3(0, -uArmS.y, 0), ANIM_ELBOW_R, glm::vec3(0, -fArmS.y * 0.55f, 0) },
+    { glm::vec3(-shoulderX, shoulderY, 0), ANIM_SHOULDER_L, glm::vec3(0, -uArmS.y * 0.55f, 0), -1, glm::vec3(0.0f) },
+    { glm::vec3(-shoulderX, shoulderY, 0), ANIM_SHOULDER_L, glm::vec3(0, -uArmS.y, 0), ANIM_ELBOW_L, glm::vec3(0, -fArmS.y * 0.55f, 0) },
+    // Legs: thigh at the hip, shin at the knee
+    { glm::vec3(+hipX, hipY, 0), ANIM_HIP_R, glm::vec3(0, -uLegS.y * 0.5f, 0), -1, glm::vec3(0.0f) },
+    { glm::vec3(+hipX, hipY, 0), ANIM_HIP_R, glm::vec3(0, -uLegS.y, 0), ANIM_KNEE_R, glm::vec3(0, -lLegS.y * 0.55f, 0) },
+    { glm::vec3(-hipX, hipY, 0), ANIM_HIP_L, glm::vec3(0, -uLegS.y * 0.5f, 0), -1, glm::vec3(0.0f) },
+    { glm::vec3(-hipX, hipY, 0), ANIM_HIP_L, glm::vec3(0, -uLegS.y, 0), ANIM_KNEE_L, glm::vec3(0, -lLegS.y * 0.56f, 0) },
+};
+
+// Base/prone: rotate the torso -90 degrees about X so the man "lies facing down"
+const float k_pronePitch = -90.0f;
+
+static inline glm::mat4 rotX_deg(const glm::mat4& M, float deg)
+{
+    return glm::rotate(M, glm::radians(deg), glm::vec3(1, 0, 0));
+}
+
+// Linear interp for keyframes in [0,1) -> [idx, idx+1]
+float clipChannel(int c, float tCycle)
+{
+    const float* a = k_clip[c];
+    float seg = tCycle * K;
+    int i = (int)glm::clamp(floorf(seg), 0.0f, float(K - 1));
+    float u = seg - float(i);
+    return a[i] * (1.0f - u) + a[i + 1] * u;
+}
+
+void sampleClip(float tCycle, float channels[ANIM_CHANNEL_COUNT])
+{
+    for (int c = 0; c < ANIM_CHANNEL_COUNT; c++) channels[c] = clipChannel(c, tCycle);
+}
+
+void poseManAt(float tCycle, ManPose& pose)
+{
+    float ch[ANIM_CHANNEL_COUNT];
+    sampleClip(tCycle, ch);
+    poseFromChannels(ch, pose);
+}
+
+void poseFromChannels(const float ch[ANIM_CHANNEL_COUNT], ManPose& pose)
+{
+    glm::mat4 base = glm::translate(glm::mat4(1.0f), glm::vec3(0, ch[ANIM_BOB_Y], 0));
+    base = rotX_deg(base, k_pronePitch);
+
+    for (int i = 0; i < PART_COUNT; i++) {
+        const BoneRig& r = k_rig[i];
+        glm::mat4 M = glm::translate(base, r.anchor);
+        if (r.joint0 >= 0) M = rotX_deg(M, ch[r.joint0]);   // continuous monotonic rotation
+        M = glm::translate(M, r.mid);
+        if (r.joint1 >= 0) M = rotX_deg(M, ch[r.joint1]);
+        pose.bone[i] = glm::translate(M, r.tip);
+        pose.part[i] = glm::scale(pose.bone[i], k_partSize[i]);
+    }
+}
+
+void lerpPose(const ManPose& a, const ManPose& b, float t, ManPose& out)
+{
+    for (int i = 0; i < PART_COUNT; i++) {
+        glm::quat q = glm::slerp(glm::quat_cast(glm::mat3(a.bone[i])), glm::quat_cast(glm::mat3(b.bone[i])), t);
+        glm::mat4 M = glm::mat4_cast(q);
+        M[3] = glm::mix(a.bone[i][3], b.bone[i][3], t);
+        out.bone[i] = M;
+        out.part[i] = glm::scale(M, k_partSize[i]);
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "glm/glm.hpp"
+
+// The swimmer: a rigid ten-part body and its looping freestyle clip. Shared
+// by the app (CPU FK, the GPU clip block) and tools/vatbake. All dimensions
+// are in "unit cube" scale space.
+
+enum ManPart {
+    PART_TORSO, PART_HEAD,
+    PART_UARM_R, PART_FARM_R, PART_UARM_L, PART_FARM_L,
+    PART_ULEG_R, PART_LLEG_R, PART_ULEG_L, PART_LLEG_L,
+    PART_COUNT
+};
+
+// Keyframed channels of the clip: joint angles in degrees, the bob in units
+enum AnimChannel {
+    ANIM_SHOULDER_R, ANIM_SHOULDER_L, ANIM_ELBOW_R, ANIM_ELBOW_L,
+    ANIM_HIP_R, ANIM_HIP_L, ANIM_KNEE_R, ANIM_KNEE_L, ANIM_BOB_Y,
+    ANIM_CHANNEL_COUNT
+};
+
+// Keys 0..CLIP_SEGMENTS spread evenly over the cycle; the last is the wrap row
+enum { CLIP_SEGMENTS = 6 };
+
+// k_clip[c][k]: channel c at key k
+extern const float* const k_clip[ANIM_CHANNEL_COUNT];
+
+// Limb sizes in unit cube/sphere scale; the skinned body mesh has them baked in
+extern const glm::vec3 k_partSize[PART_COUNT];
+
+// Each bone hangs off the torso through at most two X-axis joints:
+//   bone = base * T(anchor) * Rx(joint0) * T(mid) * Rx(joint1) * T(tip)
+// with the joint angles read from clip channels (-1: no joint), and
+//   base = T(0, bob, 0) * Rx(k_pronePitch)
+// poseManAt and the vertex shader's GPU path both walk this table.
+struct BoneRig {
+    glm::vec3 anchor; int joint0;
+    glm::vec3 mid; int joint1;
+    glm::vec3 tip;
+};
+
+extern const BoneRig k_rig[PART_COUNT];
+extern const float k_pronePitch;
+
+// Rigid bone transforms from the FK pass, and the same with each limb's
+// size applied (what the unit cube/sphere draws use)
+struct ManPose {
+    glm::mat4 bone[PART_COUNT];
+    glm::mat4 part[PART_COUNT];
+};
+
+// Channel c at cycle position tCycle in [0,1), linearly interpolated
+float clipChannel(int c, float tCycle);
+
+// Every channel at cycle position tCycle in [0,1)
+void sampleClip(float tCycle, float channels[ANIM_CHANNEL_COUNT]);
+
+// FK: bone and part transforms from sampled channels
+void poseFromChannels(const float channels[ANIM_CHANNEL_COUNT], ManPose& pose);
+
+// Pose at cycle position tCycle in [0,1): sampleClip, then poseFromChannels
+void poseManAt(float tCycle, ManPose& pose);
+
+// Blend of two poses (t = 0: a, 1: b): translations lerped, rotations
+// slerped, so the bones stay rigid. For nearby poses, e.g. successive
+// simulation steps.
+void lerpPose(const ManPose& a, const ManPose& b, float t, ManPose& out);
@@ -0,0 +1,261 @@
+#include "task_scheduler.h"
+#include "frame_arena.h"
+
+struct Task {
+    TaskScheduler::Fn fn;
+    TaskScheduler::RangeFn range;       // parallelFor root
+    const TaskScheduler::RangeFn* rangeFn = nullptr;    // root's range, shared by its pieces
+    int begin = 0, end = 0, grain = 1;
+    std::atomic<int> unmet{1};          // unfinished dependencies, + 1 until submitted
+    std::atomic<int> open{1};           // 1 + unfinished split-off pieces
+    Task* parent = nullptr;             // piece: the task it was split from
+    std::vector<Task*> successors;
+    TaskCounter* counter = nullptr;
+    AllocAccount* account = nullptr;    // the creating thread's, see execute()
+};
+
+// Worker index of the calling thread in the scheduler it belongs to
+static thread_local const TaskScheduler* t_scheduler = nullptr;
+static thread_local int t_worker = -1;
+
+bool TaskScheduler::init(int threads)
+{
+    shutdown();
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    if (threads <= 0) threads = 1;
+    stopping.store(false);
+    for (int i = 0; i < threads - 1; i++) queues.emplace_back(new WorkerQueue);
+    for (int i = 0; i < threads - 1; i++) workers.emplace_back(&TaskScheduler::workerLoop, this, i);
+    return true;
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    shutdown();
+    for (size_t i = 0; i < pool.size(); i++) delete pool[i];
+}
+
+void TaskScheduler::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        stopping.store(true);
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+    workers.clear();
+    queues.clear();
+}
+
+void TaskScheduler::TaskRing::push_back(Task* task)
+{
+    if (count == ring.size()) {
+        std::vector<Task*> grown(ring.empty() ? 64 : ring.size() * 2);
+        for (size_t i = 0; i < count; i++) grown[i] = ring[(head + i) & (ring.size() - 1)];
+        ring.swap(grown);
+        head = 0;
+    }
+    ring[(head + count++) & (ring.size() - 1)] = task;
+}
+
+Task* TaskScheduler::allocTask()
+{
+    std::lock_guard<std::mutex> guard(poolLock);
+    if (pool.empty()) {
+        // At least double the tasks in existence, so a frame needs more than
+        // twice its old peak in flight before it allocates again. Room for a
+        // few successors up front: any recycled task may be depended on.
+        const size_t grow = tasksAllocated > 64 ? tasksAllocated : 64;
+        tasksAllocated += grow;
+        pool.reserve(tasksAllocated);
+        for (size_t i = 0; i < grow; i++) {
+            Task* task = new Task;
+            task->successors.reserve(4);
+            pool.push_back(task);
+        }
+    }
+    Task* task = pool.back();
+    pool.pop_back();
+    task->account = allocAccount();
+    return task;
+}
+
+void TaskScheduler::recycle(Task* task)
+{
+    task->fn = nullptr;
+    task->range = nullptr;
+    task->rangeFn = nullptr;
+    task->begin = task->end = 0;
+    task->grain = 1;
+    task->unmet.store(1, std::memory_order_relaxed);
+    task->open.store(1, std::memory_order_relaxed);
+    task->parent = nullptr;
+    task->successors.clear();
+    task->counter = nullptr;
+    task->account = nullptr;
+    std::lock_guard<std::mutex> guard(poolLock);
+    pool.push_back(task);
+}
+
+Task* TaskScheduler::create(Fn fn)
+{
+    Task* task = allocTask();
+    task->fn = std::move(fn);
+    return task;
+}
+
+Task* TaskScheduler::parallelFor(int begin, int end, int grain, RangeFn fn)
+{
+    Task* task = allocTask();
+    task->range = std::move(fn);
+    task->rangeFn = &task->range;
+    task->begin = begin;
+    task->end = end;
+    task->grain = grain > 0 ? grain : 1;
+    return task;
+}
+
+void TaskScheduler::depend(Task* task, Task* on)
+{
+    task->unmet.fetch_add(1, std::memory_order_relaxed);
+    on->successors.push_back(task);
+}
+
+void TaskScheduler::submit(Task* task, TaskCounter* done)
+{
+    if (done) {
+        done->pending.fetch_add(1, std::memory_order_relaxed);
+        task->counter = done;
+    }
+    release(task);
+}
+
+void TaskScheduler::release(Task* task)
+{
+    if (task->unmet.fetch_sub(1, std::memory_order_acq_rel) == 1) push(task);
+}
+
+void TaskScheduler::push(Task* task)
+{
+    WorkerQueue& q = (t_scheduler == this && t_worker >= 0) ? *queues[t_worker] : injected;
+    {
+        std::lock_guard<std::mutex> guard(q.lock);
+        q.tasks.push_back(task);
+    }
+    epoch.fetch_add(1);
+    if (sleepers.load() > 0) {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        wake.notify_one();
+    }
+}
+
+Task* TaskScheduler::findWork(int self)
+{
+    if (self >= 0) {
+        WorkerQueue& own = *queues[self];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.tasks.empty()) return own.tasks.pop_back();
+    }
+    {
+        std::lock_guard<std::mutex> guard(injected.lock);
+        if (!injected.tasks.empty()) return injected.tasks.pop_front();
+    }
+    // Steal, starting next to ourselves so thieves spread over the victims
+    const int n = (int)queues.size();
+    for (int i = 1; i <= n; i++) {
+        WorkerQueue& victim = *queues[(self + i + n) % n];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) return victim.tasks.pop_front();
+    }
+    return nullptr;
+}
+
+// Runs under the account of the thread that created the task: heap
+// allocations count toward that thread's frame check (frame_arena.h) no
+// matter which thread runs it. Pieces and continuations created here
+// inherit the account.
+void TaskScheduler::execute(Task* task)
+{
+    AllocAccount* const prev = setAllocAccount(task->account);
+    if (task->rangeFn) {
+        // Split off upper halves for thieves, run what is left
+        while (task->end - task->begin > task->grain) {
+            const int mid = task->begin + (task->end - task->begin) / 2;
+            Task* piece = allocTask();
+            piece->rangeFn = task->rangeFn;
+            piece->begin = mid;
+            piece->end = task->end;
+            piece->grain = task->grain;
+            piece->parent = task;
+            piece->unmet.store(0, std::memory_order_relaxed);
+            task->open.fetch_add(1, std::memory_order_relaxed);
+            task->end = mid;
+            push(piece);
+        }
+        (*task->rangeFn)(task->begin, task->end);
+    }
+    else if (task->fn) task->fn();
+    finish(task);
+    setAllocAccount(prev);
+}
+
+void TaskScheduler::finish(Task* task)
+{
+    while (task) {
+        if (task->open.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        for (size_t i = 0; i < task->successors.size(); i++) release(task->successors[i]);
+        // seq_cst, paired with block(): either it sees the count reach zero
+        // or this sees it blocked
+        if (task->counter && task->counter->pending.fetch_sub(1) == 1 && blocked.load() > 0) {
+            std::lock_guard<std::mutex> guard(blockLock);
+            unblock.notify_all();
+        }
+        Task* parent = task->parent;
+        recycle(task);
+        task = parent;
+    }
+}
+
+void TaskScheduler::wait(TaskCounter& counter)
+{
+    const int self = t_scheduler == this ? t_worker : -1;
+    while (!counter.done()) {
+        Task* task = findWork(self);
+        if (task) execute(task);
+        else std::this_thread::yield();
+    }
+}
+
+void TaskScheduler::block(TaskCounter& counter)
+{
+    if (counter.done()) return;
+    std::unique_lock<std::mutex> lock(blockLock);
+    blocked.fetch_add(1);
+    unblock.wait(lock, [&] { return counter.pending.load() == 0; });
+    blocked.fetch_sub(1);
+}
+
+void TaskScheduler::run(int begin, int end, int grain, RangeFn fn)
+{
+    TaskCounter done;
+    submit(parallelFor(begin, end, grain, std::move(fn)), &done);
+    wait(done);
+}
+
+void TaskScheduler::workerLoop(int index)
+{
+    t_scheduler = this;
+    t_worker = index;
+    while (!stopping.load()) {
+        const unsigned seen = epoch.load();
+        Task* task = findWork(index);
+        if (task) {
+            execute(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepLock);
+        sleepers.fetch_add(1);
+        wake.wait(lock, [&] { return stopping.load() || epoch.load() != seen; });
+        sleepers.fetch_sub(1);
+    }
+}
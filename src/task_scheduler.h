@@ -0,0 +1,130 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing task scheduler.
+//
+// threads - 1 workers, plus whichever thread is in wait(): a waiting thread
+// runs tasks until what it waits for is done, so waiting never idles a core.
+// It runs whatever it finds, though, not just what it waits for. A thread
+// that must not pick up other work (the GL thread) uses block() instead,
+// which sleeps until the workers are done; that needs threads > 1.
+// Each worker owns a deque. It pushes and pops its own tasks at the back
+// (newest first, still in cache); an idle worker steals from the front of
+// another's (the oldest, usually the biggest piece left). Tasks made ready on
+// threads that are not workers go to a shared injection queue. Workers with
+// nothing to run or steal sleep until more work is pushed.
+//
+// A task runs once it has been submitted and every task it depends on has
+// finished; a continuation is simply a dependent task. A parallelFor task
+// splits its range in halves down to the grain, pushing the upper halves
+// for thieves, and counts as finished when every piece has run. A
+// TaskCounter counts submitted, unfinished tasks for wait():
+//
+//   TaskCounter done;
+//   Task* a = sched.create([&] { ... });
+//   Task* b = sched.parallelFor(0, n, 256, [&](int lo, int hi) { ... });
+//   sched.depend(b, a);         // b's ranges start after a has run
+//   sched.submit(b, &done);
+//   sched.submit(a, &done);
+//   sched.wait(done);
+//
+// Tasks are recycled when they finish: do not touch a Task* after
+// submitting it and everything depending on it. Finished tasks, the queues
+// and the pieces of a parallelFor (which share their root's function) all
+// keep their memory, so a steady frame of tasks allocates nothing as long as
+// std::function can hold the closures inline: capture at most two pointers'
+// worth, e.g. references to the stack of the thread that waits.
+
+struct Task;
+
+struct TaskCounter {
+    std::atomic<int> pending{0};
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+class TaskScheduler {
+public:
+    typedef std::function<void()> Fn;
+    typedef std::function<void(int begin, int end)> RangeFn;
+
+    TaskScheduler() : stopping(false), epoch(0), sleepers(0), blocked(0) {}
+    ~TaskScheduler();
+
+    // threads <= 0: one per core. Starts threads - 1 workers.
+    bool init(int threads = 0);
+    // Wait for outstanding work first; unfinished tasks are leaked
+    void shutdown();
+    int threadCount() const { return (int)queues.size() + 1; }
+
+    Task* create(Fn fn);
+    Task* parallelFor(int begin, int end, int grain, RangeFn fn);
+    // task will not start before on has finished. Both must be unsubmitted.
+    void depend(Task* task, Task* on);
+    void submit(Task* task, TaskCounter* done = nullptr);
+    // Run tasks until counter reaches zero
+    void wait(TaskCounter& counter);
+    // Sleep until counter reaches zero, running nothing
+    void block(TaskCounter& counter);
+
+    // parallelFor, submitted and waited for
+    void run(int begin, int end, int grain, RangeFn fn);
+
+private:
+    // Ring buffer deque: unlike std::deque it never frees, so it stops
+    // allocating once it has grown to the deepest queue seen
+    class TaskRing {
+    public:
+        bool empty() const { return count == 0; }
+        void push_back(Task* task);
+        Task* pop_back() { return ring[(head + --count) & (ring.size() - 1)]; }
+        Task* pop_front()
+        {
+            Task* task = ring[head];
+            head = (head + 1) & (ring.size() - 1);
+            count--;
+            return task;
+        }
+
+    private:
+        std::vector<Task*> ring;    // power-of-two size
+        size_t head = 0, count = 0;
+    };
+
+    struct WorkerQueue {
+        std::mutex lock;
+        TaskRing tasks;
+        char pad[64];               // keep neighbouring queues' locks off one cache line
+    };
+
+    Task* allocTask();
+    void recycle(Task* task);
+
+    void workerLoop(int index);
+    void push(Task* task);
+    Task* findWork(int self);
+    void execute(Task* task);
+    void finish(Task* task);
+    void release(Task* task);
+
+    std::vector<std::unique_ptr<WorkerQueue> > queues;   // one per worker
+    WorkerQueue injected;                               // pushed from other threads
+    std::mutex poolLock;
+    std::vector<Task*> pool;                            // finished tasks, for reuse
+    size_t tasksAllocated = 0;
+    std::vector<std::thread> workers;
+
+    std::atomic<bool> stopping;
+    std::atomic<unsigned> epoch;        // bumped on every push, for sleepers
+    std::atomic<int> sleepers;
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    std::atomic<int> blocked;           // threads in block()
+    std::mutex blockLock;
+    std::condition_variable unblock;
+};
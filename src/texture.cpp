@@ -5,81 +5,133 @@
 #include <string.h>
 
 #include "GL/glew.h"
+#include "bmp.h"
+#include "mipmap.h"
+#include "dds.h"
+#include "gl_stats.h"
 
 //#include <GLFW/glfw3.h>
 
+// Upload every level of a mip chain to the bound GL_TEXTURE_2D with trilinear filtering
+static void uploadMipChain(const MipChain& chain) {
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (size_t i = 0; i < chain.levels.size(); i++) {
+        const MipLevel& L = chain.levels[i];
+        glTexImage2D(GL_TEXTURE_2D, (GLint)i, GL_RGB8, L.width, L.height, 0,
+            GL_RGBA, GL_UNSIGNED_BYTE, chain.level((int)i));
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)chain.levels.size() - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    if (GLEW_EXT_texture_filter_anisotropic) {
+        GLfloat maxAniso = 1.0f;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAniso);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxAniso < 4.0f ? maxAniso : 4.0f);
+    }
+}
+
 
 GLuint loadBMP_custom(const char* imagepath) {
 
     printf("Reading image %s\n", imagepath);
 
-    // Data read from the header of the BMP file
-    unsigned char header[54]; // Each BMP file begins by a 54-bytes header
-    unsigned int dataPos;     // Position in the file where the actual data begins
-    unsigned int width, height;
-    unsigned int imageSize;   // = width*height*3
-    // Actual RGB data
-    unsigned char* data;
+    // Gamma-correct mip chain, reused from "<asset>.mips" when the BMP is unchanged
+    MipChain chain;
+    if (!loadMipCache(imagepath, MIP_FILTER_KAISER, chain)) {
+        BmpImage image;
+        if (!readBMP(imagepath, image)) return 0;
+        buildMipChain(&image.rgba[0], image.width, image.height, MIP_FILTER_KAISER, chain);
+        if (!saveMipCache(imagepath, chain)) printf("Could not write mip cache for %s\n", imagepath);
+    }
 
-    // Open the file
-    FILE* file = fopen(imagepath, "rb");
-    if (!file) { printf("Image could not be opened\n"); return 0; }
+    // Create one OpenGL texture
+    GLuint textureID;
+    glGenTextures(1, &textureID);
 
-    if (fread(header, 1, 54, file) != 54) { // If not 54 bytes read : problem
-        printf("Not a correct BMP file\n");
-        fclose(file);
-        return 0;
-    }
-    if (header[0] != 'B' || header[1] != 'M') {
-        printf("Not a correct BMP file\n");
-        fclose(file);
-        return 0;
-    }
-    // Make sure this is a 24bpp file
-    if (*(int*)&(header[0x1E]) != 0) { printf("Not a correct BMP file\n"); fclose(file); return 0; }
-    if (*(int*)&(header[0x1C]) != 24) { printf("Not a correct BMP file\n"); fclose(file); return 0; }
+    // "Bind" the newly created texture : all future texture functions will modify this texture
+    glsBindTexture(GL_TEXTURE_2D, textureID);
 
-    // Read the information about the image
-    dataPos = *(int*)&(header[0x0A]);
-    imageSize = *(int*)&(header[0x22]);
-    width = *(int*)&(header[0x12]);
-    height = *(int*)&(header[0x16]);
+    // Give the image to OpenGL
+    uploadMipChain(chain);
 
-    if (imageSize == 0)    imageSize = width * height * 3; // 3 : one byte for each Red, Green and Blue component
-    if (dataPos == 0)      dataPos = 54; // The BMP header is done that way
+    // Return the ID of the texture we just created
+    return textureID;
+}
 
-    // Create a buffer
-    data = new unsigned char[imageSize];
+static GLenum glCompressedFormat(BCFormat f) {
+    switch (f) {
+    case BC_FORMAT_BC1: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    case BC_FORMAT_BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case BC_FORMAT_BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    default: return 0;
+    }
+}
 
-    // Read the actual data from the file into the buffer
-    fread(data, 1, imageSize, file);
+static bool driverSupports(BCFormat f) {
+    if (f == BC_FORMAT_BC7) return GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+    return GLEW_EXT_texture_compression_s3tc != 0;
+}
 
-    //Everything is in memory now, the file can be closed.
-    fclose(file);
+GLuint loadDDS(const char* imagepath) {
 
-    // Create one OpenGL texture
-    GLuint textureID;
-    glGenTextures(1, &textureID);
+    printf("Reading image %s\n", imagepath);
 
-    // "Bind" the newly created texture : all future texture functions will modify this texture
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    FILE* file = fopen(imagepath, "rb");
+    if (!file) { printf("Image could not be opened\n"); return 0; }
 
-    // Give the image to OpenGL
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, data);
+    fseek(file, 0L, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0L, SEEK_SET);
+    if (size <= 0) { printf("Not a correct DDS file\n"); fclose(file); return 0; }
 
-    // Poor filtering. Needed !
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    unsigned char* data = new unsigned char[size];
+    size_t got = fread(data, 1, size, file);
+    fclose(file);
 
-    // // Optional : Nice trilinear filtering + mipmaps
-    // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    // glGenerateMipmap(GL_TEXTURE_2D);
+    DDSImage dds;
+    const char* why = "short read";
+    if (got != (size_t)size || !parseDDS(data, got, dds, &why)) {
+        printf("Not a correct DDS file (%s)\n", why);
+        delete[] data;
+        return 0;
+    }
 
+    GLuint textureID;
+    glGenTextures(1, &textureID);
+    glsBindTexture(GL_TEXTURE_2D, textureID);
+
+    bool direct = driverSupports(dds.format);
+    if (!direct) printf("Compressed format not supported by the driver, decoding %s on the CPU\n", imagepath);
+
+    unsigned char* rgba = direct ? NULL : new unsigned char[(size_t)dds.width * dds.height * 4];
+    int w = dds.width, h = dds.height;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (int i = 0; i < dds.levelCount; i++) {
+        if (direct) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, glCompressedFormat(dds.format), w, h, 0,
+                (GLsizei)dds.levelSize[i], dds.level[i]);
+        }
+        else {
+            bcDecodeImage(dds.format, dds.level[i], w, h, rgba);
+            glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+        }
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+    }
+    delete[] rgba;
     delete[] data;
 
-    // Return the ID of the texture we just created
+    // A truncated chain is still complete if MAX_LEVEL stops at the last level
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, dds.levelCount - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+        dds.levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+
     return textureID;
 }
@@ -6,7 +6,8 @@
 // Load a .BMP file using our custom loader
 GLuint loadBMP_custom(const char* imagepath);
 
-// Load a .DDS file using GLFW's own loader
+// Load a BC1/BC3/BC7 .DDS file with its mip chain. Blocks are uploaded as-is
+// when the driver supports the format, otherwise decoded on the CPU.
 GLuint loadDDS(const char* imagepath);
 
 #endif
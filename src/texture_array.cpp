@@ -0,0 +1,83 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+
+#include "texture_array.h"
+#include "bmp.h"
+#include "mipmap.h"
+#include "gl_stats.h"
+
+bool TextureArray::init(int width, int height, int capacity)
+{
+    GLint limit = 256;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &limit);
+    if (width <= 0 || height <= 0 || capacity <= 0) return false;
+    if (capacity > limit) {
+        printf("Texture array: %d layers requested, driver limit is %d\n", capacity, limit);
+        capacity = limit;
+    }
+
+    w = width;
+    h = height;
+    maxLayers = capacity;
+    count = 0;
+    levels = 1;
+    for (int d = w > h ? w : h; d > 1; d >>= 1) levels++;
+
+    glGenTextures(1, &tex);
+    glsBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+    if (GLEW_VERSION_4_2 || GLEW_ARB_texture_storage) {
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA8, w, h, maxLayers);
+    }
+    else {
+        int lw = w, lh = h;
+        for (int i = 0; i < levels; i++) {
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, i, GL_RGBA8, lw, lh, maxLayers, 0,
+                GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            lw = lw > 1 ? lw / 2 : 1;
+            lh = lh > 1 ? lh / 2 : 1;
+        }
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    return true;
+}
+
+void TextureArray::shutdown()
+{
+    if (tex) glsDeleteTextures(1, &tex);
+    tex = 0;
+    count = maxLayers = 0;
+}
+
+int TextureArray::add(const unsigned char* rgba)
+{
+    if (!tex || count >= maxLayers) return -1;
+
+    MipChain chain;
+    buildMipChain(rgba, w, h, MIP_FILTER_KAISER, chain);
+
+    glsBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (int i = 0; i < levels && i < (int)chain.levels.size(); i++) {
+        const MipLevel& L = chain.levels[i];
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, count, L.width, L.height, 1,
+            GL_RGBA, GL_UNSIGNED_BYTE, chain.level(i));
+    }
+    return count++;
+}
+
+int TextureArray::addBMP(const char* path)
+{
+    BmpImage image;
+    if (!readBMP(path, image)) return -1;
+    if ((int)image.width != w || (int)image.height != h) {
+        printf("Texture array: %s is %ux%u, expected %dx%d\n", path, image.width, image.height, w, h);
+        return -1;
+    }
+    return add(&image.rgba[0]);
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "GL/glew.h"
+
+// Same-sized RGBA images packed into one GL_TEXTURE_2D_ARRAY, so instances
+// that differ only in their texture (e.g. per-swimmer skins) can share a
+// single bind and a single instanced draw. Each add() returns the layer
+// index the shader samples with texture(sampler2DArray, vec3(uv, layer)).
+class TextureArray {
+public:
+    // Allocates storage for capacity layers (clamped to the driver limit)
+    // with a full mip chain. Leaves the array bound to GL_TEXTURE_2D_ARRAY.
+    bool init(int width, int height, int capacity);
+    void shutdown();
+
+    // rgba: width*height*4 bytes, bottom-up rows. Mips are built with the
+    // same gamma-correct filter as loadBMP_custom. Returns -1 when full.
+    int add(const unsigned char* rgba);
+    // -1 when unreadable, full, or not width x height
+    int addBMP(const char* path);
+
+    GLuint texture() const { return tex; }
+    int layers() const { return count; }
+    int capacity() const { return maxLayers; }
+    int width() const { return w; }
+    int height() const { return h; }
+
+private:
+    GLuint tex = 0;
+    int w = 0, h = 0;
+    int levels = 0;
+    int maxLayers = 0;
+    int count = 0;
+};
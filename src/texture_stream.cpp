@@ -0,0 +1,402 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "texture_stream.h"
+#include "mapped_file.h"
+#include "bmp.h"
+#include "mipmap.h"
+#include "dds.h"
+#include "frame_arena.h"
+#include "profiler.h"
+#include "gl_stats.h"
+
+struct TextureStreamer::Job {
+    int handle = 0;
+    std::string path, fallback;
+
+    // Filled by the worker
+    bool ok = false;
+    MappedFile file;                    // DDS levels point into the mapping
+    MipChain chain;                     // decoded BMP (or CPU-decoded BCn) levels
+    BCFormat format = BC_FORMAT_NONE;   // NONE = RGBA8
+    int levelCount = 0;
+    int width[DDS_MAX_LEVELS], height[DDS_MAX_LEVELS];
+    const unsigned char* data[DDS_MAX_LEVELS];
+
+    // Upload progress (GL thread)
+    GLuint tex = 0;
+    int level = 0;
+    int rowsDone = 0;                   // texel rows, or block rows when compressed
+    size_t bytes = 0;
+    unsigned int firstFrame = 0;
+};
+
+struct TextureStreamer::Upload {
+    GLuint tex;
+    BCFormat format;
+    int level, width, height;
+    int y, rows;                        // in texel rows
+    size_t offset, size;
+};
+
+static GLenum internalFormat(BCFormat f)
+{
+    switch (f) {
+    case BC_FORMAT_BC1: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    case BC_FORMAT_BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case BC_FORMAT_BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    default: return GL_RGBA8;
+    }
+}
+
+// Bytes per upload row: a row of texels, or a row of 4x4 blocks
+static size_t rowBytes(BCFormat f, int width)
+{
+    return f == BC_FORMAT_NONE ? (size_t)width * 4 : bcLevelSize(f, width, 4);
+}
+
+static int rowCount(BCFormat f, int height)
+{
+    return f == BC_FORMAT_NONE ? height : (height + 3) / 4;
+}
+
+TextureStreamer::TextureStreamer() : hasS3TC(false), hasBPTC(false)
+{
+    for (int i = 0; i < SLOT_COUNT; i++) fences[i] = 0;
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    // GL objects belong to the context; only the thread is ours to stop here
+    stopWorker();
+}
+
+bool TextureStreamer::init(size_t bytesPerFrame)
+{
+    // A slot must hold at least one row of the widest level (16384 RGBA texels)
+    budget = bytesPerFrame < (64u << 10) ? (64u << 10) : bytesPerFrame;
+    hasS3TC = GLEW_EXT_texture_compression_s3tc != 0;
+    hasBPTC = GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+
+    glGenBuffers(1, &pbo);
+    glsBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, budget * SLOT_COUNT, NULL, flags);
+        persistent = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, budget * SLOT_COUNT, flags);
+    }
+    if (!persistent)
+        glsBufferData(GL_PIXEL_UNPACK_BUFFER, budget, NULL, GL_STREAM_DRAW);
+    glsBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // Mid-grey stand-in, sampled until the real texture is complete
+    const GLuint prevTex = glStateTexture(GL_TEXTURE_2D);
+    const unsigned char grey[4] = { 128, 128, 128, 255 };
+    glGenTextures(1, &placeholder);
+    glsBindTexture(GL_TEXTURE_2D, placeholder);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glsBindTexture(GL_TEXTURE_2D, prevTex);
+
+    stopping = false;
+    worker = std::thread(&TextureStreamer::workerLoop, this);
+    return true;
+}
+
+void TextureStreamer::stopWorker()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+void TextureStreamer::shutdown()
+{
+    stopWorker();
+    pending.clear();
+    decoded.clear();
+    for (size_t i = 0; i < uploading.size(); i++)
+        if (uploading[i]->tex) glsDeleteTextures(1, &uploading[i]->tex);
+    uploading.clear();
+    for (int i = 0; i < SLOT_COUNT; i++) {
+        if (fences[i]) glDeleteSync(fences[i]);
+        fences[i] = 0;
+    }
+    if (pbo) {
+        if (persistent) {
+            glsBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glsBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+        glsDeleteBuffers(1, &pbo);
+    }
+    pbo = 0;
+    persistent = NULL;
+    if (placeholder) glsDeleteTextures(1, &placeholder);
+    placeholder = 0;
+}
+
+int TextureStreamer::request(const char* path, const char* fallbackPath)
+{
+    std::unique_ptr<Job> job(new Job);
+    job->handle = (int)textures.size();
+    job->path = path;
+    if (fallbackPath) job->fallback = fallbackPath;
+    job->firstFrame = frame;
+    textures.push_back(0);
+
+    int handle = job->handle;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        pending.push_back(std::move(job));
+    }
+    wake.notify_one();
+    return handle;
+}
+
+GLuint TextureStreamer::texture(int handle) const
+{
+    if (handle < 0 || handle >= (int)textures.size() || !textures[handle]) return placeholder;
+    return textures[handle];
+}
+
+bool TextureStreamer::ready(int handle) const
+{
+    return handle >= 0 && handle < (int)textures.size() && textures[handle] != 0;
+}
+
+bool TextureStreamer::busy() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return !pending.empty() || !decoded.empty() || !uploading.empty();
+}
+
+// ---------- Worker thread ----------
+void TextureStreamer::workerLoop()
+{
+    for (;;) {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [this] { return stopping || !pending.empty(); });
+            if (stopping) return;
+            job = std::move(pending.front());
+            pending.pop_front();
+        }
+        loadJob(*job);
+        std::lock_guard<std::mutex> guard(lock);
+        decoded.push_back(std::move(job));
+    }
+}
+
+void TextureStreamer::loadJob(Job& job)
+{
+    const char* path = job.path.c_str();
+    if (!job.file.open(path) && !job.fallback.empty()) {
+        path = job.fallback.c_str();
+        job.file.open(path);
+    }
+    printf("Reading image %s\n", path);
+    if (!job.file.isOpen()) { printf("Image could not be opened\n"); return; }
+
+    const unsigned char* bytes = job.file.data();
+    size_t size = job.file.size();
+
+    if (size >= 4 && memcmp(bytes, "DDS ", 4) == 0) {
+        DDSImage dds;
+        const char* why = "";
+        if (!parseDDS(bytes, size, dds, &why)) { printf("Not a correct DDS file (%s)\n", why); return; }
+
+        bool direct = dds.format == BC_FORMAT_BC7 ? hasBPTC.load() : hasS3TC.load();
+        int w = dds.width, h = dds.height;
+        if (!direct) {
+            // Decode into an RGBA chain; the mapping is no longer needed after this
+            printf("Compressed format not supported by the driver, decoding %s on the CPU\n", path);
+            size_t total = 0;
+            for (int i = 0; i < dds.levelCount; i++) {
+                MipLevel L = { w, h, total };
+                job.chain.levels.push_back(L);
+                total += (size_t)w * h * 4;
+                w = w > 1 ? w / 2 : 1;
+                h = h > 1 ? h / 2 : 1;
+            }
+            job.chain.data.resize(total);
+            for (int i = 0; i < dds.levelCount; i++) {
+                const MipLevel& L = job.chain.levels[i];
+                bcDecodeImage(dds.format, dds.level[i], L.width, L.height, &job.chain.data[L.offset]);
+            }
+            job.file.close();
+        }
+        else {
+            job.format = dds.format;
+            job.levelCount = dds.levelCount;
+            for (int i = 0; i < dds.levelCount; i++) {
+                job.width[i] = w;
+                job.height[i] = h;
+                job.data[i] = dds.level[i];
+                w = w > 1 ? w / 2 : 1;
+                h = h > 1 ? h / 2 : 1;
+            }
+            job.ok = true;
+            return;
+        }
+    }
+    else if (!loadMipCache(path, MIP_FILTER_KAISER, job.chain)) {
+        BmpImage image;
+        if (!decodeBMP(bytes, size, image)) return;
+        job.file.close();
+        buildMipChain(&image.rgba[0], image.width, image.height, MIP_FILTER_KAISER, job.chain);
+        if (!saveMipCache(path, job.chain)) printf("Could not write mip cache for %s\n", path);
+    }
+    job.file.close();
+
+    job.format = BC_FORMAT_NONE;
+    job.levelCount = (int)job.chain.levels.size();
+    if (job.levelCount > DDS_MAX_LEVELS) job.levelCount = DDS_MAX_LEVELS;
+    for (int i = 0; i < job.levelCount; i++) {
+        job.width[i] = job.chain.levels[i].width;
+        job.height[i] = job.chain.levels[i].height;
+        job.data[i] = job.chain.level(i);
+    }
+    job.ok = job.levelCount > 0;
+}
+
+// ---------- GL thread ----------
+void TextureStreamer::beginTexture(Job& job)
+{
+    glGenTextures(1, &job.tex);
+    glsBindTexture(GL_TEXTURE_2D, job.tex);
+    GLenum fmt = internalFormat(job.format);
+    if (GLEW_VERSION_4_2 || GLEW_ARB_texture_storage) {
+        glTexStorage2D(GL_TEXTURE_2D, job.levelCount, fmt, job.width[0], job.height[0]);
+        return;
+    }
+    for (int i = 0; i < job.levelCount; i++) {
+        if (job.format == BC_FORMAT_NONE)
+            glTexImage2D(GL_TEXTURE_2D, i, fmt, job.width[i], job.height[i], 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        else
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, fmt, job.width[i], job.height[i], 0,
+                (GLsizei)bcLevelSize(job.format, job.width[i], job.height[i]), NULL);
+    }
+}
+
+void TextureStreamer::finishTexture(Job& job)
+{
+    glsBindTexture(GL_TEXTURE_2D, job.tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, job.levelCount - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+        job.levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    textures[job.handle] = job.tex;
+    printf("Streamed %s: %zu KB over %u frames\n", job.path.c_str(), job.bytes >> 10, frame - job.firstFrame);
+}
+
+void TextureStreamer::pump()
+{
+    PROFILE_ZONE("TextureStreamer::pump");
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        while (!decoded.empty()) {
+            if (decoded.front()->ok) uploading.push_back(std::move(decoded.front()));
+            decoded.pop_front();
+        }
+    }
+    if (uploading.empty()) return;
+
+    // Never wait on the GPU: if this slot is still being read, try next frame
+    const int slot = persistent ? (int)(frame % SLOT_COUNT) : 0;
+    if (fences[slot]) {
+        if (glClientWaitSync(fences[slot], 0, 0) == GL_TIMEOUT_EXPIRED) return;
+        glDeleteSync(fences[slot]);
+        fences[slot] = 0;
+    }
+    frame++;
+
+    const GLuint prevTex = glStateTexture(GL_TEXTURE_2D);
+    for (size_t i = 0; i < uploading.size(); i++)
+        if (!uploading[i]->tex) beginTexture(*uploading[i]);
+
+    glsBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    const size_t base = (size_t)slot * budget;
+    unsigned char* dst = persistent;
+    if (!dst)
+        dst = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, budget,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!dst) {
+        glsBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glsBindTexture(GL_TEXTURE_2D, prevTex);
+        return;
+    }
+
+    // Copy whole rows into the slot until the budget is spent. Scratch for
+    // this frame only: from the GL thread's frame arena.
+    ArenaVector<Upload> ops(frameArena());
+    ArenaVector<size_t> finished(frameArena());
+    finished.reserve(uploading.size());
+    size_t used = 0;
+    for (size_t j = 0; j < uploading.size() && used < budget; j++) {
+        Job& job = *uploading[j];
+        while (job.level < job.levelCount && used < budget) {
+            const int w = job.width[job.level], h = job.height[job.level];
+            const size_t rb = rowBytes(job.format, w);
+            const int rows = rowCount(job.format, h);
+            int n = (int)((budget - used) / rb);
+            if (n <= 0) break;
+            if (n > rows - job.rowsDone) n = rows - job.rowsDone;
+
+            memcpy(dst + base + used, job.data[job.level] + job.rowsDone * rb, n * rb);
+            Upload op;
+            op.tex = job.tex;
+            op.format = job.format;
+            op.level = job.level;
+            op.width = w;
+            op.height = h;
+            op.y = job.format == BC_FORMAT_NONE ? job.rowsDone : job.rowsDone * 4;
+            op.rows = job.format == BC_FORMAT_NONE ? n : (op.y + n * 4 > h ? h - op.y : n * 4);
+            op.offset = base + used;
+            op.size = n * rb;
+            ops.push_back(op);
+
+            used += n * rb;
+            job.bytes += n * rb;
+            job.rowsDone += n;
+            if (job.rowsDone == rows) {
+                job.level++;
+                job.rowsDone = 0;
+            }
+        }
+        if (job.level == job.levelCount) finished.push_back(j);
+    }
+    if (!persistent) glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (size_t i = 0; i < ops.size(); i++) {
+        const Upload& op = ops[i];
+        glsBindTexture(GL_TEXTURE_2D, op.tex);
+        if (op.format == BC_FORMAT_NONE)
+            glTexSubImage2D(GL_TEXTURE_2D, op.level, 0, op.y, op.width, op.rows,
+                GL_RGBA, GL_UNSIGNED_BYTE, (const GLvoid*)op.offset);
+        else
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, op.level, 0, op.y, op.width, op.rows,
+                internalFormat(op.format), (GLsizei)op.size, (const GLvoid*)op.offset);
+    }
+    glsBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (persistent && !ops.empty())
+        fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    for (size_t i = finished.size(); i-- > 0; ) {
+        finishTexture(*uploading[finished[i]]);
+        uploading.erase(uploading.begin() + finished[i]);
+    }
+    glsBindTexture(GL_TEXTURE_2D, prevTex);
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "GL/glew.h"
+
+// Asynchronous texture loading.
+//
+// request() returns at once. A worker thread memory-maps the file and either
+// decodes it (BMP -> RGBA mip chain, through the .mips cache) or validates it
+// (DDS, levels stay in the mapping). pump(), called once per frame on the GL
+// thread, copies at most bytesPerFrame into a staging PBO and issues the
+// matching glTexSubImage2D calls. texture() returns a 1x1 placeholder until
+// the last level has been uploaded.
+//
+// With GL_ARB_buffer_storage the staging buffer is persistently mapped and
+// split into per-frame slots guarded by fences; a slot the GPU is still
+// reading is skipped for a frame rather than waited on. Otherwise the buffer
+// is orphaned and re-mapped each frame.
+class TextureStreamer {
+public:
+    TextureStreamer();
+    ~TextureStreamer();
+
+    bool init(size_t bytesPerFrame = 1 << 20);
+    void shutdown();
+
+    // fallbackPath is tried when path cannot be opened (e.g. a missing .dds)
+    int request(const char* path, const char* fallbackPath = NULL);
+    void pump();
+
+    GLuint texture(int handle) const;
+    bool ready(int handle) const;
+    bool busy() const;
+
+private:
+    struct Job;
+    struct Upload;
+    enum { SLOT_COUNT = 3 };
+
+    void workerLoop();
+    void loadJob(Job& job);
+    void beginTexture(Job& job);
+    void finishTexture(Job& job);
+    void stopWorker();
+
+    size_t budget = 0;
+    GLuint pbo = 0;
+    unsigned char* persistent = NULL;   // non-NULL when persistently mapped
+    GLsync fences[SLOT_COUNT];
+    unsigned int frame = 0;
+    GLuint placeholder = 0;
+
+    std::vector<GLuint> textures;       // by handle; 0 while streaming
+    std::deque<std::unique_ptr<Job> > uploading;
+
+    std::thread worker;
+    mutable std::mutex lock;
+    std::condition_variable wake;
+    std::deque<std::unique_ptr<Job> > pending;
+    std::deque<std::unique_ptr<Job> > decoded;
+    bool stopping = false;
+
+    // Driver caps, read by the worker to decide on CPU BCn decoding
+    std::atomic<bool> hasS3TC;
+    std::atomic<bool> hasBPTC;
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+
+// Lock-free single-producer / single-consumer triple buffer. The producer
+// fills writeSlot() and publish()es it; the consumer acquire()s the newest
+// published slot and reads readSlot() for as long as it likes. Each side owns
+// one slot and the third sits in the middle, so neither ever waits for the
+// other: a fast producer overwrites snapshots the consumer never saw, a
+// fast consumer keeps reading the last one. Slots are reused, never copied,
+// so a T holding vectors keeps its capacity from one round to the next.
+template<class T>
+class TripleBuffer {
+public:
+    TripleBuffer() : shared(MIDDLE_INIT) {}
+
+    // Producer
+    T& writeSlot() { return slots[writeIndex]; }
+    void publish()
+    {
+        // release: the slot's contents before the index; acquire: we take
+        // back whichever slot the consumer last released
+        writeIndex = shared.exchange(writeIndex | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Consumer: true when a newer slot was published since the last call
+    bool acquire()
+    {
+        if (!(shared.load(std::memory_order_relaxed) & FRESH)) return false;
+        readIndex = shared.exchange(readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+    const T& readSlot() const { return slots[readIndex]; }
+
+private:
+    enum { INDEX_MASK = 3, FRESH = 4, MIDDLE_INIT = 2 };
+
+    T slots[3];
+    unsigned writeIndex = 0;        // producer only
+    unsigned readIndex = 1;         // consumer only
+    std::atomic<unsigned> shared;   // the middle slot, FRESH when unread
+};
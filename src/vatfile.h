@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Vertex animation texture (.vat, little endian): one loop of a clip baked to
+// per-vertex positions and normals for a mesh, identified by the mesh's
+// .mesh sourceKey and vertex count.
+//
+//   VATFileHeader | position texture | normal texture
+//
+// Both textures are vertexCount x frameCount texels: column = vertex, row =
+// frame, frame 0 first. Frame k is the pose at cycle position k / frameCount;
+// playback interpolates and wraps to frame 0. Storage by format:
+//   VAT_FLOAT32  positions and normals RGBA32F
+//   VAT_FLOAT16  positions and normals RGBA16F
+//   VAT_UNORM16  positions RGBA16 normalized inside the bounds of the clip,
+//                normals GL_UNSIGNED_INT_2_10_10_10_REV holding n * 0.5 + 0.5
+// Positions decode as texel * posScale + posBias (identity for the float
+// formats); normals are renormalized after interpolation.
+
+enum { VAT_FILE_VERSION = 1, VAT_MAX_VERTICES = 8192, VAT_MAX_FRAMES = 4096 };
+
+enum VATFormat { VAT_FLOAT32, VAT_FLOAT16, VAT_UNORM16, VAT_FORMAT_COUNT };
+
+struct VATFileHeader {
+    char     magic[4];                  // "VAT "
+    uint32_t version;                   // VAT_FILE_VERSION
+    uint32_t format;                    // VATFormat
+    uint32_t meshKey;                   // sourceKey of the .mesh
+    uint32_t vertexCount;               // texture width
+    uint32_t frameCount;                // texture height
+    float    posScale[3], posBias[3];
+    uint64_t positionOffset, normalOffset;
+};
+
+inline size_t vatPositionTexelBytes(uint32_t format)
+{
+    return format == VAT_FLOAT32 ? 16 : 8;
+}
+
+inline size_t vatNormalTexelBytes(uint32_t format)
+{
+    return format == VAT_FLOAT32 ? 16 : format == VAT_FLOAT16 ? 8 : 4;
+}
+
+// Check the header against the file size. Returns false for anything malformed.
+inline bool vatValidateHeader(const VATFileHeader& h, size_t fileSize)
+{
+    if (memcmp(h.magic, "VAT ", 4) != 0 || h.version != VAT_FILE_VERSION) return false;
+    if (h.format >= VAT_FORMAT_COUNT) return false;
+    if (h.vertexCount < 1 || h.vertexCount > VAT_MAX_VERTICES) return false;
+    if (h.frameCount < 2 || h.frameCount > VAT_MAX_FRAMES) return false;
+    uint64_t texels = (uint64_t)h.vertexCount * h.frameCount;
+    return h.positionOffset >= sizeof(VATFileHeader) && h.positionOffset <= fileSize &&
+           texels * vatPositionTexelBytes(h.format) <= fileSize - h.positionOffset &&
+           h.normalOffset >= sizeof(VATFileHeader) && h.normalOffset <= fileSize &&
+           texels * vatNormalTexelBytes(h.format) <= fileSize - h.normalOffset;
+}
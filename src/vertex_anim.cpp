@@ -0,0 +1,92 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "vertex_anim.h"
+#include <stdio.h>
+#include "mapped_file.h"
+#include "gl_stats.h"
+
+static GLuint makeTexture(GLint internalFormat, GLenum type, const VATFileHeader& h, const unsigned char* data)
+{
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glsBindTexture(GL_TEXTURE_2D, tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, h.vertexCount, h.frameCount, 0, GL_RGBA, type, data);
+    return tex;
+}
+
+bool VertexAnimTexture::load(const char* path, uint32_t meshKey, uint32_t vertexCount, int positionUnit)
+{
+    shutdown();
+    MappedFile file;
+    if (!file.open(path)) {
+        printf("VAT: cannot open %s\n", path);
+        return false;
+    }
+    if (file.size() < sizeof(h)) {
+        printf("VAT: %s is too small\n", path);
+        return false;
+    }
+    memcpy(&h, file.data(), sizeof(h));
+    if (!vatValidateHeader(h, file.size())) {
+        printf("VAT: %s is not a valid .vat file\n", path);
+        return false;
+    }
+    if (h.meshKey != meshKey || h.vertexCount != vertexCount) {
+        printf("VAT: %s was baked for another mesh (%u vertices, expected %u); rebake it\n",
+               path, h.vertexCount, vertexCount);
+        return false;
+    }
+
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    if ((GLint)h.vertexCount > maxSize || (GLint)h.frameCount > maxSize) {
+        printf("VAT: %u x %u exceeds GL_MAX_TEXTURE_SIZE %d\n", h.vertexCount, h.frameCount, maxSize);
+        return false;
+    }
+
+    const unsigned char* pos = file.data() + h.positionOffset;
+    const unsigned char* nrm = file.data() + h.normalOffset;
+    unit = positionUnit;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glsActiveTexture(GL_TEXTURE0 + unit);
+    switch (h.format) {
+    case VAT_FLOAT32: positions = makeTexture(GL_RGBA32F, GL_FLOAT, h, pos); break;
+    case VAT_FLOAT16: positions = makeTexture(GL_RGBA16F, GL_HALF_FLOAT, h, pos); break;
+    default:          positions = makeTexture(GL_RGBA16, GL_UNSIGNED_SHORT, h, pos); break;
+    }
+    glsActiveTexture(GL_TEXTURE0 + unit + 1);
+    switch (h.format) {
+    case VAT_FLOAT32: normals = makeTexture(GL_RGBA32F, GL_FLOAT, h, nrm); break;
+    case VAT_FLOAT16: normals = makeTexture(GL_RGBA16F, GL_HALF_FLOAT, h, nrm); break;
+    default:          normals = makeTexture(GL_RGB10_A2, GL_UNSIGNED_INT_2_10_10_10_REV, h, nrm); break;
+    }
+    glsActiveTexture(GL_TEXTURE0);
+
+    static const char* const formatName[VAT_FORMAT_COUNT] = { "float32", "float16", "unorm16" };
+    printf("VAT: %s, %u vertices x %u frames, %s, %.1f KB\n", path, h.vertexCount, h.frameCount,
+           formatName[h.format], (double)h.vertexCount * h.frameCount *
+           (vatPositionTexelBytes(h.format) + vatNormalTexelBytes(h.format)) / 1024.0);
+    return true;
+}
+
+void VertexAnimTexture::shutdown()
+{
+    if (positions) glsDeleteTextures(1, &positions);
+    if (normals) glsDeleteTextures(1, &normals);
+    positions = normals = 0;
+}
+
+void VertexAnimTexture::setUniforms(GLuint program) const
+{
+    const bool unorm = h.format == VAT_UNORM16;
+    glsUniform1i(glGetUniformLocation(program, "vatPositions"), unit);
+    glsUniform1i(glGetUniformLocation(program, "vatNormals"), unit + 1);
+    glsUniform1i(glGetUniformLocation(program, "vatFrames"), (GLint)h.frameCount);
+    glsUniform3fv(glGetUniformLocation(program, "vatPosScale"), 1, h.posScale);
+    glsUniform3fv(glGetUniformLocation(program, "vatPosBias"), 1, h.posBias);
+    glsUniform2f(glGetUniformLocation(program, "vatNormalDecode"), unorm ? 2.0f : 1.0f, unorm ? -1.0f : 0.0f);
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+#include "GL/glew.h"
+#include "vatfile.h"
+
+// Playback of a baked vertex animation texture (tools/vatbake, src/vatfile.h).
+// Both textures are uploaded once; an instance then needs only its phase and
+// cycle length, which the vertex shader's VAT path turns into two frame rows
+// to fetch and blend by gl_VertexID.
+class VertexAnimTexture {
+public:
+    VertexAnimTexture() {}
+    ~VertexAnimTexture() { shutdown(); }
+
+    // The file must have been baked from the mesh with this sourceKey and
+    // vertex count. Positions go to positionUnit, normals to positionUnit + 1.
+    bool load(const char* path, uint32_t meshKey, uint32_t vertexCount, int positionUnit);
+    void shutdown();
+
+    // Set the vat* uniforms of a program using the VAT path of vshader.glsl
+    void setUniforms(GLuint program) const;
+
+    bool loaded() const { return positions != 0; }
+    const VATFileHeader& header() const { return h; }
+
+private:
+    VertexAnimTexture(const VertexAnimTexture&);
+    VertexAnimTexture& operator=(const VertexAnimTexture&);
+
+    GLuint positions = 0, normals = 0;
+    int unit = 0;
+    VATFileHeader h;
+};
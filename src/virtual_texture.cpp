@@ -0,0 +1,468 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <functional>
+
+#include "cube.h"
+#include "virtual_texture.h"
+#include "profiler.h"
+#include "gl_stats.h"
+
+static const unsigned int PINNED = ~0u;
+static const uint32_t NO_PAGE = ~0u;
+
+static inline int pageLevel(uint32_t page) { return (int)(page >> 24); }
+static inline uint32_t pageY(uint32_t page) { return (page >> 12) & 0xFFF; }
+static inline uint32_t pageX(uint32_t page) { return page & 0xFFF; }
+
+// Page table texel: cache x, cache y, resident level (read as R, G, B * 255)
+static inline uint32_t packEntry(int slotX, int slotY, int level)
+{
+    return (uint32_t)slotX | (uint32_t)slotY << 8 | (uint32_t)level << 16 | 0xFF000000u;
+}
+
+VirtualTexture::VirtualTexture()
+{
+    memset(&header, 0, sizeof(header));
+    for (int i = 0; i < READBACK_COUNT; i++) {
+        readback[i] = 0;
+        readFence[i] = 0;
+        readWidth[i] = readHeight[i] = 0;
+    }
+}
+
+VirtualTexture::~VirtualTexture()
+{
+    stopWorker();
+}
+
+bool VirtualTexture::init(const char* path, const VTSettings& s, GLuint mainProgram, int pageTableUnit)
+{
+    settings = s;
+    if (settings.cacheSide < 2) settings.cacheSide = 2;
+    if (settings.cacheSide > 255) settings.cacheSide = 255;     // slot coordinates are 8-bit
+    if (settings.feedbackDivisor < 1) settings.feedbackDivisor = 1;
+    if (settings.uploadsPerFrame < 1) settings.uploadsPerFrame = 1;
+    if (settings.maxInFlight < 1) settings.maxInFlight = 1;
+    batch.reserve(settings.uploadsPerFrame);
+
+    if (!file.open(path)) { printf("Virtual texture %s could not be opened\n", path); return false; }
+    if (file.size() < sizeof(VTFileHeader)) { printf("Not a correct VTEX file\n"); file.close(); return false; }
+    memcpy(&header, file.data(), sizeof(header));
+    // Feedback encodes tile coordinates in 11 bits
+    if (!vtValidateHeader(header, file.size()) || vtTilesPerSide(header, 0) > 2048) {
+        printf("Not a correct VTEX file\n");
+        file.close();
+        return false;
+    }
+    pageSide = header.tileSize + 2 * header.border;
+    unit = pageTableUnit;
+
+    const int levels = (int)header.levelCount;
+    slotOf.assign(levels, std::vector<int>());
+    queued.assign(levels, std::vector<unsigned char>());
+    table.assign(levels, std::vector<uint32_t>());
+    for (int L = 0; L < levels; L++) {
+        size_t n = (size_t)vtTilesPerSide(header, L) * vtTilesPerSide(header, L);
+        slotOf[L].assign(n, -1);
+        queued[L].assign(n, 0);
+        table[L].assign(n, 0);
+    }
+    const int slots = settings.cacheSide * settings.cacheSide;
+    slotPage.assign(slots, NO_PAGE);
+    slotUsed.assign(slots, 0);
+
+    const GLenum prevActive = glStateActiveTexture();
+    const GLuint prevProgram = glStateProgram();
+
+    // Page table: one mip level per pyramid level, point sampled
+    glsActiveTexture(GL_TEXTURE0 + unit);
+    glGenTextures(1, &pageTable);
+    glsBindTexture(GL_TEXTURE_2D, pageTable);
+    for (int L = 0; L < levels; L++) {
+        int t = (int)vtTilesPerSide(header, L);
+        glTexImage2D(GL_TEXTURE_2D, L, GL_RGBA8, t, t, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    // Physical cache: bilinear within a page, borders make it seamless
+    glsActiveTexture(GL_TEXTURE0 + unit + 1);
+    glGenTextures(1, &cache);
+    glsBindTexture(GL_TEXTURE_2D, cache);
+    const int cacheTexels = settings.cacheSide * pageSide;
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, cacheTexels, cacheTexels, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // The single top tile is always resident, so every lookup has a fallback
+    const uint32_t top = pageId(levels - 1, 0, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, pageSide, pageSide, GL_RGBA, GL_UNSIGNED_BYTE,
+        file.data() + vtTileOffset(header, levels - 1, 0, 0));
+    slotPage[0] = top;
+    slotUsed[0] = PINNED;
+    slotOf[levels - 1][0] = 0;
+    stat.resident = 1;
+    rebuildPageTable();
+    glsActiveTexture(prevActive);
+
+    // Feedback program: the scene vertex shader, so attribute slots must match
+    program = InitShader("src/vshader.glsl", "src/vt_feedback_fshader.glsl");
+    static const char* const attribs[] = {
+        "vPosition", "vNormal", "vColor", "vTexCoord", "vBone", "vSkinLayer", "vInstanceOffset", "vInstancePhase"
+    };
+    for (size_t i = 0; i < sizeof(attribs) / sizeof(attribs[0]); i++) {
+        GLint loc = glGetAttribLocation(mainProgram, attribs[i]);
+        if (loc >= 0) glBindAttribLocation(program, loc, attribs[i]);
+    }
+    glLinkProgram(program);
+    projectLoc = glGetUniformLocation(program, "mProject");
+    viewLoc = glGetUniformLocation(program, "mView");
+    modelLoc = glGetUniformLocation(program, "mModel");
+    setUniforms(program);
+    glsUseProgram(program);
+    glsUniform1f(glGetUniformLocation(program, "vtFeedbackBias"),
+        -log2f((float)settings.feedbackDivisor));
+    glsUseProgram(prevProgram);
+
+    glGenBuffers(READBACK_COUNT, readback);
+
+    stopping = false;
+    worker = std::thread(&VirtualTexture::workerLoop, this);
+
+    printf("Virtual texture %s: %ux%u, %u levels, %u-texel tiles, %.1f MB GPU\n", path,
+        header.width, header.width, header.levelCount, header.tileSize, gpuBytes() / 1048576.0);
+    return true;
+}
+
+void VirtualTexture::stopWorker()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+void VirtualTexture::shutdown()
+{
+    stopWorker();
+    queue.clear();
+    loaded.clear();
+    for (int i = 0; i < READBACK_COUNT; i++) {
+        if (readFence[i]) glDeleteSync(readFence[i]);
+        readFence[i] = 0;
+    }
+    glsDeleteBuffers(READBACK_COUNT, readback);
+    if (fbo) glsDeleteFramebuffers(1, &fbo);
+    if (fbColor) glDeleteRenderbuffers(1, &fbColor);
+    if (fbDepth) glDeleteRenderbuffers(1, &fbDepth);
+    if (pageTable) glsDeleteTextures(1, &pageTable);
+    if (cache) glsDeleteTextures(1, &cache);
+    if (program) glDeleteProgram(program);
+    fbo = fbColor = fbDepth = pageTable = cache = program = 0;
+    fbWidth = fbHeight = 0;
+    file.close();
+}
+
+void VirtualTexture::setUniforms(GLuint prog) const
+{
+    const GLuint prevProgram = glStateProgram();
+    glsUseProgram(prog);
+    const float cacheTexels = (float)(settings.cacheSide * pageSide);
+    glsUniform1i(glGetUniformLocation(prog, "vtPageTable"), unit);
+    glsUniform1i(glGetUniformLocation(prog, "vtCache"), unit + 1);
+    glsUniform1f(glGetUniformLocation(prog, "vtTiles"), (float)vtTilesPerSide(header, 0));
+    glsUniform1f(glGetUniformLocation(prog, "vtVirtualSize"), (float)header.width);
+    glsUniform1f(glGetUniformLocation(prog, "vtMaxLevel"), (float)(header.levelCount - 1));
+    glsUniform3f(glGetUniformLocation(prog, "vtPageScale"), pageSide / cacheTexels,
+        header.border / cacheTexels, header.tileSize / cacheTexels);
+    glsUseProgram(prevProgram);
+}
+
+void VirtualTexture::resetStats()
+{
+    VTStats s;
+    s.requested = stat.requested;
+    s.resident = stat.resident;
+    stat = s;
+}
+
+size_t VirtualTexture::gpuBytes() const
+{
+    size_t cacheTexels = (size_t)settings.cacheSide * pageSide;
+    size_t bytes = cacheTexels * cacheTexels * 4;
+    for (size_t L = 0; L < table.size(); L++) bytes += table[L].size() * 4;
+    bytes += (size_t)fbWidth * fbHeight * 8 * (1 + READBACK_COUNT);
+    return bytes;
+}
+
+// ---------- Worker thread ----------
+void VirtualTexture::workerLoop()
+{
+    const size_t tileBytes = vtTileBytes(header);
+    for (;;) {
+        uint32_t page;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [this] { return stopping || !queue.empty(); });
+            if (stopping) return;
+            page = queue.front();
+            queue.pop_front();
+        }
+        // Page faults on the mapping happen here, off the GL thread
+        Loaded tile;
+        tile.page = page;
+        const unsigned char* src = file.data() + vtTileOffset(header, pageLevel(page), pageX(page), pageY(page));
+        tile.texels.assign(src, src + tileBytes);
+
+        std::lock_guard<std::mutex> guard(lock);
+        loaded.push_back(std::move(tile));
+    }
+}
+
+// ---------- GL thread ----------
+void VirtualTexture::update(const glm::mat4& project, const glm::mat4& view, VTDrawFn draw)
+{
+    PROFILE_GPU_ZONE("VirtualTexture::update");
+    frame++;
+    if (project != lastProject || view != lastView) {
+        changedFrame = frame;
+        lastProject = project;
+        lastView = view;
+    }
+
+    const GLuint prevProgram = glStateProgram(), prevFbo = glStateDrawFramebuffer();
+    GLint viewport[4];
+    GLfloat prevClear[4];
+    glStateViewport(viewport);
+    glStateClearColor(prevClear);
+
+    int w = viewport[2] / settings.feedbackDivisor, h = viewport[3] / settings.feedbackDivisor;
+    if (w < 1) w = 1;
+    if (h < 1) h = 1;
+    if (w != fbWidth || h != fbHeight) {
+        if (!fbo) {
+            glGenFramebuffers(1, &fbo);
+            glGenRenderbuffers(1, &fbColor);
+            glGenRenderbuffers(1, &fbDepth);
+        }
+        glBindRenderbuffer(GL_RENDERBUFFER, fbColor);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+        glBindRenderbuffer(GL_RENDERBUFFER, fbDepth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glsBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, fbColor);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, fbDepth);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cerr << "Virtual texture feedback target is incomplete" << std::endl;
+        fbWidth = w;
+        fbHeight = h;
+    }
+
+    // 1. Feedback pass
+    glsBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glsViewport(0, 0, w, h);
+    glsClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glsUseProgram(program);
+    glsUniformMatrix4fv(projectLoc, 1, GL_FALSE, &project[0][0]);
+    glsUniformMatrix4fv(viewLoc, 1, GL_FALSE, &view[0][0]);
+    draw(modelLoc);
+
+    // 2. Queue the read-back; it is consumed READBACK_COUNT - 1 frames later
+    const int slot = (int)(frame % READBACK_COUNT);
+    if (readFence[slot]) glDeleteSync(readFence[slot]);
+    glsBindBuffer(GL_PIXEL_PACK_BUFFER, readback[slot]);
+    if (readWidth[slot] != w || readHeight[slot] != h) {
+        glsBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)w * h * 4, NULL, GL_STREAM_READ);
+        readWidth[slot] = w;
+        readHeight[slot] = h;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, BUFFER_OFFSET(0));
+    readFence[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glsBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    glsBindFramebuffer(GL_FRAMEBUFFER, prevFbo);
+    glsViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glsClearColor(prevClear[0], prevClear[1], prevClear[2], prevClear[3]);
+    glsUseProgram(prevProgram);
+
+    // 3./4. Residency
+    readFeedback();
+    uploadLoaded();
+    if (tableDirty) rebuildPageTable();
+}
+
+void VirtualTexture::readFeedback()
+{
+    const int slot = (int)((frame + 1) % READBACK_COUNT);     // oldest in the ring
+    if (!readFence[slot]) return;
+    if (glClientWaitSync(readFence[slot], 0, 0) == GL_TIMEOUT_EXPIRED) return;
+    glDeleteSync(readFence[slot]);
+    readFence[slot] = 0;
+
+    glsBindBuffer(GL_PIXEL_PACK_BUFFER, readback[slot]);
+    const size_t bytes = (size_t)readWidth[slot] * readHeight[slot] * 4;
+    const unsigned char* px = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+    wanted.clear();
+    if (px) {
+        const int levels = (int)header.levelCount;
+        uint32_t last = NO_PAGE;
+        for (size_t i = 0; i < bytes; i += 4) {
+            // R, G: tile x/y low bits, B: level, A: 0x80 | y high << 3 | x high
+            const unsigned char a = px[i + 3];
+            if (!(a & 0x80)) continue;
+            uint32_t x = px[i] | (uint32_t)(a & 7) << 8;
+            uint32_t y = px[i + 1] | (uint32_t)((a >> 3) & 7) << 8;
+            int level = px[i + 2];
+            if (level >= levels || x >= vtTilesPerSide(header, level) || y >= vtTilesPerSide(header, level))
+                continue;
+            uint32_t page = pageId(level, x, y);
+            if (page != last) wanted.push_back(page);   // neighbouring pixels mostly agree
+            last = page;
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glsBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // Parents too, so coarser fallbacks arrive first while zooming in
+    const size_t direct = wanted.size();
+    for (size_t i = 0; i < direct; i++) {
+        uint32_t p = wanted[i];
+        for (int L = pageLevel(p) + 1; L < (int)header.levelCount; L++)
+            wanted.push_back(pageId(L, pageX(p) >> (L - pageLevel(p)), pageY(p) >> (L - pageLevel(p))));
+    }
+    // Coarse first: the level sits in the top bits of the id
+    std::sort(wanted.begin(), wanted.end(), std::greater<uint32_t>());
+    wanted.erase(std::unique(wanted.begin(), wanted.end()), wanted.end());
+    stat.requested = (int)wanted.size();
+
+    for (size_t i = 0; i < wanted.size(); i++) {
+        uint32_t p = wanted[i];
+        const size_t idx = (size_t)pageY(p) * vtTilesPerSide(header, pageLevel(p)) + pageX(p);
+        int s = slotOf[pageLevel(p)][idx];
+        if (s >= 0) {
+            if (slotUsed[s] != PINNED) slotUsed[s] = frame;
+        }
+        else {
+            stat.misses++;
+            changedFrame = frame;
+            request(p);
+        }
+    }
+}
+
+void VirtualTexture::request(uint32_t page)
+{
+    const size_t idx = (size_t)pageY(page) * vtTilesPerSide(header, pageLevel(page)) + pageX(page);
+    unsigned char& q = queued[pageLevel(page)][idx];
+    if (q || inFlight >= settings.maxInFlight) return;
+    q = 1;
+    inFlight++;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        queue.push_back(page);
+    }
+    wake.notify_one();
+}
+
+// Free slot, else the least recently wanted one not wanted this frame
+int VirtualTexture::takeSlot()
+{
+    int best = -1;
+    for (int s = 0; s < (int)slotPage.size(); s++) {
+        if (slotPage[s] == NO_PAGE) return s;
+        if (slotUsed[s] == PINNED || slotUsed[s] >= frame) continue;
+        if (best < 0 || slotUsed[s] < slotUsed[best]) best = s;
+    }
+    return best;
+}
+
+void VirtualTexture::uploadLoaded()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (int i = 0; i < settings.uploadsPerFrame && !loaded.empty(); i++) {
+            batch.push_back(std::move(loaded.front()));
+            loaded.pop_front();
+        }
+    }
+    if (batch.empty()) return;
+
+    const GLenum prevActive = glStateActiveTexture();
+    glsActiveTexture(GL_TEXTURE0 + unit + 1);
+    glsBindTexture(GL_TEXTURE_2D, cache);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    for (size_t i = 0; i < batch.size(); i++) {
+        const uint32_t page = batch[i].page;
+        const int level = pageLevel(page);
+        const size_t idx = (size_t)pageY(page) * vtTilesPerSide(header, level) + pageX(page);
+        queued[level][idx] = 0;
+        inFlight--;
+
+        // The cache is full of pages wanted this frame: drop it, feedback asks again
+        int s = takeSlot();
+        if (s < 0) continue;
+        if (slotPage[s] != NO_PAGE) {
+            uint32_t old = slotPage[s];
+            slotOf[pageLevel(old)][(size_t)pageY(old) * vtTilesPerSide(header, pageLevel(old)) + pageX(old)] = -1;
+            stat.evictions++;
+        }
+        else stat.resident++;
+
+        const int sx = s % settings.cacheSide, sy = s / settings.cacheSide;
+        glTexSubImage2D(GL_TEXTURE_2D, 0, sx * pageSide, sy * pageSide, pageSide, pageSide,
+            GL_RGBA, GL_UNSIGNED_BYTE, &batch[i].texels[0]);
+        slotPage[s] = page;
+        slotUsed[s] = frame;
+        slotOf[level][idx] = s;
+        stat.uploads++;
+        tableDirty = true;
+    }
+    glsActiveTexture(prevActive);
+    batch.clear();
+}
+
+// Every tile points at its finest resident ancestor (itself when resident)
+void VirtualTexture::rebuildPageTable()
+{
+    const int levels = (int)header.levelCount;
+    const GLenum prevActive = glStateActiveTexture();
+    glsActiveTexture(GL_TEXTURE0 + unit);
+    glsBindTexture(GL_TEXTURE_2D, pageTable);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    for (int L = levels - 1; L >= 0; L--) {
+        const uint32_t t = vtTilesPerSide(header, L);
+        const uint32_t pt = L + 1 < levels ? vtTilesPerSide(header, L + 1) : 0;
+        std::vector<uint32_t>& dst = table[L];
+        for (uint32_t y = 0; y < t; y++) {
+            for (uint32_t x = 0; x < t; x++) {
+                int s = slotOf[L][(size_t)y * t + x];
+                if (s >= 0)
+                    dst[(size_t)y * t + x] = packEntry(s % settings.cacheSide, s / settings.cacheSide, L);
+                else if (pt)
+                    dst[(size_t)y * t + x] = table[L + 1][(size_t)(y >> 1) * pt + (x >> 1)];
+            }
+        }
+        glTexSubImage2D(GL_TEXTURE_2D, L, 0, 0, t, t, GL_RGBA, GL_UNSIGNED_BYTE, &dst[0]);
+    }
+    glsActiveTexture(prevActive);
+    tableDirty = false;
+}
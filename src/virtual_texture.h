@@ -0,0 +1,126 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "GL/glew.h"
+#include "glm/glm.hpp"
+#include "mapped_file.h"
+#include "vtfile.h"
+
+// Virtual texturing over a memory-mapped .vtex tile pyramid (tools/vtbake).
+//
+// GPU memory is fixed at init: a physical page cache of cacheSide x
+// cacheSide tiles, a mipmapped page table (one RGBA8 texel per tile:
+// cache x, cache y, resident level) and a small feedback target. Each frame
+//   1. the VT geometry is drawn at low resolution with vt_feedback_fshader,
+//      which writes the tile every pixel wants;
+//   2. that image is read back through a PBO a few frames later (no stall);
+//   3. missing tiles (and their parents) go to a worker thread, which copies
+//      them out of the mapping, touching the file only where needed;
+//   4. loaded tiles are uploaded under a per-frame limit, evicting the least
+//      recently wanted cache page; the page table is then rebuilt so every
+//      tile points at its finest resident ancestor.
+// The single top-level tile is pinned, so sampling never misses.
+
+// Draw everything that samples the virtual texture; modelLoc is the
+// model-matrix uniform of the feedback program.
+typedef void (*VTDrawFn)(GLint modelLoc);
+
+struct VTSettings {
+    int   cacheSide = 16;           // physical cache is cacheSide^2 pages
+    int   feedbackDivisor = 8;      // feedback target = viewport / divisor
+    int   uploadsPerFrame = 8;      // tile uploads per frame
+    int   maxInFlight = 64;         // tiles queued on the worker
+};
+
+struct VTStats {
+    int requested = 0;              // distinct tiles wanted by the last feedback
+    int resident = 0;
+    int uploads = 0;                // since the last resetStats()
+    int evictions = 0;
+    int misses = 0;                 // wanted but not resident, at read-back time
+};
+
+class VirtualTexture {
+public:
+    VirtualTexture();
+    ~VirtualTexture();
+
+    // mainProgram supplies the attribute slots (the feedback program reuses
+    // vshader.glsl and must match the scene VAOs). The page table and the
+    // cache are bound to units pageTableUnit and pageTableUnit + 1.
+    bool init(const char* path, const VTSettings& settings, GLuint mainProgram, int pageTableUnit);
+    void shutdown();
+
+    // Set the sampling uniforms of a program using sampleVirtual() in fshader.glsl
+    void setUniforms(GLuint program) const;
+
+    // Feedback pass + residency update. Restores FBO 0, viewport and program.
+    void update(const glm::mat4& project, const glm::mat4& view, VTDrawFn draw);
+
+    // Frames are still needed to converge: tiles in flight, or feedback from
+    // a recent view change or miss not read back yet. Renderers that only
+    // draw on change keep drawing while this holds.
+    bool settling() const { return inFlight > 0 || frame - changedFrame < READBACK_COUNT; }
+
+    const VTStats& stats() const { return stat; }
+    void resetStats();
+    size_t gpuBytes() const;
+
+private:
+    struct Loaded {
+        uint32_t page;
+        std::vector<unsigned char> texels;
+    };
+    enum { READBACK_COUNT = 3 };
+
+    static uint32_t pageId(int level, uint32_t x, uint32_t y) { return (uint32_t)level << 24 | y << 12 | x; }
+
+    void workerLoop();
+    void readFeedback();
+    void request(uint32_t page);
+    void uploadLoaded();
+    int  takeSlot();
+    void rebuildPageTable();
+    void stopWorker();
+
+    VTSettings settings;
+    MappedFile file;
+    VTFileHeader header;
+    int pageSide = 0;                   // tileSize + 2 * border
+    int unit = 0;
+
+    GLuint pageTable = 0, cache = 0;
+    GLuint program = 0;
+    GLint  projectLoc = -1, viewLoc = -1, modelLoc = -1;
+    GLuint fbo = 0, fbColor = 0, fbDepth = 0;
+    int    fbWidth = 0, fbHeight = 0;
+    GLuint readback[READBACK_COUNT];
+    GLsync readFence[READBACK_COUNT];
+    int    readWidth[READBACK_COUNT], readHeight[READBACK_COUNT];
+    unsigned int frame = 0;
+    unsigned int changedFrame = 0;
+    glm::mat4 lastProject, lastView;
+
+    // Residency (GL thread)
+    std::vector<std::vector<int> > slotOf;      // per level, per tile: cache slot or -1
+    std::vector<uint32_t> slotPage;             // per slot: page id, or ~0u when free
+    std::vector<unsigned int> slotUsed;         // per slot: last frame it was wanted
+    std::vector<std::vector<uint32_t> > table;  // per level: packed page table texels
+    std::vector<std::vector<unsigned char> > queued;    // per level, per tile: sent to the worker
+    int inFlight = 0;
+    std::vector<uint32_t> wanted;
+    std::vector<Loaded> batch;                  // uploadLoaded's, reused every frame
+    bool tableDirty = true;
+    VTStats stat;
+
+    // Worker
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::deque<uint32_t> queue;
+    std::deque<Loaded> loaded;
+    bool stopping = false;
+};
@@ -4,23 +4,141 @@ in  vec4 vPosition;
 in  vec4 vNormal;
 in  vec4 vColor;
 in  vec2 vTexCoord;
+in  float vBone;            // body mesh: the vertex's bone (ManPart)
+in  float vSkinLayer;       // per instance: layer in skinTextures
+in  vec3 vInstanceOffset;   // per instance: root translation (GPU animation)
+in  vec2 vInstancePhase;    // per instance: phase and cycle length, seconds
 
 out vec3 fragPos;
 out vec3 fragNormal;
 out vec4 fragColor;
 out vec2 texCoord;
+out vec4 lightSpacePos;
+flat out float skinLayer;
+flat out float fade;        // crowd mesh LOD: 1 = opaque, dithered out towards 0
 
 uniform mat4 mProject;
 uniform mat4 mView;
 uniform mat4 mModel;
+uniform mat4 mLightViewProj;
+uniform vec3 viewPos;
+
+// Crowd draws with impostors: the mesh fades out over this eye-distance band
+// (impostor_vshader.glsl fades in over the same one). (0, 0): off.
+uniform vec2 lodFade;
+
+// Skinned draws (boneCount > 0): the model matrix comes from the bone
+// palette, boneCount rigid matrices per swimmer stored as 4 RGBA32F columns
+// each. Instance i of a draw is swimmer paletteBase + i.
+uniform int boneCount;
+uniform int paletteBase;
+uniform samplerBuffer bonePalette;
+
+// GPU animation of the crowd at cycle position fract((animTime + phase) / cycle):
+//   gpuAnimation 1: bones evaluated here from the keyframe clip and rig in
+//                   AnimClip (see initClipBlock in cube.cpp)
+//   gpuAnimation 2: vertex positions and normals read from the vertex
+//                   animation texture (src/vatfile.h), column gl_VertexID
+uniform int gpuAnimation;
+uniform float animTime;
+
+uniform sampler2D vatPositions;
+uniform sampler2D vatNormals;
+uniform int vatFrames;
+uniform vec3 vatPosScale;
+uniform vec3 vatPosBias;
+uniform vec2 vatNormalDecode;   // normal = texel * x + y
+
+layout(std140) uniform AnimClip {
+    int clipSegments;
+    float clipPronePitch;
+    int clipBobChannel;
+    vec4 clipKeys[48];      // channel c, key k: clipKeys[c * 4 + k / 4][k % 4]
+    vec4 clipRig[48];       // per bone: anchor, mid, tip; w = joint channel or -1
+};
+
+float clipKey(int c, int k)
+{
+    return clipKeys[c * 4 + k / 4][k % 4];
+}
+
+// Linear keyframe interpolation, as kfLerp
+float clipChannel(int c, float t)
+{
+    float seg = t * float(clipSegments);
+    int i = int(clamp(floor(seg), 0.0, float(clipSegments - 1)));
+    return mix(clipKey(c, i), clipKey(c, i + 1), seg - float(i));
+}
+
+mat4 translation(vec3 v)
+{
+    return mat4(1.0, 0.0, 0.0, 0.0,  0.0, 1.0, 0.0, 0.0,  0.0, 0.0, 1.0, 0.0,  v, 1.0);
+}
+
+mat4 rotationX(float degrees)
+{
+    float c = cos(radians(degrees)), s = sin(radians(degrees));
+    return mat4(1.0, 0.0, 0.0, 0.0,  0.0, c, s, 0.0,  0.0, -s, c, 0.0,  0.0, 0.0, 0.0, 1.0);
+}
+
+// poseManAt for a single bone
+mat4 animBone(int bone, float t)
+{
+    mat4 m = translation(vec3(0.0, clipChannel(clipBobChannel, t), 0.0)) * rotationX(clipPronePitch);
+    vec4 anchor = clipRig[bone * 3], mid = clipRig[bone * 3 + 1], tip = clipRig[bone * 3 + 2];
+    m = m * translation(anchor.xyz);
+    if (anchor.w >= 0.0) m = m * rotationX(clipChannel(int(anchor.w), t));
+    m = m * translation(mid.xyz);
+    if (mid.w >= 0.0) m = m * rotationX(clipChannel(int(mid.w), t));
+    return m * translation(tip.xyz);
+}
 
 void main()
 {
-    vec4 worldPos = mModel * vPosition;
+    fade = lodFade.y > 0.0 ? 1.0 - smoothstep(lodFade.x, lodFade.y, distance(viewPos, vInstanceOffset)) : 1.0;
+
+    if (gpuAnimation == 2) {
+        float f = fract((animTime + vInstancePhase.x) / vInstancePhase.y) * float(vatFrames);
+        int f0 = min(int(f), vatFrames - 1);
+        int f1 = (f0 + 1) % vatFrames;
+        float u = f - float(f0);
+        vec3 p = mix(texelFetch(vatPositions, ivec2(gl_VertexID, f0), 0).xyz,
+                     texelFetch(vatPositions, ivec2(gl_VertexID, f1), 0).xyz, u);
+        vec3 n = mix(texelFetch(vatNormals, ivec2(gl_VertexID, f0), 0).xyz,
+                     texelFetch(vatNormals, ivec2(gl_VertexID, f1), 0).xyz, u);
+        vec4 worldPos = vec4(vInstanceOffset + p * vatPosScale + vatPosBias, 1.0);
+        fragPos = worldPos.xyz;
+        fragNormal = normalize(n * vatNormalDecode.x + vatNormalDecode.y);
+        fragColor = vColor;
+        texCoord = vTexCoord;
+        skinLayer = vSkinLayer;
+        lightSpacePos = mLightViewProj * worldPos;
+        gl_Position = mProject * mView * worldPos;
+        return;
+    }
+
+    mat4 model = mModel;
+    mat3 normalMat;
+    if (boneCount > 0 && gpuAnimation != 0) {
+        float t = fract((animTime + vInstancePhase.x) / vInstancePhase.y);
+        model = translation(vInstanceOffset) * animBone(int(vBone), t);
+        normalMat = mat3(model);
+    }
+    else if (boneCount > 0) {
+        int base = ((paletteBase + gl_InstanceID) * boneCount + int(vBone)) * 4;
+        model = mat4(texelFetch(bonePalette, base), texelFetch(bonePalette, base + 1),
+                     texelFetch(bonePalette, base + 2), texelFetch(bonePalette, base + 3));
+        normalMat = mat3(model);    // bones are rigid; limb sizes are baked into the mesh
+    }
+    else normalMat = mat3(transpose(inverse(mModel)));
+
+    vec4 worldPos = model * vPosition;
     fragPos = worldPos.xyz;
-    fragNormal = mat3(transpose(inverse(mModel))) * vNormal.xyz;
+    fragNormal = normalMat * vNormal.xyz;
     fragColor = vColor;
     texCoord = vTexCoord;
+    skinLayer = vSkinLayer;
+    lightSpacePos = mLightViewProj * worldPos;
 
     gl_Position = mProject * mView * worldPos;
 }
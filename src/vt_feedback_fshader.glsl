@@ -0,0 +1,25 @@
+#version 150
+
+// Virtual texture feedback: writes the tile each pixel would sample.
+// R, G: tile x/y low 8 bits, B: level, A: 0x80 | y high bits << 3 | x high bits
+
+in  vec2 texCoord;
+
+out vec4 fColor;
+
+uniform float vtTiles;          // tiles per side at level 0
+uniform float vtVirtualSize;    // texels per side at level 0
+uniform float vtMaxLevel;
+uniform float vtFeedbackBias;   // log2(feedback / screen resolution)
+
+void main()
+{
+    vec2 t = texCoord * vtVirtualSize;
+    vec2 dx = dFdx(t), dy = dFdy(t);
+    float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + vtFeedbackBias;
+    float level = floor(clamp(lod, 0.0, vtMaxLevel));
+
+    vec2 tile = floor(fract(texCoord) * vtTiles / exp2(level));
+    vec2 hi = floor(tile / 256.0);
+    fColor = vec4(tile - hi * 256.0, level, 128.0 + hi.x + hi.y * 8.0) / 255.0;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Tiled mip pyramid for virtual texturing (.vtex, little endian).
+//
+// Level 0 is width x width texels (a power of two); every level is cut into
+// tiles of tileSize x tileSize texels, each stored with `border` texels
+// duplicated from its neighbours (clamped at the image edge) so the cache
+// can filter bilinearly without seams. Tiles are RGBA8, rows bottom-up, and
+// ordered row by row within a level; the last level is a single tile.
+//
+//   VTFileHeader | level 0 tiles | level 1 tiles | ...
+
+enum { VT_FILE_VERSION = 1, VT_MAX_LEVELS = 16 };
+
+struct VTFileHeader {
+    char     magic[4];                      // "VTEX"
+    uint32_t version;                       // VT_FILE_VERSION
+    uint32_t width;                         // level 0 size, square
+    uint32_t tileSize;                      // content texels per tile side
+    uint32_t border;
+    uint32_t levelCount;
+    uint64_t levelOffset[VT_MAX_LEVELS];    // file offset of each level's first tile
+};
+
+inline uint32_t vtTilesPerSide(const VTFileHeader& h, int level)
+{
+    uint32_t t = (h.width >> level) / h.tileSize;
+    return t ? t : 1;
+}
+
+inline size_t vtTileBytes(const VTFileHeader& h)
+{
+    size_t side = h.tileSize + 2 * h.border;
+    return side * side * 4;
+}
+
+inline uint64_t vtTileOffset(const VTFileHeader& h, int level, uint32_t x, uint32_t y)
+{
+    return h.levelOffset[level] + ((uint64_t)y * vtTilesPerSide(h, level) + x) * vtTileBytes(h);
+}
+
+// Check the header against the file size. Returns false for anything malformed.
+inline bool vtValidateHeader(const VTFileHeader& h, size_t fileSize)
+{
+    if (memcmp(h.magic, "VTEX", 4) != 0 || h.version != VT_FILE_VERSION) return false;
+    if (h.tileSize < 8 || h.tileSize > 1024 || (h.tileSize & (h.tileSize - 1))) return false;
+    if (h.border > h.tileSize / 4) return false;
+    if (h.width < h.tileSize || h.width > (1u << 20) || (h.width & (h.width - 1))) return false;
+    if (h.levelCount < 1 || h.levelCount > VT_MAX_LEVELS) return false;
+    if ((h.width >> (h.levelCount - 1)) != h.tileSize) return false;
+    for (uint32_t i = 0; i < h.levelCount; i++) {
+        uint64_t tiles = (uint64_t)vtTilesPerSide(h, i) * vtTilesPerSide(h, i);
+        if (h.levelOffset[i] < sizeof(VTFileHeader) || h.levelOffset[i] > fileSize ||
+            tiles * vtTileBytes(h) > fileSize - h.levelOffset[i])
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,190 @@
+// BMP decoder benchmark and robustness check
+//
+//   bmpbench [file.bmp ...] [--size N] [--iterations N]
+//
+// Without files, synthesizes N x N images in each supported layout (24bpp
+// bottom-up with an odd width, 32bpp BGRA, 32bpp BGRX top-down, 16bpp 565
+// bitfields), checks decodeBMPPixels against a straightforward per-pixel
+// reference and reports decode throughput. Every image is then truncated
+// and byte-corrupted to make sure parseBMP rejects it or decodes it
+// without reading out of bounds (run under ASan to be thorough).
+//
+// Build from the repository root, e.g.
+//   g++ -O2 -std=c++14 -mssse3 -Isrc tools/bmpbench.cpp src/bmp.cpp src/mapped_file.cpp -o bmpbench
+//   cl /O2 /EHsc /arch:AVX /Isrc tools\bmpbench.cpp src\bmp.cpp src\mapped_file.cpp
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "bmp.h"
+#include "mapped_file.h"
+
+typedef std::vector<unsigned char> Bytes;
+
+static void put16(Bytes& b, size_t at, uint32_t v) { b[at] = (unsigned char)v; b[at + 1] = (unsigned char)(v >> 8); }
+static void put32(Bytes& b, size_t at, uint32_t v) { put16(b, at, v & 0xFFFF); put16(b, at + 2, v >> 16); }
+
+// Build a BMP with a V4 header when masks are given, BITMAPINFOHEADER otherwise
+static Bytes makeBMP(int width, int height, int bpp, const uint32_t* masks, uint32_t seed)
+{
+    const size_t header = masks ? 108 : 40;
+    const size_t stride = ((size_t)width * bpp + 31) / 32 * 4;
+    const size_t rows = (size_t)(height < 0 ? -height : height);
+    const size_t offset = 14 + header;
+    Bytes b(offset + stride * rows, 0);
+    b[0] = 'B'; b[1] = 'M';
+    put32(b, 2, (uint32_t)b.size());
+    put32(b, 10, (uint32_t)offset);
+    put32(b, 14, (uint32_t)header);
+    put32(b, 18, (uint32_t)width);
+    put32(b, 22, (uint32_t)height);
+    put16(b, 26, 1);
+    put16(b, 28, (uint32_t)bpp);
+    put32(b, 30, masks ? 3 : 0);
+    if (masks) for (int i = 0; i < 4; i++) put32(b, 54 + i * 4, masks[i]);
+    for (size_t i = offset; i < b.size(); i++) {
+        seed = seed * 1664525u + 1013904223u;
+        b[i] = (unsigned char)(seed >> 24);
+    }
+    return b;
+}
+
+// Per-pixel reference, independent of the row converters in bmp.cpp
+static unsigned char scale(uint32_t p, uint32_t mask)
+{
+    if (!mask) return 255;
+    int shift = 0;
+    while (!((mask >> shift) & 1)) shift++;
+    uint32_t max = mask >> shift;
+    return (unsigned char)(((uint64_t)((p & mask) >> shift) * 255 + max / 2) / max);
+}
+
+static void referenceDecode(const unsigned char* bytes, const BmpInfo& info, unsigned char* rgba)
+{
+    const int bpp = info.bitsPerPixel / 8;
+    for (int y = 0; y < info.height; y++) {
+        int outY = info.topDown ? info.height - 1 - y : y;
+        for (int x = 0; x < info.width; x++) {
+            const unsigned char* s = bytes + info.dataOffset + (size_t)y * info.stride + (size_t)x * bpp;
+            uint32_t p = 0;
+            for (int i = 0; i < bpp; i++) p |= (uint32_t)s[i] << (8 * i);
+            unsigned char* d = rgba + ((size_t)outY * info.width + x) * 4;
+            for (int c = 0; c < 4; c++) d[c] = scale(p, info.mask[c]);
+        }
+    }
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static bool bench(const char* name, const unsigned char* bytes, size_t size, int iterations)
+{
+    BmpInfo info;
+    const char* why = "";
+    if (!parseBMP(bytes, size, info, &why)) {
+        printf("%-28s rejected (%s)\n", name, why);
+        return false;
+    }
+    std::vector<unsigned char> fast((size_t)info.width * info.height * 4);
+    std::vector<unsigned char> ref(fast.size());
+
+    referenceDecode(bytes, info, &ref[0]);
+    decodeBMPPixels(bytes, info, &fast[0]);
+    bool match = fast == ref;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) referenceDecode(bytes, info, &ref[0]);
+    double refSec = secondsSince(t0) / iterations;
+
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) decodeBMPPixels(bytes, info, &fast[0]);
+    double sec = secondsSince(t0) / iterations;
+
+    double mpix = (double)info.width * info.height / 1e6;
+    double inMB = (double)info.stride * info.height / (1 << 20);
+    printf("%-28s %5dx%-5d %2dbpp  %7.1f MPix/s  %7.1f MB/s in  (reference %6.1f MPix/s, x%.1f)  %s\n",
+        name, info.width, info.height, info.bitsPerPixel, mpix / sec, inMB / sec,
+        mpix / refSec, refSec / sec, match ? "ok" : "MISMATCH");
+    return match;
+}
+
+// Truncations and random corruption must be rejected or decoded in bounds
+static int abuse(const Bytes& good, uint32_t seed)
+{
+    int accepted = 0;
+    std::vector<unsigned char> out;
+    for (int trial = 0; trial < 2000; trial++) {
+        Bytes b = good;
+        seed = seed * 1664525u + 1013904223u;
+        if (trial & 1) b.resize(seed % b.size());
+        else for (int k = 0; k < 4; k++) {
+            seed = seed * 1664525u + 1013904223u;
+            b[(seed >> 8) % 70] = (unsigned char)seed;    // hit the headers
+        }
+        // Exact-size copy so ASan catches any overread
+        std::unique_ptr<unsigned char[]> exact(new unsigned char[b.size() + 1]);
+        if (!b.empty()) memcpy(exact.get(), &b[0], b.size());
+        BmpInfo info;
+        if (!parseBMP(exact.get(), b.size(), info, NULL)) continue;
+        out.resize((size_t)info.width * info.height * 4);
+        decodeBMPPixels(exact.get(), info, &out[0]);
+        accepted++;
+    }
+    return accepted;
+}
+
+int main(int argc, char** argv)
+{
+    int size = 2048, iterations = 10;
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--size") && i + 1 < argc) size = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) iterations = atoi(argv[++i]);
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "usage: bmpbench [file.bmp ...] [--size N] [--iterations N]\n");
+            return EXIT_FAILURE;
+        }
+        else files.push_back(argv[i]);
+    }
+    if (size < 1) size = 1;
+    if (iterations < 1) iterations = 1;
+
+    bool ok = true;
+    for (size_t i = 0; i < files.size(); i++) {
+        MappedFile file;
+        if (!file.open(files[i])) { printf("%s: could not be opened\n", files[i]); ok = false; continue; }
+        ok &= bench(files[i], file.data(), file.size(), iterations);
+    }
+    if (!files.empty()) return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    const uint32_t bgra[4] = { 0xFF0000, 0xFF00, 0xFF, 0xFF000000u };
+    const uint32_t rgb565[4] = { 0xF800, 0x07E0, 0x001F, 0 };
+    struct Case { const char* name; int width, height, bpp; const uint32_t* masks; } cases[] = {
+        { "24bpp bottom-up, odd width", size - 1, size, 24, NULL },
+        { "32bpp BGRA bitfields", size, size, 32, bgra },
+        { "32bpp BGRX top-down", size, -size, 32, NULL },
+        { "16bpp 565 bitfields", size, size, 16, rgb565 },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const Case& c = cases[i];
+        Bytes b = makeBMP(c.width, c.height, c.bpp, c.masks, (uint32_t)i + 1);
+        ok &= bench(c.name, &b[0], b.size(), iterations);
+    }
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const Case& c = cases[i];
+        Bytes small = makeBMP(c.width < 0 ? -13 : 13, c.height < 0 ? -7 : 7, c.bpp, c.masks, 99);
+        printf("%-28s corrupted: %d/2000 accepted, none out of bounds\n", c.name, abuse(small, 7));
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
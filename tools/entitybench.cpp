@@ -0,0 +1,155 @@
+// Entity store benchmark and sanity check
+//
+//   entitybench [--swimmers N] [--iterations N]
+//
+// Times a cull-style pass (bounding sphere against six planes, per swimmer)
+// over an array of structs shaped like the old crowd list and over the
+// position column of an Archetype, plus create/destroy churn. Checks that
+// handles survive the rows moving under them and that stale handles are
+// refused.
+//
+// Build from the repository root, e.g.
+//   g++ -O2 -std=c++14 -Isrc tools/entitybench.cpp -o entitybench
+//   cl /O2 /EHsc /Isrc tools\entitybench.cpp
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include "entity_store.h"
+#include "glm/glm.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+static double msSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// Best-of-N wall time of fn, in milliseconds
+template<class Fn>
+static double timeBest(int iterations, Fn fn)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; i++) {
+        Clock::time_point t0 = Clock::now();
+        fn();
+        double ms = msSince(t0);
+        if (ms < best) best = ms;
+    }
+    return best;
+}
+
+// The crowd list before the entity store, padded out to what a swimmer
+// record grows to once it carries more state than the draw needs
+struct SwimmerRecord {
+    glm::vec3 offset;
+    float skinLayer;
+    float phase, cycle;
+    glm::mat4 lastRoot;
+};
+
+struct Root { glm::vec3 position; };
+struct Anim { float phase, cycle; };
+struct Look { float skinLayer; };
+struct Cached { glm::mat4 lastRoot; };
+
+template<class GetPosition>
+static int cullPass(int n, const glm::vec4 planes[6], GetPosition position, unsigned char* out)
+{
+    int visible = 0;
+    for (int i = 0; i < n; i++) {
+        const glm::vec3 c = position(i);
+        bool in = true;
+        for (int p = 0; p < 6 && in; p++) in = glm::dot(glm::vec3(planes[p]), c) + planes[p].w >= -1.0f;
+        out[i] = in;
+        visible += in;
+    }
+    return visible;
+}
+
+int main(int argc, char** argv)
+{
+    int swimmers = 200000, iterations = 10;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--swimmers") && i + 1 < argc) swimmers = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) iterations = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: entitybench [--swimmers N] [--iterations N]\n");
+            return 1;
+        }
+    }
+    if (swimmers < 2) swimmers = 2;
+    if (iterations < 1) iterations = 1;
+
+    std::vector<SwimmerRecord> records(swimmers);
+    Archetype<Root, Anim, Look, Cached> store;
+    store.reserve(swimmers);
+    std::vector<EntityHandle> handles;
+    for (int i = 0; i < swimmers; i++) {
+        const int lane = i % 3, row = i / 3;
+        SwimmerRecord& r = records[i];
+        r.offset = glm::vec3(-1.3f * (lane + 1), 0.0f, -2.5f * row + 0.5f * lane);
+        r.skinLayer = (float)(i % 8);
+        r.phase = fmodf(i * 0.618034f, 1.0f) * 2.0f;
+        r.cycle = 2.0f;
+        r.lastRoot = glm::mat4(1.0f);
+        handles.push_back(store.create(Root{ r.offset }, Anim{ r.phase, r.cycle }, Look{ r.skinLayer }, Cached{ r.lastRoot }));
+    }
+
+    // A box around the first third of the rows
+    const float depth = 2.5f * swimmers / 9.0f;
+    const glm::vec4 planes[6] = {
+        glm::vec4(1, 0, 0, 10), glm::vec4(-1, 0, 0, 10), glm::vec4(0, 1, 0, 5),
+        glm::vec4(0, -1, 0, 5), glm::vec4(0, 0, 1, depth), glm::vec4(0, 0, -1, 1),
+    };
+    std::vector<unsigned char> aosOut(swimmers), soaOut(swimmers);
+    int aosVisible = 0, soaVisible = 0;
+    double aos = timeBest(iterations, [&]() {
+        aosVisible = cullPass(swimmers, planes, [&](int i) { return records[i].offset; }, aosOut.data());
+    });
+    double soa = timeBest(iterations, [&]() {
+        const Root* root = store.column<Root>();
+        soaVisible = cullPass(swimmers, planes, [root](int i) { return root[i].position; }, soaOut.data());
+    });
+    bool ok = aosVisible == soaVisible && aosOut == soaOut;
+    printf("Cull pass over %d swimmers, best of %d:\n", swimmers, iterations);
+    printf("  array of %zu-byte structs  %8.3f ms\n", sizeof(SwimmerRecord), aos);
+    printf("  position column           %8.3f ms  (%.1fx)\n", soa, aos / soa);
+    printf("  %d visible in both: %s\n", soaVisible, ok ? "ok" : "MISMATCH");
+
+    // Churn: destroy every other swimmer, then create as many again
+    Clock::time_point t0 = Clock::now();
+    const int half = swimmers / 2;
+    for (int i = 0; i < swimmers; i += 2) ok = store.destroy(handles[i]) && ok;
+    const double destroyMs = msSince(t0);
+    t0 = Clock::now();
+    std::vector<EntityHandle> fresh;
+    for (int i = 0; i < half; i++) fresh.push_back(store.create(Root{ glm::vec3((float)i) }, Anim{ 0, 1 }, Look{ 0 }, Cached{ glm::mat4(1.0f) }));
+    const double createMs = msSince(t0);
+    printf("\nDestroy %d: %.3f ms (%.0f ns each), create %d: %.3f ms (%.0f ns each)\n",
+           (swimmers + 1) / 2, destroyMs, destroyMs * 1e6 / ((swimmers + 1) / 2), half, createMs, createMs * 1e6 / half);
+
+    // Survivors kept their data through the moves; the destroyed are refused
+    int moved = 0, lost = 0, stale = 0;
+    for (int i = 0; i < swimmers; i++) {
+        if (i % 2 == 0) {
+            stale += !store.alive(handles[i]) && !store.destroy(handles[i]);
+            continue;
+        }
+        if (!store.alive(handles[i]) || store.get<Root>(handles[i]).position != records[i].offset) lost++;
+        else moved += store.row(handles[i]) != (size_t)i;
+    }
+    for (int i = 0; i < half; i++)
+        if (!store.alive(fresh[i]) || store.get<Root>(fresh[i]).position != glm::vec3((float)i)) lost++;
+    ok = ok && lost == 0 && stale == (swimmers + 1) / 2 && store.size() == (size_t)(swimmers / 2 + half);
+    printf("Handles: %d survivors moved rows, %d lost, %d stale refused, %zu alive: %s\n",
+           moved, lost, stale, store.size(), ok ? "ok" : "FAILED");
+
+    return ok ? 0 : 1;
+}
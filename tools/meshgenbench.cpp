@@ -0,0 +1,233 @@
+// Mesh generator benchmark and sanity check
+//
+//   meshgenbench [--threads N] [--iterations N]
+//
+// Times genUVSphere against the Sphere class it replaced (kept below as
+// LegacySphere) at a range of tessellations, then runs every generator once and checks the output:
+// indices in range, unit normals, triangles wound counter-clockwise seen
+// from outside, and vectors sized exactly (no slack from growth). Also
+// reports sincosArray's worst error against the C library and the size of
+// the quantized streams.
+//
+// Build from the repository root, e.g.
+//   g++ -O2 -std=c++14 -Isrc tools/meshgenbench.cpp src/mesh_gen.cpp -lpthread -o meshgenbench
+//   cl /O2 /EHsc /Isrc tools\meshgenbench.cpp src\mesh_gen.cpp
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include "mesh_gen.h"
+
+typedef std::chrono::steady_clock Clock;
+
+// ---------- Baseline: the old src/sphere.cpp Sphere class ----------
+static const float kLegacyPi = 3.14159265358979f;
+
+class LegacySphere {
+public:
+    std::vector<glm::vec4> verts;
+    std::vector<glm::vec4> normals;
+    std::vector<glm::vec2> texCoords;
+
+    int nLongitude = 0;
+    int nLatitude = 0;
+
+    LegacySphere(int nLongi, int nLati) { makeUV(nLongi, nLati); computeNormals(); }
+
+private:
+    void makeUV(int nLongi, int nLati);
+    void computeNormals();
+};
+
+void LegacySphere::makeUV(int nLongi, int nLati)
+{
+    float radius = 1;
+    std::vector<glm::vec4> vertList;
+    texCoords.clear();
+
+    nLongitude = nLongi;
+    nLatitude = nLati;
+
+    // make vertex list
+    for (int v = 0; v < nLati + 1; v++)
+    {
+        for (int u = 0; u < nLongi; u++)
+        {
+            float theta = 2 * kLegacyPi * u / nLongi; // longitude
+            float phi = kLegacyPi * v / nLati;        // latitude
+            float x = glm::sin(phi) * glm::cos(theta) * radius;
+            float y = glm::sin(phi) * glm::sin(theta) * radius;
+            float z = glm::cos(phi) * radius;
+            vertList.push_back(glm::vec4(x, y, z, 1));
+        }
+    }
+
+    // make triangles
+    for (int v = 0; v < nLati; v++)
+    {
+        for (int u = 0; u < nLongi; u++)
+        {
+            int u2 = (u + 1) % nLongi;
+            int v2 = v + 1;
+
+            // triangle (u, v), (u, v2), (u2, v2)
+            verts.push_back(vertList[u + v * nLongi]);      // v0
+            verts.push_back(vertList[u + v2 * nLongi]);     // v2
+            verts.push_back(vertList[u2 + v2 * nLongi]);    // v3
+            {
+                float s0 = float(u) / nLongi; float t0 = 1.0f - float(v) / nLati;
+                float s1 = float(u) / nLongi; float t1 = 1.0f - float(v2) / nLati;
+                float s2 = float(u2) / nLongi; float t2 = 1.0f - float(v2) / nLati;
+                texCoords.push_back(glm::vec2(s0, t0));
+                texCoords.push_back(glm::vec2(s1, t1));
+                texCoords.push_back(glm::vec2(s2, t2));
+            }
+
+            // triangle (u, v), (u2, v2), (u2, v)
+            verts.push_back(vertList[u + v * nLongi]);      // v0
+            verts.push_back(vertList[u2 + v2 * nLongi]);    // v3
+            verts.push_back(vertList[u2 + v * nLongi]);     // v1
+            {
+                float s0 = float(u) / nLongi; float t0 = 1.0f - float(v) / nLati;
+                float s1 = float(u2) / nLongi; float t1 = 1.0f - float(v2) / nLati;
+                float s2 = float(u2) / nLongi; float t2 = 1.0f - float(v) / nLati;
+                texCoords.push_back(glm::vec2(s0, t0));
+                texCoords.push_back(glm::vec2(s1, t1));
+                texCoords.push_back(glm::vec2(s2, t2));
+            }
+        }
+    }
+}
+
+void LegacySphere::computeNormals()
+{
+    normals.resize(verts.size());
+    for (size_t i = 0; i < verts.size(); i++)
+    {
+        glm::vec3 n = glm::normalize(glm::vec3(verts[i]));
+        normals[i] = glm::vec4(n, 0.0f);
+    }
+}
+
+// ---------- Benchmark ----------
+
+static double msSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// Best-of-N wall time of fn, in milliseconds
+template<class Fn>
+static double timeBest(int iterations, Fn fn)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; i++) {
+        Clock::time_point t0 = Clock::now();
+        fn();
+        double ms = msSince(t0);
+        if (ms < best) best = ms;
+    }
+    return best;
+}
+
+// exact: the generator knows its sizes up front, so nothing may be over-allocated
+static bool check(const char* name, const GenMesh& m, bool closed, bool exact = true)
+{
+    const size_t n = m.positions.size();
+    bool ok = n > 0 && m.normals.size() == n && m.texCoords.size() == n && m.indices.size() % 3 == 0;
+    if (exact) ok = ok && m.positions.capacity() == n && m.indices.capacity() == m.indices.size();
+
+    float worstNormal = 0.0f;
+    size_t badIndex = 0, inward = 0, degenerate = 0;
+    glm::vec3 center(0.0f);
+    for (size_t i = 0; i < n; i++) {
+        worstNormal = fmaxf(worstNormal, fabsf(glm::length(glm::vec3(m.normals[i])) - 1.0f));
+        center += glm::vec3(m.positions[i]) / (float)n;
+    }
+    for (size_t i = 0; i < m.indices.size(); i += 3) {
+        uint32_t a = m.indices[i], b = m.indices[i + 1], c = m.indices[i + 2];
+        if (a >= n || b >= n || c >= n) { badIndex++; continue; }
+        glm::vec3 pa(m.positions[a]), pb(m.positions[b]), pc(m.positions[c]);
+        glm::vec3 face = glm::cross(pb - pa, pc - pa);
+        if (glm::length(face) < 1e-12f) { degenerate++; continue; }
+        // Closed shapes: away from the centroid; open ones: along the normals
+        glm::vec3 out = closed ? (pa + pb + pc) / 3.0f - center
+                               : glm::vec3(m.normals[a] + m.normals[b] + m.normals[c]);
+        if (glm::dot(face, out) <= 0.0f) inward++;
+    }
+    ok = ok && badIndex == 0 && inward == 0 && worstNormal < 1e-5f;
+    printf("  %-14s %8zu verts %9zu tris  normal err %.1e  bad %zu  inward %zu  degenerate %zu  %s\n",
+           name, n, m.indices.size() / 3, worstNormal, badIndex, inward, degenerate, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    MeshGenOptions opt;
+    int iterations = 5;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc) opt.threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) iterations = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: meshgenbench [--threads N] [--iterations N]\n");
+            return 1;
+        }
+    }
+    if (iterations < 1) iterations = 1;
+
+    // sincos accuracy over a few turns either side of zero
+    {
+        const size_t n = 1 << 20;
+        std::vector<float> a(n), s(n), c(n);
+        for (size_t i = 0; i < n; i++) a[i] = ((float)i / n - 0.5f) * 100.0f;
+        sincosArray(a.data(), s.data(), c.data(), n);
+        double worst = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            worst = fmax(worst, fabs(s[i] - sin((double)a[i])));
+            worst = fmax(worst, fabs(c[i] - cos((double)a[i])));
+        }
+        printf("sincosArray: max abs error %.2e over [-50, 50]\n", worst);
+    }
+
+    printf("\nUV sphere, best of %d (ms):\n", iterations);
+    printf("  %-10s %12s %12s %12s %9s\n", "segments", "Sphere", "genUVSphere", "1 thread", "speedup");
+    const int sizes[] = { 40, 128, 512, 1024, 2048 };
+    for (int size : sizes) {
+        int its = size >= 1024 ? (iterations + 1) / 2 : iterations;
+        double old = timeBest(its, [&]() { LegacySphere s(size, size); });
+        GenMesh m;
+        double gen = timeBest(its, [&]() { genUVSphere(m, size, size, 1.0f, opt); });
+        MeshGenOptions single = opt;
+        single.threads = 1;
+        double one = timeBest(its, [&]() { genUVSphere(m, size, size, 1.0f, single); });
+        printf("  %-10d %12.3f %12.3f %12.3f %8.1fx\n", size, old, gen, one, old / gen);
+    }
+
+    printf("\nGenerators:\n");
+    bool ok = true;
+    { GenMesh m; genUVSphere(m, 64, 32, 1.0f, opt); ok &= check("uv sphere", m, true); }
+    { GenMesh m; genUVSphere(m, 1024, 1024, 1.0f, opt); ok &= check("uv sphere 1k", m, true); }
+    // The icosphere only learns how many seam vertices it needs at the end
+    { GenMesh m; genIcosphere(m, 5, 1.0f); ok &= check("icosphere", m, true, false); }
+    { GenMesh m; genCapsule(m, 48, 12, 0.5f, 1.0f, opt); ok &= check("capsule", m, true); }
+    { GenMesh m; genRoundedBox(m, glm::vec3(1.0f, 0.5f, 0.25f), 0.1f, 6); ok &= check("rounded box", m, true); }
+    { GenMesh m; genRoundedBox(m, glm::vec3(1.0f), 0.0f, 6); ok &= check("box", m, true); }
+    { GenMesh m; genGrid(m, 512, 256, glm::vec2(10.0f, 5.0f), opt); ok &= check("grid", m, false); }
+
+    GenMesh m;
+    QuantizedMesh q;
+    genUVSphere(m, 256, 128, 1.0f, opt);
+    quantizeMesh(m, q);
+    size_t before = m.vertexCount() * (2 * sizeof(glm::vec4) + sizeof(glm::vec2)) + m.indices.size() * 4;
+    size_t after = q.positions.size() * 2 + q.normals.size() * 4 + q.texCoords.size() * 2 +
+                   q.indices16.size() * 2 + q.indices32.size() * 4;
+    printf("\nQuantized 256x128 sphere: %zu -> %zu bytes (%.1f%%)\n", before, after, 100.0 * after / before);
+
+    return ok ? 0 : 1;
+}
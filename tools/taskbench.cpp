@@ -0,0 +1,170 @@
+// Task scheduler scaling benchmark
+//
+//   taskbench [--swimmers N] [--iterations N] [--threads N]
+//
+// Runs the crowd pipeline's CPU stages (clip sampling, then FK for every
+// swimmer, as two dependent parallel-fors) at 1, 2, 4, ... threads up to
+// --threads (default: one per core) and reports best-of time, speedup over a
+// plain loop and parallel efficiency. Every run's bones are checked against
+// the plain loop. Also measures the cost of an empty task and of a
+// parallel-for whose pieces do no work, i.e. the scheduler's own overhead.
+//
+// Build from the repository root, e.g.
+//   g++ -O2 -std=c++14 -Isrc tools/taskbench.cpp src/task_scheduler.cpp src/frame_arena.cpp src/swim_rig.cpp -lpthread -o taskbench
+//   cl /O2 /EHsc /Isrc tools\taskbench.cpp src\task_scheduler.cpp src\frame_arena.cpp src\swim_rig.cpp
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "task_scheduler.h"
+#include "swim_rig.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+static double msSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// Best-of-N wall time of fn, in milliseconds
+template<class Fn>
+static double timeBest(int iterations, Fn fn)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; i++) {
+        Clock::time_point t0 = Clock::now();
+        fn();
+        double ms = msSince(t0);
+        if (ms < best) best = ms;
+    }
+    return best;
+}
+
+// ---------- Workload: the crowd's sample and FK stages ----------
+struct Crowd {
+    std::vector<glm::vec3> offset;
+    std::vector<float> phase;
+    std::vector<float> channels;        // ANIM_CHANNEL_COUNT per swimmer
+    std::vector<glm::mat4> bones;       // PART_COUNT per swimmer
+};
+
+static void sampleRange(Crowd& c, int begin, int end, double timeSec)
+{
+    for (int i = begin; i < end; i++)
+        sampleClip(fmodf(float((timeSec + c.phase[i]) / 2.0), 1.0f), &c.channels[(size_t)i * ANIM_CHANNEL_COUNT]);
+}
+
+static void poseRange(Crowd& c, int begin, int end)
+{
+    ManPose pose;
+    for (int i = begin; i < end; i++) {
+        poseFromChannels(&c.channels[(size_t)i * ANIM_CHANNEL_COUNT], pose);
+        const glm::mat4 root = glm::translate(glm::mat4(1.0f), c.offset[i]);
+        for (int b = 0; b < PART_COUNT; b++) c.bones[(size_t)i * PART_COUNT + b] = root * pose.bone[b];
+    }
+}
+
+static void runPipeline(TaskScheduler& sched, Crowd& c, double timeSec)
+{
+    const int n = (int)c.offset.size();
+    TaskCounter done;
+    Task* sample = sched.parallelFor(0, n, 256, [&](int lo, int hi) { sampleRange(c, lo, hi, timeSec); });
+    Task* fk = sched.parallelFor(0, n, 64, [&](int lo, int hi) { poseRange(c, lo, hi); });
+    sched.depend(fk, sample);
+    sched.submit(fk, &done);
+    sched.submit(sample, &done);
+    sched.wait(done);
+}
+
+static float maxDifference(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b)
+{
+    float worst = 0.0f;
+    for (size_t i = 0; i < a.size(); i++)
+        for (int col = 0; col < 4; col++)
+            for (int row = 0; row < 4; row++) worst = fmaxf(worst, fabsf(a[i][col][row] - b[i][col][row]));
+    return worst;
+}
+
+int main(int argc, char** argv)
+{
+    int swimmers = 100000, iterations = 5, maxThreads = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--swimmers") && i + 1 < argc) swimmers = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) iterations = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) maxThreads = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: taskbench [--swimmers N] [--iterations N] [--threads N]\n");
+            return 1;
+        }
+    }
+    if (swimmers < 1) swimmers = 1;
+    if (iterations < 1) iterations = 1;
+    if (maxThreads <= 0) maxThreads = (int)std::thread::hardware_concurrency();
+    if (maxThreads <= 0) maxThreads = 1;
+
+    Crowd crowd;
+    crowd.offset.resize(swimmers);
+    crowd.phase.resize(swimmers);
+    for (int i = 0; i < swimmers; i++) {
+        crowd.offset[i] = glm::vec3(-1.3f * (i % 3 + 1), 0.0f, -2.5f * (i / 3));
+        crowd.phase[i] = fmodf(i * 0.618034f, 1.0f) * 2.0f;
+    }
+    crowd.channels.resize((size_t)swimmers * ANIM_CHANNEL_COUNT);
+    crowd.bones.resize((size_t)swimmers * PART_COUNT);
+
+    const double timeSec = 12.345;
+    double serial = timeBest(iterations, [&]() {
+        sampleRange(crowd, 0, swimmers, timeSec);
+        poseRange(crowd, 0, swimmers);
+    });
+    const std::vector<glm::mat4> reference = crowd.bones;
+
+    printf("Crowd sample + FK, %d swimmers, best of %d (plain loop %.3f ms):\n", swimmers, iterations, serial);
+    printf("  %-8s %10s %9s %11s %9s\n", "threads", "ms", "speedup", "efficiency", "max diff");
+    bool ok = true;
+    for (int threads = 1;; threads = threads * 2 < maxThreads ? threads * 2 : maxThreads) {
+        TaskScheduler sched;
+        sched.init(threads);
+        std::fill(crowd.bones.begin(), crowd.bones.end(), glm::mat4(0.0f));
+        double ms = timeBest(iterations, [&]() { runPipeline(sched, crowd, timeSec); });
+        float diff = maxDifference(crowd.bones, reference);
+        ok = ok && diff == 0.0f;
+        printf("  %-8d %10.3f %8.2fx %10.0f%% %9.1e\n", threads, ms, serial / ms, 100.0 * serial / ms / threads, diff);
+        if (threads == maxThreads) break;
+    }
+
+    // Scheduler overhead: empty tasks, and a parallel-for of empty pieces
+    {
+        TaskScheduler sched;
+        sched.init(maxThreads);
+        const int tasks = 100000;
+        std::atomic<int> ran(0);
+        double ms = timeBest(iterations, [&]() {
+            TaskCounter done;
+            for (int i = 0; i < tasks; i++) sched.submit(sched.create([&] { ran.fetch_add(1, std::memory_order_relaxed); }), &done);
+            sched.wait(done);
+        });
+        ok = ok && ran.load() == tasks * iterations;
+        printf("\n%d empty tasks on %d threads: %.3f ms (%.0f ns per task)\n", tasks, maxThreads, ms, ms * 1e6 / tasks);
+
+        std::atomic<int> covered(0);
+        ms = timeBest(iterations, [&]() {
+            sched.run(0, tasks, 1, [&](int lo, int hi) { covered.fetch_add(hi - lo, std::memory_order_relaxed); });
+        });
+        ok = ok && covered.load() == tasks * iterations;
+        printf("parallel-for over %d single-item pieces: %.3f ms (%.0f ns per piece)\n", tasks, ms, ms * 1e6 / tasks);
+    }
+
+    printf("\n%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+// Offline texture compressor: BMP -> mip chain -> BC1/BC3/BC7 DDS
+//
+//   texcompress <input.bmp> <output.dds> [--format bc1|bc3|bc7]
+//               [--preset fast|normal|best] [--filter box|kaiser]
+//               [--threads N] [--no-mips]
+//
+// Build from the repository root, e.g.
+//   g++ -O2 -std=c++14 -Isrc tools/texcompress.cpp src/bmp.cpp src/mipmap.cpp
+//       src/bcencode.cpp src/bcdecode.cpp src/dds.cpp src/mapped_file.cpp
+//       -lpthread -o texcompress
+//   cl /O2 /EHsc /Isrc tools\texcompress.cpp src\bmp.cpp src\mipmap.cpp
+//       src\bcencode.cpp src\bcdecode.cpp src\dds.cpp src\mapped_file.cpp
+//
+// Rows are written bottom-up like the BMP, so the DDS samples exactly like
+// the texture loadBMP_custom creates.
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include "bmp.h"
+#include "mipmap.h"
+#include "bc.h"
+#include "dds.h"
+
+static void usage()
+{
+    printf("usage: texcompress <input.bmp> <output.dds> [--format bc1|bc3|bc7]\n"
+           "                   [--preset fast|normal|best] [--filter box|kaiser]\n"
+           "                   [--threads N] [--no-mips]\n");
+}
+
+// PSNR over RGB, plus alpha for formats that store it
+static double psnr(const unsigned char* a, const unsigned char* b, size_t texels, int channels)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < texels; i++)
+        for (int c = 0; c < channels; c++) {
+            double d = (double)a[i * 4 + c] - (double)b[i * 4 + c];
+            sum += d * d;
+        }
+    double mse = sum / ((double)texels * channels);
+    return mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : INFINITY;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) { usage(); return EXIT_FAILURE; }
+    const char* input = argv[1];
+    const char* output = argv[2];
+
+    BCFormat format = BC_FORMAT_BC1;
+    BCQuality quality = BC_QUALITY_NORMAL;
+    MipFilter filter = MIP_FILTER_KAISER;
+    int threads = 0;
+    bool mips = true;
+    for (int i = 3; i < argc; i++) {
+        const char* v = i + 1 < argc ? argv[i + 1] : "";
+        if (!strcmp(argv[i], "--format")) {
+            i++;
+            if (!strcmp(v, "bc1")) format = BC_FORMAT_BC1;
+            else if (!strcmp(v, "bc3")) format = BC_FORMAT_BC3;
+            else if (!strcmp(v, "bc7")) format = BC_FORMAT_BC7;
+            else { usage(); return EXIT_FAILURE; }
+        }
+        else if (!strcmp(argv[i], "--preset")) {
+            i++;
+            if (!strcmp(v, "fast")) quality = BC_QUALITY_FAST;
+            else if (!strcmp(v, "normal")) quality = BC_QUALITY_NORMAL;
+            else if (!strcmp(v, "best")) quality = BC_QUALITY_BEST;
+            else { usage(); return EXIT_FAILURE; }
+        }
+        else if (!strcmp(argv[i], "--filter")) {
+            i++;
+            if (!strcmp(v, "box")) filter = MIP_FILTER_BOX;
+            else if (!strcmp(v, "kaiser")) filter = MIP_FILTER_KAISER;
+            else { usage(); return EXIT_FAILURE; }
+        }
+        else if (!strcmp(argv[i], "--threads")) { threads = atoi(v); i++; }
+        else if (!strcmp(argv[i], "--no-mips")) mips = false;
+        else { usage(); return EXIT_FAILURE; }
+    }
+
+    BmpImage image;
+    if (!readBMP(input, image)) return EXIT_FAILURE;
+
+    MipChain chain;
+    if (mips) {
+        buildMipChain(&image.rgba[0], image.width, image.height, filter, chain, threads);
+    }
+    else {
+        MipLevel L = { (int)image.width, (int)image.height, 0 };
+        chain.levels.push_back(L);
+        chain.data = image.rgba;
+    }
+    if ((int)chain.levels.size() > DDS_MAX_LEVELS) chain.levels.resize(DDS_MAX_LEVELS);
+
+    const int levelCount = (int)chain.levels.size();
+    std::vector<std::vector<unsigned char> > blocks(levelCount);
+    std::vector<const unsigned char*> levelPtrs(levelCount);
+    double seconds = 0.0, pixels = 0.0;
+    for (int i = 0; i < levelCount; i++) {
+        const MipLevel& L = chain.levels[i];
+        blocks[i].resize(bcLevelSize(format, L.width, L.height));
+        auto t0 = std::chrono::high_resolution_clock::now();
+        bcEncodeImage(format, chain.level(i), L.width, L.height, &blocks[i][0], quality, threads);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        seconds += std::chrono::duration<double>(t1 - t0).count();
+        pixels += (double)L.width * L.height;
+        levelPtrs[i] = &blocks[i][0];
+    }
+
+    if (!writeDDS(output, format, image.width, image.height, levelCount, &levelPtrs[0])) {
+        printf("Could not write %s\n", output);
+        return EXIT_FAILURE;
+    }
+
+    static const char* kFormatNames[] = { "none", "BC1", "BC3", "BC7" };
+    static const char* kPresetNames[] = { "fast", "normal", "best" };
+    const int channels = format == BC_FORMAT_BC1 ? 3 : 4;
+    printf("%s -> %s: %ux%u, %d levels, %s/%s\n", input, output,
+        image.width, image.height, levelCount, kFormatNames[format], kPresetNames[quality]);
+
+    std::vector<unsigned char> decoded;
+    for (int i = 0; i < levelCount; i++) {
+        const MipLevel& L = chain.levels[i];
+        decoded.resize(chain.levelSize(i));
+        bcDecodeImage(format, &blocks[i][0], L.width, L.height, &decoded[0]);
+        printf("  level %2d %5dx%-5d PSNR %6.2f dB\n", i, L.width, L.height,
+            psnr(chain.level(i), &decoded[0], (size_t)L.width * L.height, channels));
+    }
+    printf("encoded %.2f MPix in %.1f ms: %.2f MPix/s\n",
+        pixels * 1e-6, seconds * 1e3, seconds > 0.0 ? pixels * 1e-6 / seconds : 0.0);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,349 @@
+// Vertex animation texture baker: body.mesh -> .vat (see src/vatfile.h)
+//
+//   vatbake <body.mesh> <output.vat> [--frames N] [--format float32|float16|unorm16]
+//
+// Samples one swim cycle (src/swim_rig) at N evenly spaced frames (default
+// 32) and skins every vertex of the merged body mesh that cube writes on its
+// first run, one texture row per frame. Before writing, prints the size of
+// each storage format against its error: at the frames themselves (storage
+// precision alone) and at several points between frames, the way the shader
+// plays the clip back (blending two rows, renormalizing the normal), against
+// the exact pose. Between frames, the frame count dominates.
+//
+// Build from the repository root, e.g.
+//   g++ -O2 -std=c++14 -Isrc tools/vatbake.cpp src/swim_rig.cpp src/mapped_file.cpp -o vatbake
+//   cl /O2 /EHsc /Isrc tools\vatbake.cpp src\swim_rig.cpp src\mapped_file.cpp
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+#include "mesh_cache.h"
+#include "swim_rig.h"
+#include "vatfile.h"
+
+static const uint32_t BODY_MESH_KEY = 0x424F4402;   // as in cube.cpp
+static const char* const kFormatName[VAT_FORMAT_COUNT] = { "float32", "float16", "unorm16" };
+
+static void usage()
+{
+    fprintf(stderr, "usage: vatbake <body.mesh> <output.vat> [--frames N] [--format float32|float16|unorm16]\n");
+}
+
+// ---------- Rest pose ----------
+struct BodyVertex {
+    glm::vec3 position, normal;
+    int bone;
+};
+
+// The LOD 0 vertices of a skinned .mesh; column i of the VAT is vertex i
+static bool readBody(const char* path, std::vector<BodyVertex>& out)
+{
+    MappedFile file;
+    MeshFileHeader h;
+    if (!file.open(path) || file.size() < sizeof(h)) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return false;
+    }
+    memcpy(&h, file.data(), sizeof(h));
+    if (memcmp(h.magic, "MESH", 4) != 0 || h.version != MESH_FILE_VERSION || h.sourceKey != BODY_MESH_KEY) {
+        fprintf(stderr, "%s is not a current body mesh; run cube once to write it\n", path);
+        return false;
+    }
+    const MeshStream& ps = h.stream[MESH_POSITION];
+    const MeshStream& ns = h.stream[MESH_NORMAL];
+    const MeshStream& bs = h.stream[MESH_BONE];
+    const uint32_t n = h.lod[0].vertexCount;
+    if (h.lodCount < 1 || h.lod[0].firstVertex != 0 || n < 1 || n > VAT_MAX_VERTICES || n > h.vertexCount ||
+        ps.components != 4 || ns.components != 4 || bs.components != 1 ||
+        h.vertexOffset + h.vertexBytes > file.size()) {
+        fprintf(stderr, "%s: unexpected layout\n", path);
+        return false;
+    }
+    for (int s = 0; s < MESH_SEMANTIC_COUNT; s++)
+        if (h.stream[s].offset + (uint64_t)h.vertexCount * h.stream[s].components * 4 > h.vertexBytes) {
+            fprintf(stderr, "%s: truncated\n", path);
+            return false;
+        }
+
+    const unsigned char* v = file.data() + h.vertexOffset;
+    out.resize(n);
+    for (uint32_t i = 0; i < n; i++) {
+        float p[4], nm[4], b;
+        memcpy(p, v + ps.offset + i * 16, 16);
+        memcpy(nm, v + ns.offset + i * 16, 16);
+        memcpy(&b, v + bs.offset + i * 4, 4);
+        out[i].position = glm::vec3(p[0], p[1], p[2]);
+        out[i].normal = glm::vec3(nm[0], nm[1], nm[2]);
+        out[i].bone = (int)b;
+        if (out[i].bone < 0 || out[i].bone >= PART_COUNT) {
+            fprintf(stderr, "%s: bad bone index %d\n", path, out[i].bone);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void skin(const std::vector<BodyVertex>& body, float tCycle, glm::vec3* pos, glm::vec3* nrm)
+{
+    ManPose pose;
+    poseManAt(tCycle, pose);
+    for (size_t i = 0; i < body.size(); i++) {
+        const glm::mat4& m = pose.bone[body[i].bone];
+        pos[i] = glm::vec3(m * glm::vec4(body[i].position, 1.0f));
+        nrm[i] = glm::mat3(m) * body[i].normal;
+    }
+}
+
+// ---------- Storage ----------
+static uint16_t floatToHalf(float f)
+{
+    uint32_t x;
+    memcpy(&x, &f, 4);
+    uint32_t sign = (x >> 16) & 0x8000;
+    int32_t e = (int32_t)((x >> 23) & 0xff) - 127 + 15;
+    uint32_t m = x & 0x7fffff;
+    if (e >= 31) return (uint16_t)(sign | 0x7c00);              // overflow (no NaNs in a pose)
+    if (e <= 0) {
+        if (e < -10) return (uint16_t)sign;
+        m |= 0x800000;                                          // denormal
+        uint32_t shift = (uint32_t)(14 - e);
+        uint32_t h = m >> shift;
+        if ((m >> (shift - 1)) & 1) h++;                        // round half up
+        return (uint16_t)(sign | h);
+    }
+    uint32_t h = sign | ((uint32_t)e << 10) | (m >> 13);
+    if (m & 0x1000) h++;                                        // round half up; carries into the exponent
+    return (uint16_t)h;
+}
+
+static float halfToFloat(uint16_t h)
+{
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    uint32_t e = (h >> 10) & 0x1f, m = h & 0x3ff;
+    float f;
+    if (e == 0) f = ldexpf((float)m, -24);
+    else if (e == 31) f = INFINITY;
+    else f = ldexpf((float)(m | 0x400), (int)e - 25);
+    uint32_t x;
+    memcpy(&x, &f, 4);
+    x |= sign;
+    memcpy(&f, &x, 4);
+    return f;
+}
+
+static inline uint16_t unorm16(float v) { return (uint16_t)(glm::clamp(v, 0.0f, 1.0f) * 65535.0f + 0.5f); }
+static inline uint32_t unorm10(float v) { return (uint32_t)(glm::clamp(v, 0.0f, 1.0f) * 1023.0f + 0.5f); }
+
+// A baked clip in one format, plus its decoder (what the shader sees)
+struct VatBake {
+    uint32_t format;
+    glm::vec3 scale, bias;
+    std::vector<unsigned char> positions, normals;
+
+    glm::vec3 position(size_t texel) const
+    {
+        const unsigned char* p = &positions[texel * vatPositionTexelBytes(format)];
+        glm::vec3 v;
+        if (format == VAT_FLOAT32) memcpy(&v[0], p, 12);
+        else {
+            uint16_t q[3];
+            memcpy(q, p, 6);
+            for (int c = 0; c < 3; c++) v[c] = format == VAT_FLOAT16 ? halfToFloat(q[c]) : q[c] / 65535.0f;
+        }
+        return v * scale + bias;
+    }
+
+    glm::vec3 normal(size_t texel) const
+    {
+        const unsigned char* p = &normals[texel * vatNormalTexelBytes(format)];
+        glm::vec3 v;
+        if (format == VAT_FLOAT32) memcpy(&v[0], p, 12);
+        else if (format == VAT_FLOAT16) {
+            uint16_t q[3];
+            memcpy(q, p, 6);
+            for (int c = 0; c < 3; c++) v[c] = halfToFloat(q[c]);
+        }
+        else {
+            uint32_t q;
+            memcpy(&q, p, 4);
+            v = glm::vec3(q & 1023, (q >> 10) & 1023, (q >> 20) & 1023) / 1023.0f * 2.0f - 1.0f;
+        }
+        return v;
+    }
+};
+
+// pos/nrm: frames x vertices, row by row
+static void encode(uint32_t format, const std::vector<glm::vec3>& pos, const std::vector<glm::vec3>& nrm,
+                   VatBake& out)
+{
+    out.format = format;
+    out.scale = glm::vec3(1.0f);
+    out.bias = glm::vec3(0.0f);
+    const size_t texels = pos.size();
+    if (format == VAT_UNORM16) {
+        glm::vec3 lo(1e30f), hi(-1e30f);
+        for (size_t i = 0; i < texels; i++) {
+            lo = glm::min(lo, pos[i]);
+            hi = glm::max(hi, pos[i]);
+        }
+        out.bias = lo;
+        out.scale = glm::max(hi - lo, glm::vec3(1e-6f));
+    }
+
+    out.positions.resize(texels * vatPositionTexelBytes(format));
+    out.normals.resize(texels * vatNormalTexelBytes(format));
+    for (size_t i = 0; i < texels; i++) {
+        unsigned char* p = &out.positions[i * vatPositionTexelBytes(format)];
+        unsigned char* n = &out.normals[i * vatNormalTexelBytes(format)];
+        const glm::vec3 nn = glm::normalize(nrm[i]);
+        if (format == VAT_FLOAT32) {
+            const float pv[4] = { pos[i].x, pos[i].y, pos[i].z, 1.0f };
+            const float nv[4] = { nn.x, nn.y, nn.z, 0.0f };
+            memcpy(p, pv, 16);
+            memcpy(n, nv, 16);
+        }
+        else if (format == VAT_FLOAT16) {
+            const uint16_t pv[4] = { floatToHalf(pos[i].x), floatToHalf(pos[i].y), floatToHalf(pos[i].z), floatToHalf(1.0f) };
+            const uint16_t nv[4] = { floatToHalf(nn.x), floatToHalf(nn.y), floatToHalf(nn.z), 0 };
+            memcpy(p, pv, 8);
+            memcpy(n, nv, 8);
+        }
+        else {
+            const glm::vec3 u = (pos[i] - out.bias) / out.scale;
+            const uint16_t pv[4] = { unorm16(u.x), unorm16(u.y), unorm16(u.z), 65535 };
+            const glm::vec3 e = nn * 0.5f + 0.5f;
+            const uint32_t nv = unorm10(e.x) | (unorm10(e.y) << 10) | (unorm10(e.z) << 20);
+            memcpy(p, pv, 8);
+            memcpy(n, &nv, 4);
+        }
+    }
+}
+
+struct VatError {
+    double maxPos = 0.0, rmsPos = 0.0;      // units
+    double maxNormalDeg = 0.0;
+    double maxStoredPos = 0.0;              // at the frames themselves: storage only
+};
+
+// Play the bake back like vshader.glsl at `samples` points per frame
+// interval and compare against the exact skinned pose.
+static VatError measure(const VatBake& bake, const std::vector<BodyVertex>& body, int frames, int samples)
+{
+    const size_t n = body.size();
+    std::vector<glm::vec3> pos(n), nrm(n);
+    VatError err;
+    double sum = 0.0;
+    size_t count = 0;
+    for (int f = 0; f < frames; f++) {
+        for (int s = 0; s < samples; s++) {
+            const float u = (float)s / samples;
+            skin(body, (f + u) / frames, &pos[0], &nrm[0]);
+            const size_t row0 = (size_t)f * n, row1 = (size_t)((f + 1) % frames) * n;
+            for (size_t i = 0; i < n; i++) {
+                glm::vec3 p = glm::mix(bake.position(row0 + i), bake.position(row1 + i), u);
+                glm::vec3 m = glm::normalize(glm::mix(bake.normal(row0 + i), bake.normal(row1 + i), u));
+                double d = glm::length(p - pos[i]);
+                double cosA = glm::clamp(glm::dot(m, glm::normalize(nrm[i])), -1.0f, 1.0f);
+                err.maxPos = fmax(err.maxPos, d);
+                if (s == 0) err.maxStoredPos = fmax(err.maxStoredPos, d);
+                err.maxNormalDeg = fmax(err.maxNormalDeg, acos(cosA) * 57.29577951308232);
+                sum += d * d;
+                count++;
+            }
+        }
+    }
+    err.rmsPos = sqrt(sum / count);
+    return err;
+}
+
+static bool writeVat(const char* path, const VatBake& bake, uint32_t vertexCount, uint32_t frames)
+{
+    VATFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "VAT ", 4);
+    h.version = VAT_FILE_VERSION;
+    h.format = bake.format;
+    h.meshKey = BODY_MESH_KEY;
+    h.vertexCount = vertexCount;
+    h.frameCount = frames;
+    for (int c = 0; c < 3; c++) {
+        h.posScale[c] = bake.scale[c];
+        h.posBias[c] = bake.bias[c];
+    }
+    h.positionOffset = sizeof(h);
+    h.normalOffset = h.positionOffset + bake.positions.size();
+
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+    bool ok = fwrite(&h, sizeof(h), 1, file) == 1 &&
+              fwrite(&bake.positions[0], 1, bake.positions.size(), file) == bake.positions.size() &&
+              fwrite(&bake.normals[0], 1, bake.normals.size(), file) == bake.normals.size();
+    ok = fclose(file) == 0 && ok;
+    if (!ok) remove(path);
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        usage();
+        return 1;
+    }
+    const char* inPath = argv[1];
+    const char* outPath = argv[2];
+    int frames = 32;
+    int format = VAT_FLOAT16;
+    for (int i = 3; i < argc; i++) {
+        if (!strcmp(argv[i], "--frames") && i + 1 < argc) frames = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--format") && i + 1 < argc) {
+            ++i;
+            format = -1;
+            for (int f = 0; f < VAT_FORMAT_COUNT; f++)
+                if (!strcmp(argv[i], kFormatName[f])) format = f;
+            if (format < 0) {
+                usage();
+                return 1;
+            }
+        }
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (frames < 2 || frames > VAT_MAX_FRAMES) {
+        fprintf(stderr, "--frames must be 2..%d\n", (int)VAT_MAX_FRAMES);
+        return 1;
+    }
+
+    std::vector<BodyVertex> body;
+    if (!readBody(inPath, body)) return 1;
+    const size_t n = body.size();
+
+    std::vector<glm::vec3> pos((size_t)frames * n), nrm((size_t)frames * n);
+    for (int f = 0; f < frames; f++) skin(body, (float)f / frames, &pos[(size_t)f * n], &nrm[(size_t)f * n]);
+
+    printf("%zu vertices x %d frames\n", n, frames);
+    printf("  %-8s %10s %14s %14s %14s %14s\n", "format", "bytes", "stored err", "max pos err", "rms pos err", "max normal");
+    VatBake chosen;
+    for (int f = 0; f < VAT_FORMAT_COUNT; f++) {
+        VatBake bake;
+        encode((uint32_t)f, pos, nrm, bake);
+        VatError e = measure(bake, body, frames, 4);
+        printf("  %-8s %10zu %14.2e %14.2e %14.2e %10.3f deg%s\n", kFormatName[f],
+               sizeof(VATFileHeader) + bake.positions.size() + bake.normals.size(),
+               e.maxStoredPos, e.maxPos, e.rmsPos, e.maxNormalDeg, f == format ? "  <-" : "");
+        if (f == format) chosen = bake;
+    }
+
+    if (!writeVat(outPath, chosen, (uint32_t)n, (uint32_t)frames)) {
+        fprintf(stderr, "cannot write %s\n", outPath);
+        return 1;
+    }
+    printf("wrote %s\n", outPath);
+    return 0;
+}
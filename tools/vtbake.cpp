@@ -0,0 +1,195 @@
+// Virtual texture baker: BMP -> tiled mip pyramid (.vtex, see src/vtfile.h)
+//
+//   vtbake <input.bmp> <output.vtex> [--size N] [--tile N] [--border N]
+//
+// --size resamples the source to N x N (a power of two; default: the next
+// power of two of the larger side), which also makes it easy to produce a
+// 16k-32k test asset from earth.bmp. Levels are reduced with a 2x2 box in
+// linear light; only two levels are held in memory at a time.
+//
+// Build from the repository root, e.g.
+//   g++ -O2 -std=c++14 -Isrc tools/vtbake.cpp src/bmp.cpp src/mapped_file.cpp -o vtbake
+//   cl /O2 /EHsc /Isrc tools\vtbake.cpp src\bmp.cpp src\mapped_file.cpp
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include "bmp.h"
+#include "vtfile.h"
+
+static void usage()
+{
+    fprintf(stderr, "usage: vtbake <input.bmp> <output.vtex> [--size N] [--tile N] [--border N]\n");
+}
+
+static bool isPow2(unsigned int v) { return v && !(v & (v - 1)); }
+
+static float g_toLinear[256];
+static unsigned char g_toSRGB[4096];
+
+static void initTables()
+{
+    for (int i = 0; i < 256; i++) {
+        float c = i / 255.0f;
+        g_toLinear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+    }
+    for (int i = 0; i < 4096; i++) {
+        float c = i / 4095.0f;
+        c = c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+        g_toSRGB[i] = (unsigned char)(c * 255.0f + 0.5f);
+    }
+}
+
+// Bilinear resample to size x size (rows stay bottom-up)
+static void resample(const BmpImage& src, unsigned int size, std::vector<unsigned char>& out)
+{
+    out.resize((size_t)size * size * 4);
+    const float sx = (float)src.width / size, sy = (float)src.height / size;
+    for (unsigned int y = 0; y < size; y++) {
+        float fy = (y + 0.5f) * sy - 0.5f;
+        int y0 = fy < 0 ? 0 : (int)fy;
+        int y1 = y0 + 1 < (int)src.height ? y0 + 1 : y0;
+        float wy = fy < 0 ? 0.0f : fy - y0;
+        for (unsigned int x = 0; x < size; x++) {
+            float fx = (x + 0.5f) * sx - 0.5f;
+            int x0 = fx < 0 ? 0 : (int)fx;
+            int x1 = x0 + 1 < (int)src.width ? x0 + 1 : x0;
+            float wx = fx < 0 ? 0.0f : fx - x0;
+            const unsigned char* a = &src.rgba[((size_t)y0 * src.width + x0) * 4];
+            const unsigned char* b = &src.rgba[((size_t)y0 * src.width + x1) * 4];
+            const unsigned char* c = &src.rgba[((size_t)y1 * src.width + x0) * 4];
+            const unsigned char* d = &src.rgba[((size_t)y1 * src.width + x1) * 4];
+            unsigned char* o = &out[((size_t)y * size + x) * 4];
+            for (int k = 0; k < 4; k++) {
+                float top = a[k] + (b[k] - a[k]) * wx;
+                float bottom = c[k] + (d[k] - c[k]) * wx;
+                o[k] = (unsigned char)(top + (bottom - top) * wy + 0.5f);
+            }
+        }
+    }
+}
+
+// 2x2 box in linear light (alpha linearly)
+static void halve(const std::vector<unsigned char>& src, unsigned int size, std::vector<unsigned char>& out)
+{
+    unsigned int half = size / 2;
+    out.resize((size_t)half * half * 4);
+    for (unsigned int y = 0; y < half; y++) {
+        const unsigned char* r0 = &src[(size_t)(2 * y) * size * 4];
+        const unsigned char* r1 = r0 + (size_t)size * 4;
+        unsigned char* o = &out[(size_t)y * half * 4];
+        for (unsigned int x = 0; x < half; x++, r0 += 8, r1 += 8, o += 4) {
+            for (int k = 0; k < 3; k++) {
+                float l = (g_toLinear[r0[k]] + g_toLinear[r0[k + 4]] + g_toLinear[r1[k]] + g_toLinear[r1[k + 4]]) * 0.25f;
+                o[k] = g_toSRGB[(int)(l * 4095.0f + 0.5f)];
+            }
+            o[3] = (unsigned char)((r0[3] + r0[7] + r1[3] + r1[7] + 2) / 4);
+        }
+    }
+}
+
+static bool writeLevel(FILE* f, const std::vector<unsigned char>& img, unsigned int size,
+                       const VTFileHeader& h, std::vector<unsigned char>& tile)
+{
+    const int T = (int)h.tileSize, B = (int)h.border, side = T + 2 * B;
+    const int tiles = (int)(size / h.tileSize);
+    tile.resize(vtTileBytes(h));
+    for (int ty = 0; ty < tiles; ty++) {
+        for (int tx = 0; tx < tiles; tx++) {
+            for (int j = 0; j < side; j++) {
+                int y = ty * T - B + j;
+                y = y < 0 ? 0 : (y >= (int)size ? (int)size - 1 : y);
+                for (int i = 0; i < side; i++) {
+                    int x = tx * T - B + i;
+                    x = x < 0 ? 0 : (x >= (int)size ? (int)size - 1 : x);
+                    memcpy(&tile[((size_t)j * side + i) * 4], &img[((size_t)y * size + x) * 4], 4);
+                }
+            }
+            if (fwrite(&tile[0], 1, tile.size(), f) != tile.size()) return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) { usage(); return EXIT_FAILURE; }
+    const char* input = argv[1];
+    const char* output = argv[2];
+    unsigned int size = 0, tileSize = 128, border = 4;
+    for (int i = 3; i < argc; i++) {
+        if (!strcmp(argv[i], "--size") && i + 1 < argc) size = (unsigned int)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--tile") && i + 1 < argc) tileSize = (unsigned int)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--border") && i + 1 < argc) border = (unsigned int)atoi(argv[++i]);
+        else { usage(); return EXIT_FAILURE; }
+    }
+
+    BmpImage image;
+    if (!readBMP(input, image)) return EXIT_FAILURE;
+    if (!size) {
+        size = 1;
+        while (size < image.width || size < image.height) size <<= 1;
+    }
+    if (!isPow2(size) || !isPow2(tileSize) || size < tileSize) {
+        fprintf(stderr, "size and tile must be powers of two with size >= tile\n");
+        return EXIT_FAILURE;
+    }
+
+    VTFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "VTEX", 4);
+    h.version = VT_FILE_VERSION;
+    h.width = size;
+    h.tileSize = tileSize;
+    h.border = border;
+    h.levelCount = 1;
+    while ((size >> (h.levelCount - 1)) > tileSize) h.levelCount++;
+    uint64_t offset = sizeof(VTFileHeader);
+    for (uint32_t L = 0; L < h.levelCount; L++) {
+        h.levelOffset[L] = offset;
+        offset += (uint64_t)vtTilesPerSide(h, L) * vtTilesPerSide(h, L) * vtTileBytes(h);
+    }
+    if (h.levelCount > VT_MAX_LEVELS || !vtValidateHeader(h, (size_t)offset)) {
+        fprintf(stderr, "unsupported size/tile/border combination\n");
+        return EXIT_FAILURE;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    initTables();
+    std::vector<unsigned char> level, next, tile;
+    if (image.width == size && image.height == size) level.swap(image.rgba);
+    else resample(image, size, level);
+    image.rgba.clear();
+    image.rgba.shrink_to_fit();
+
+    FILE* f = fopen(output, "wb");
+    if (!f) { fprintf(stderr, "could not write %s\n", output); return EXIT_FAILURE; }
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    unsigned int s = size;
+    for (uint32_t L = 0; ok && L < h.levelCount; L++) {
+        ok = writeLevel(f, level, s, h, tile);
+        printf("  level %-2u %6ux%-6u %5u tiles\n", L, s, s, vtTilesPerSide(h, L) * vtTilesPerSide(h, L));
+        if (L + 1 < h.levelCount) {
+            halve(level, s, next);
+            level.swap(next);
+            s /= 2;
+        }
+    }
+    fclose(f);
+    if (!ok) {
+        remove(output);
+        fprintf(stderr, "could not write %s\n", output);
+        return EXIT_FAILURE;
+    }
+
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    printf("wrote %s: %ux%u, %u levels, %.1f MB in %.2f s\n", output, size, size, h.levelCount,
+        offset / 1048576.0, sec);
+    return EXIT_SUCCESS;
+}